@@ -126,6 +126,7 @@ int main(int argc, char *argv[]) {
 		if (!file_exists(BUILD_DIR "/dyncall/" DYNCALL_LIB)) dyncall();
 		if (!file_exists(BUILD_DIR "/libyaml/" YAML_LIB)) libyaml();
 		blc();
+		blc_profile_runtime();
 	}
 	if (TARGET & TARGET_RUNTIME) blc_runtime();
 	if (TARGET & TARGET_BLC) finalize();
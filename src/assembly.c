@@ -57,16 +57,6 @@ static void sarr_dtor(sarr_any_t *arr) {
 	sarrfree(arr);
 }
 
-static void dl_init(struct assembly *assembly) {
-	DCCallVM *vm = dcNewCallVM(4096);
-	dcMode(vm, DC_CALL_C_DEFAULT);
-	assembly->dc_vm = vm;
-}
-
-static void dl_terminate(struct assembly *assembly) {
-	dcFree(assembly->dc_vm);
-}
-
 static void parse_triple(const char *llvm_triple, struct target_triple *out_triple) {
 	bassert(out_triple);
 	char *arch, *vendor, *os, *env;
@@ -135,8 +125,34 @@ static void llvm_init(struct assembly *assembly) {
 	char     *triple     = bmalloc(triple_len);
 	target_triple_to_string(&assembly->target->triple, triple, triple_len);
 
-	char *cpu       = /*LLVMGetHostCPUName()*/ "";
-	char *features  = /*LLVMGetHostCPUFeatures()*/ "";
+	// Generic CPU is used by default, so the output is runnable on any machine of the target
+	// architecture; 'native' selects CPU and features of the host machine.
+	const char *target_cpu      = assembly->target->cpu ? assembly->target->cpu : "";
+	const char *target_features = assembly->target->cpu_features ? assembly->target->cpu_features : "";
+	char       *cpu             = NULL;
+	char       *features        = NULL;
+	if (strcmp(target_cpu, "native") == 0) {
+		char *host_cpu      = LLVMGetHostCPUName();
+		char *host_features = LLVMGetHostCPUFeatures();
+		cpu                 = strdup(host_cpu);
+		if (target_features[0]) {
+			// Explicit features override the host ones.
+			str_buf_t tmp = get_tmp_str();
+			str_buf_append_fmt(&tmp, "{s},{s}", host_features, target_features);
+			features = strdup(str_buf_to_c(tmp));
+			put_tmp_str(tmp);
+		} else {
+			features = strdup(host_features);
+		}
+		LLVMDisposeMessage(host_cpu);
+		LLVMDisposeMessage(host_features);
+	} else {
+		cpu      = strdup(target_cpu);
+		features = strdup(target_features);
+	}
+	if (cpu[0]) builder_log("CPU: %s", cpu);
+	if (features[0]) builder_log("CPU features: %s", features);
+
 	char *error_msg = NULL;
 	builder_log("Target: %s", triple);
 	LLVMTargetRef llvm_target = NULL;
@@ -165,14 +181,23 @@ static void llvm_init(struct assembly *assembly) {
 	assembly->llvm.TM            = llvm_tm;
 	assembly->llvm.TD            = llvm_td;
 	assembly->llvm.triple        = triple;
+	assembly->llvm.cpu           = cpu;
+	assembly->llvm.features      = features;
 }
 
 static void llvm_terminate(struct assembly *assembly) {
+	if (assembly->llvm.obj) LLVMDisposeMemoryBuffer(assembly->llvm.obj);
+	for (usize i = 0; i < arrlenu(assembly->llvm.obj_files); ++i) {
+		free(assembly->llvm.obj_files[i]);
+	}
+	arrfree(assembly->llvm.obj_files);
 	LLVMDisposeModule(assembly->llvm.module);
 	LLVMDisposeTargetMachine(assembly->llvm.TM);
 	LLVMDisposeTargetData(assembly->llvm.TD);
 	llvm_context_dispose(assembly->llvm.ctx);
 	bfree(assembly->llvm.triple);
+	free(assembly->llvm.cpu);
+	free(assembly->llvm.features);
 }
 
 static void native_lib_terminate(struct native_lib *lib) {
@@ -404,6 +429,7 @@ static void thread_local_init(struct assembly *assembly) {
 		mir_arenas_init(&assembly->thread_local_contexts[i].mir_arenas, i);
 		ast_arena_init(&assembly->thread_local_contexts[i].ast_arena, i);
 		arena_init(&assembly->thread_local_contexts[i].small_array, SARR_TOTAL_SIZE, 16, 2048, i, (arena_elem_dtor_t)sarr_dtor);
+		vm_init(&assembly->thread_local_contexts[i].vm, assembly, &assembly->vm_globals);
 	}
 	return_zone();
 }
@@ -416,6 +442,7 @@ static void thread_local_terminate(struct assembly *assembly) {
 		ast_arena_terminate(&assembly->thread_local_contexts[i].ast_arena);
 		arena_terminate(&assembly->thread_local_contexts[i].small_array);
 		scfree(&assembly->thread_local_contexts[i].string_cache);
+		vm_terminate(&assembly->thread_local_contexts[i].vm);
 	}
 
 	arrfree(assembly->thread_local_contexts);
@@ -437,7 +464,7 @@ struct assembly *assembly_new(const struct target *target) {
 	llvm_init(assembly);
 	arrsetcap(assembly->units, 64);
 	str_buf_setcap(&assembly->custom_linker_opt, 128);
-	vm_init(&assembly->vm, VM_STACK_SIZE);
+	vm_globals_init(&assembly->vm_globals);
 
 	thread_local_init(assembly);
 
@@ -448,7 +475,6 @@ struct assembly *assembly_new(const struct target *target) {
 	assembly->gscope = scope_create(scope_thread_local, SCOPE_GLOBAL, NULL, NULL);
 	scope_reserve(assembly->gscope, 256);
 
-	dl_init(assembly);
 	mir_init(assembly);
 
 	if (assembly->target->kind != ASSEMBLY_DOCS) {
@@ -523,6 +549,10 @@ struct assembly *assembly_new(const struct target *target) {
 
 		// Append custom linker options
 		assembly_append_linker_options(assembly, str_buf_to_c(target->default_custom_linker_opt));
+
+#if !BL_THIN_LTO_ENABLE
+		if (target->thin_lto) builder_warning("ThinLTO is not available in this build of the compiler, '--thin-lto' is ignored.");
+#endif
 	}
 
 	return assembly;
@@ -549,11 +579,10 @@ void assembly_delete(struct assembly *assembly) {
 	spl_destroy(&assembly->libs_lock);
 
 	str_buf_free(&assembly->custom_linker_opt);
-	vm_terminate(&assembly->vm);
 	llvm_terminate(assembly);
-	dl_terminate(assembly);
 	mir_terminate(assembly);
 	thread_local_terminate(assembly);
+	vm_globals_terminate(&assembly->vm_globals);
 	bfree(assembly);
 	return_zone();
 }
@@ -41,12 +41,28 @@ enum assembly_di_kind {
 	ASSEMBLY_DI_CODEVIEW = 1, // Emit MS CodeView debug info (PDB file).
 };
 
+enum assembly_di_level {
+	ASSEMBLY_DI_LEVEL_FULL        = 0, // Emit functions, variables and types.
+	ASSEMBLY_DI_LEVEL_LINE_TABLES = 1, // Emit only functions and line locations.
+};
+
 enum assert_mode {
 	ASSERT_DEFAULT         = 0,
 	ASSERT_ALWAYS_ENABLED  = 1,
 	ASSERT_ALWAYS_DISABLED = 2,
 };
 
+enum test_report_kind {
+	TEST_REPORT_JSON  = 0,
+	TEST_REPORT_JUNIT = 1,
+};
+
+enum assembly_pgo {
+	ASSEMBLY_PGO_OFF      = 0,
+	ASSEMBLY_PGO_GENERATE = 1, // Instrument the binary to write execution profile at exit.
+	ASSEMBLY_PGO_USE      = 2, // Optimize using previously collected profile.
+};
+
 enum arch {
 #define GEN_ARCH
 #define entry(X) ARCH_##X,
@@ -129,34 +145,51 @@ struct assembly_user_define {
 };
 
 // ABI sync!!! Keep this updated with target representation in build.bl.
-#define TARGET_COPYABLE_CONTENT                        \
-	enum assembly_kind    kind;                        \
-	enum assembly_opt     opt;                         \
-	enum assembly_di_kind di;                          \
-	bool                  reg_split;                   \
-	bool                  verify_llvm;                 \
-	bool                  run_tests;                   \
-	bool                  tests_minimal_output;        \
-	bool                  no_api;                      \
-	bool                  copy_deps;                   \
-	bool                  run;                         \
-	bool                  print_tokens;                \
-	bool                  print_ast;                   \
-	bool                  print_scopes;                \
-	enum scope_dump_mode  print_scopes_mode;           \
-	bool                  emit_llvm;                   \
-	bool                  emit_mir;                    \
-	bool                  emit_asm;                    \
-	bool                  no_bin;                      \
-	bool                  no_llvm;                     \
-	bool                  no_analyze;                  \
-	bool                  x64;                         \
-	enum assert_mode      assert_mode;                 \
-	bool                  syntax_only;                 \
-	bool                  vmdbg_enabled;               \
-	s32                   vmdbg_break_on;              \
-	bool                  enable_experimental_targets; \
-	struct target_triple  triple;
+#define TARGET_COPYABLE_CONTENT                         \
+	enum assembly_kind     kind;                        \
+	enum assembly_opt      opt;                         \
+	enum assembly_di_kind  di;                          \
+	enum assembly_di_level di_level;                    \
+	bool                   reg_split;                   \
+	bool                   verify_llvm;                 \
+	bool                   run_tests;                   \
+	bool                   tests_minimal_output;        \
+	bool                   tests_parallel;              \
+	s32                    tests_shard_index;           \
+	s32                    tests_shard_count;           \
+	char                  *tests_filter;                \
+	char                  *tests_report;                \
+	enum test_report_kind  tests_report_format;         \
+	bool                   no_api;                      \
+	bool                   copy_deps;                   \
+	bool                   run;                         \
+	bool                   print_tokens;                \
+	bool                   print_ast;                   \
+	bool                   print_scopes;                \
+	enum scope_dump_mode   print_scopes_mode;           \
+	bool                   emit_llvm;                   \
+	bool                   emit_mir;                    \
+	bool                   emit_asm;                    \
+	bool                   no_bin;                      \
+	bool                   emit_obj;                    \
+	bool                   fast_link;                   \
+	char                  *obj_cache_dir;               \
+	bool                   thin_lto;                    \
+	char                  *lto_cache_dir;               \
+	char                  *cpu;                         \
+	char                  *cpu_features;                \
+	enum assembly_pgo      pgo;                         \
+	char                  *pgo_profile;                 \
+	bool                   no_llvm;                     \
+	bool                   no_analyze;                  \
+	bool                   x64;                         \
+	enum assert_mode       assert_mode;                 \
+	bool                   syntax_only;                 \
+	bool                   vmdbg_enabled;               \
+	s32                    vmdbg_break_on;              \
+	char                  *vm_profile;                  \
+	bool                   enable_experimental_targets; \
+	struct target_triple   triple;
 
 struct target {
 	// Copyable content of target can be duplicated from default target, the default target is
@@ -188,6 +221,7 @@ struct assembly_thread_local_context {
 	struct arena              small_array;
 	struct arena              ast_arena;
 	struct string_cache      *string_cache;
+	struct virtual_machine    vm;
 };
 
 struct assembly {
@@ -212,6 +246,13 @@ struct assembly {
 		LLVMTargetDataRef    TD;
 		LLVMTargetMachineRef TM;
 		char                *triple;
+		// Resolved target CPU name and feature string used by the target machine (may be empty).
+		char *cpu;
+		char *features;
+		// Object file emitted into memory, passed directly to the linker (optional).
+		LLVMMemoryBufferRef obj;
+		// Object files of module partitions when the object cache is used (optional).
+		array(char *) obj_files;
 	} llvm;
 
 	struct {
@@ -243,15 +284,22 @@ struct assembly {
 		batomic_s32 llvm_ms;
 		batomic_s32 llvm_obj_ms;
 		batomic_s32 linking_ms;
+		batomic_s32 linker_ms; // Time spent in the linker itself (including process startup for external linker).
+		batomic_s32 linker_in_process;
+		batomic_s32 obj_cache_partitions;
+		batomic_s32 obj_cache_hits;
 		batomic_s32 polymorph_ms;
 
 		batomic_s32 polymorph_count; // @Incomplete: rename to generated.
 		batomic_s32 comptime_call_stacks_count;
+		batomic_s32 comptime_call_cache_hits;
+		batomic_s32 mir_opt_removed_blocks;
+		batomic_s32 mir_opt_removed_instrs;
+		batomic_s32 rtti_bytes; // Size of emitted type info data (before dead globals are removed by LLVM).
 	} stats;
 
-	// DynCall/Lib data used for external method execution in compile time
-	DCCallVM              *dc_vm;
-	struct virtual_machine vm;
+	// Data shared by all per-worker virtual machines (see assembly_get_vm).
+	struct vm_globals vm_globals;
 
 	// Provide information whether application run in compile time or not.
 	struct mir_var *is_comptime_run;
@@ -322,6 +370,11 @@ DCpointer        assembly_find_extern(struct assembly *assembly, const str_t sym
 // Print the top-level scope structure as dot graph.
 void assembly_dump_scope_structure(struct assembly *assembly, FILE *stream, enum scope_dump_mode mode);
 
+// Get virtual machine instance of the current worker thread.
+static inline struct virtual_machine *assembly_get_vm(struct assembly *assembly) {
+	return &assembly->thread_local_contexts[get_worker_index()].vm;
+}
+
 // Convert opt level to string.
 static inline const char *opt_to_str(enum assembly_opt opt) {
 	switch (opt) {
@@ -351,6 +404,21 @@ static inline LLVMCodeGenOptLevel opt_to_LLVM(enum assembly_opt opt) {
 	babort("Invalid build mode");
 }
 
+// ThinLTO is used only for release builds and only when the compiler is built with LLVM LTO library.
+static inline bool use_thin_lto(const struct target *target) {
+#if BL_THIN_LTO_ENABLE
+	return target->thin_lto && target->opt != ASSEMBLY_OPT_DEBUG;
+#else
+	(void)target;
+	return false;
+#endif
+}
+
+// Profile guided optimization is used only for release builds.
+static inline bool use_pgo(const struct target *target) {
+	return target->pgo != ASSEMBLY_PGO_OFF && target->opt != ASSEMBLY_OPT_DEBUG;
+}
+
 static inline str_t opt_to_LLVM_pass_str(enum assembly_opt opt) {
 	switch (opt) {
 	case ASSEMBLY_OPT_DEBUG:
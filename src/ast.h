@@ -20,8 +20,8 @@ enum ast_kind {
 };
 
 enum ast_flags {
-	FLAG_EXTERN = 1 << 0, // methods marked as extern
-	// 1 << 1, free
+	FLAG_EXTERN   = 1 << 0, // methods marked as extern
+	FLAG_SERIAL   = 1 << 1, // test function must not be executed in parallel
 	FLAG_COMPILER = 1 << 2, // compiler internal
 	// 1 << 3, free
 	FLAG_INLINE       = 1 << 4,  // inline function
@@ -37,6 +37,8 @@ enum ast_flags {
 	FLAG_COMPTIME     = 1 << 14, // compile-time execution
 	FLAG_MAYBE_UNUSED = 1 << 15, // to markup unused declarations
 	FLAG_OBSOLETE     = 1 << 16, // obsolete functions
+	FLAG_HOT          = 1 << 17, // frequently executed function
+	FLAG_COLD         = 1 << 18, // rarely executed function
 };
 
 enum binop_kind {
@@ -69,6 +71,13 @@ enum unop_kind {
 	UNOP_BIT_NOT,
 };
 
+// Expected result of the if statement condition.
+enum branch_hint {
+	BRANCH_HINT_NONE = 0,
+	BRANCH_HINT_LIKELY,
+	BRANCH_HINT_UNLIKELY,
+};
+
 struct ast_docs {
 	str_t text;
 };
@@ -137,11 +146,12 @@ struct ast_stmt_defer {
 };
 
 struct ast_stmt_if {
-	struct ast *test;
-	struct ast *true_stmt;
-	struct ast *false_stmt;
-	bool        is_static;
-	bool        is_expression; // ternary
+	struct ast      *test;
+	struct ast      *true_stmt;
+	struct ast      *false_stmt;
+	bool             is_static;
+	bool             is_expression; // ternary
+	enum branch_hint hint;
 };
 
 struct ast_stmt_switch {
@@ -297,6 +307,7 @@ struct ast_expr_lit_fn {
 	struct ast *block;
 	struct ast *obsolete_warning_message; // Optional
 	struct ast *enable_if;
+	struct ast *target_clones; // Optional
 };
 
 struct ast_expr_lit_fn_group {
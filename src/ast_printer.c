@@ -31,6 +31,7 @@ static inline void print_flags(u32 flags, FILE *stream) {
 	if (!flags) return;
 	if (isflag(flags, FLAG_EXTERN)) fprintf(stream, " #extern");
 	if (isflag(flags, FLAG_TEST_FN)) fprintf(stream, " #test");
+	if (isflag(flags, FLAG_SERIAL)) fprintf(stream, " #serial");
 	if (isflag(flags, FLAG_COMPILER)) fprintf(stream, " #compiler");
 }
 
@@ -96,6 +96,7 @@ static void llvm_init(void) {
 	LLVMInitializeX86TargetInfo();
 	LLVMInitializeX86TargetMC();
 	LLVMInitializeX86AsmPrinter();
+	LLVMInitializeX86AsmParser(); // Inline assembly used by #target_clones dispatch.
 
 	LLVMInitializeAArch64Target();
 	LLVMInitializeAArch64TargetInfo();
@@ -132,7 +133,7 @@ static void tests_run(struct assembly *assembly) {
 }
 
 static void attach_dbg(struct assembly *assembly) {
-	vmdbg_attach(&assembly->vm);
+	vmdbg_attach(assembly_get_vm(assembly));
 }
 
 static void detach_dbg(struct assembly *assembly) {
@@ -168,6 +169,7 @@ static void setup_assembly_pipeline(struct assembly *assembly) {
 	arrput(*stages, &linker_run);
 	if (!t->no_analyze) {
 		arrput(*stages, &mir_analyze_run);
+		arrput(*stages, &mir_opt_run);
 		if (t->print_scopes) arrput(*stages, &print_scopes_run);
 		if (t->vmdbg_enabled) arrput(*stages, &attach_dbg);
 		if (t->run) arrput(*stages, &entry_run);
@@ -221,13 +223,19 @@ static void print_stats(struct assembly *assembly) {
 	    "  MIR Analyze:      %10.3f seconds    %3.0f%%\n"
 	    "  LLVM IR:          %10.3f seconds    %3.0f%%\n"
 	    "  LLVM Obj:         %10.3f seconds    %3.0f%%\n"
-	    "  Linking:          %10.3f seconds    %3.0f%%\n\n"
+	    "  Linking:          %10.3f seconds    %3.0f%%\n"
+	    "    Linker run:     %10.3f seconds    (%s)\n\n"
 	    "  Polymorph:        %10d generated in %.3f seconds\n\n"
 	    "  Total:            %10.3f seconds\n"
 	    "  Lines:              %8d\n"
 	    "  Speed:            %10.0f lines/second\n\n"
 	    "MISC:\n"
-	    "  Allocated stack snapshot count: %d\n",
+	    "  Allocated stack snapshot count: %d\n"
+	    "  Cached compile-time calls:      %d\n"
+	    "  Removed MIR blocks:             %d\n"
+	    "  Removed MIR instructions:       %d\n"
+	    "  Cached object partitions:       %d/%d\n"
+	    "  RTTI emitted before DCE:        %d bytes\n",
 	    assembly->target->name,
 	    SECONDS(assembly->stats.lexing_ms),
 	    PERC(assembly->stats.lexing_ms, total_ms),
@@ -243,17 +251,64 @@ static void print_stats(struct assembly *assembly) {
 	    PERC(assembly->stats.llvm_obj_ms, total_ms),
 	    SECONDS(assembly->stats.linking_ms),
 	    PERC(assembly->stats.linking_ms, total_ms),
+	    SECONDS(assembly->stats.linker_ms),
+	    assembly->stats.linker_in_process ? "in-process" : "external process",
 	    assembly->stats.polymorph_count,
 	    SECONDS(assembly->stats.polymorph_ms),
 	    SECONDS(total_ms),
 	    builder.total_lines,
 	    ((f32)builder.total_lines) / SECONDS(total_ms),
-	    assembly->stats.comptime_call_stacks_count);
+	    assembly->stats.comptime_call_stacks_count,
+	    assembly->stats.comptime_call_cache_hits,
+	    assembly->stats.mir_opt_removed_blocks,
+	    assembly->stats.mir_opt_removed_instrs,
+	    assembly->stats.obj_cache_hits,
+	    assembly->stats.obj_cache_partitions,
+	    assembly->stats.rtti_bytes);
 
 #undef SECONDS
 #undef PERC
 }
 
+static void write_vm_profile(struct assembly *assembly) {
+	zone();
+	const str_t filepath    = make_str_from_c(assembly->target->vm_profile);
+	const str_t target_name = make_str_from_c(assembly->target->name);
+
+	mtx_lock(&builder.vm_profiles_mutex);
+	// Previous profile of the same target compiled again in this process is replaced.
+	struct builder_vm_profile *profile = NULL;
+	for (usize i = 0; i < arrlenu(builder.vm_profiles); ++i) {
+		struct builder_vm_profile *it = &builder.vm_profiles[i];
+		if (str_match(str_buf_view(it->filepath), filepath) && str_match(str_buf_view(it->target_name), target_name)) {
+			profile = it;
+			break;
+		}
+	}
+	if (!profile) {
+		profile = arraddnptr(builder.vm_profiles, 1);
+		bl_zeromem(profile, sizeof(struct builder_vm_profile));
+		profile->filepath    = str_buf_dup(filepath);
+		profile->target_name = str_buf_dup(target_name);
+	}
+	str_buf_clr(&profile->folded);
+	vm_get_profile(assembly, &profile->folded);
+
+	FILE *stream = fopen(assembly->target->vm_profile, "w");
+	if (stream) {
+		for (usize i = 0; i < arrlenu(builder.vm_profiles); ++i) {
+			struct builder_vm_profile *it = &builder.vm_profiles[i];
+			if (!str_match(str_buf_view(it->filepath), filepath) || !it->folded.len) continue;
+			fwrite(it->folded.ptr, 1, it->folded.len, stream);
+		}
+		fclose(stream);
+	} else {
+		builder_error("Cannot open compile-time profile file '%s'.", assembly->target->vm_profile);
+	}
+	mtx_unlock(&builder.vm_profiles_mutex);
+	return_zone();
+}
+
 static void clear_stats(struct assembly *assembly) {
 	memset(&assembly->stats, 0, sizeof(assembly->stats));
 }
@@ -287,6 +342,8 @@ static int compile(struct assembly *assembly) {
 
 	// Compile assembly using pipeline.
 	if (state == COMPILE_OK) state = compile_assembly(assembly);
+	// Profile is written even if the compilation failed, the slow part might be the reason.
+	if (assembly->target->vm_profile) write_vm_profile(assembly);
 
 	arrfree(assembly->current_pipelines.unit);
 	assembly->current_pipelines.unit = NULL;
@@ -306,7 +363,8 @@ static int compile(struct assembly *assembly) {
 	}
 	clear_stats(assembly);
 
-	if (builder.errorc) return builder.max_error;
+	// Errors reported without error code must fail the compilation too.
+	if (builder.errorc) return MAX(builder.max_error, COMPILE_FAIL);
 	if (assembly->target->run) return builder.last_script_mode_run_status;
 	if (assembly->target->run_tests) return builder.test_failc;
 
@@ -323,8 +381,10 @@ void builder_init(struct builder_options *options) {
 
 	memset(&builder, 0, sizeof(struct builder));
 	builder.options = options;
-	builder.errorc = builder.max_error = builder.test_failc = 0;
-	builder.last_script_mode_run_status                     = 0;
+	builder.errorc                      = 0;
+	builder.max_error                   = 0;
+	builder.test_failc                  = 0;
+	builder.last_script_mode_run_status = 0;
 
 	if (!get_current_exec_dir(&builder.exec_dir)) {
 		babort("Cannot locate compiler executable path.");
@@ -338,6 +398,7 @@ void builder_init(struct builder_options *options) {
 	}
 
 	mtx_init(&builder.log_mutex, mtx_plain);
+	mtx_init(&builder.vm_profiles_mutex, mtx_plain);
 
 	init_thread_local_storage();
 	start_threads(MAX(cpu_thread_count(), 2));
@@ -350,6 +411,15 @@ void builder_terminate(void) {
 	terminate_thread_local_storage();
 
 	mtx_destroy(&builder.log_mutex);
+	mtx_destroy(&builder.vm_profiles_mutex);
+
+	for (usize i = 0; i < arrlenu(builder.vm_profiles); ++i) {
+		struct builder_vm_profile *profile = &builder.vm_profiles[i];
+		str_buf_free(&profile->filepath);
+		str_buf_free(&profile->target_name);
+		str_buf_free(&profile->folded);
+	}
+	arrfree(builder.vm_profiles);
 
 	for (usize i = 0; i < arrlenu(builder.targets); ++i) {
 		target_delete(builder.targets[i]);
@@ -539,7 +609,7 @@ void builder_vmsg(enum builder_msg_type type,
 	FILE *stream = stdout;
 	if (type == MSG_ERR || type == MSG_ERR_NOTE) {
 		stream = stderr;
-		builder.errorc++;
+		batomic_fetch_add_s32(&builder.errorc, 1);
 		builder.max_error = code > builder.max_error ? code : builder.max_error;
 	}
 
@@ -27,12 +27,19 @@ struct builder_options {
 	char *doc_out_dir;
 };
 
+// Compile-time execution profile of a single target written into the '--vm-profile' file.
+struct builder_vm_profile {
+	str_buf_t filepath;
+	str_buf_t target_name;
+	str_buf_t folded; // Folded stacks lines of the last compilation of the target.
+};
+
 struct builder {
 	struct builder_options *options;
 	const struct target    *default_target;
 	str_buf_t               exec_dir;
 	batomic_s32             total_lines;
-	s32                     errorc;
+	batomic_s32             errorc;
 	s32                     max_error;
 	s32                     test_failc;
 	s32                     last_script_mode_run_status;
@@ -41,6 +48,12 @@ struct builder {
 
 	struct assembly *current_executed_assembly;
 
+	// Multiple assemblies (e.g. build pipeline and targets compiled from it) may write into the same
+	// profile file, so profiles of all assemblies compiled in this process are kept and the file is
+	// always rewritten as whole.
+	array(struct builder_vm_profile) vm_profiles;
+	mtx_t vm_profiles_mutex;
+
 	// Used for multithreaded compiling, in case new unit is added while parsing,
 	// new job for it is submitted.
 	bool  auto_submit;
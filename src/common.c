@@ -773,6 +773,14 @@ f64 get_tick_ms(void) {
 #endif
 }
 
+u32 get_process_id(void) {
+#if BL_PLATFORM_WIN
+	return (u32)GetCurrentProcessId();
+#else
+	return (u32)getpid();
+#endif
+}
+
 s32 get_last_error(char *buf, s32 buf_len) {
 #if BL_PLATFORM_MACOS
 	const s32 error_code = errno;
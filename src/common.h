@@ -504,6 +504,7 @@ int         count_bits(u64 n);
 str_buf_t   platform_lib_name(const str_t name);
 f64         get_tick_ms(void);
 s32         get_last_error(char *buf, s32 buf_len);
+u32         get_process_id(void);
 u32         next_pow_2(u32 n);
 void        color_print(FILE *stream, s32 color, const char *format, ...);
 s32         cpu_thread_count(void);
@@ -39,6 +39,10 @@
 #define BL_CONFIG_FILE "etc/bl.yaml"
 #define BL_API_DIR     "../lib/bl/api"
 
+// Profile runtime used by '--pgo=generate' (relative to the executable directory's parent), built
+// by nob from 'src/rt/blprof.c'.
+#define PGO_RUNTIME_PATH "lib/bl/rt/blprof_x86_64_linux.o"
+
 // MULTIPLATFORM: os preload depends on target build platform and should be chosen in runtime later!
 #ifdef _WIN32
 #define BL_PLATFORM_WIN   1
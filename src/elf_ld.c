@@ -0,0 +1,1511 @@
+#include "assembly.h"
+#include "builder.h"
+#include "common.h"
+#include "conf.h"
+#include "stb_ds.h"
+#include "table.h"
+
+// Minimal built-in linker producing dynamically linked x86_64 ELF executables directly from the
+// compiler object output. It's meant to speed up edit-run cycles of debug builds, so it supports
+// only what's usually generated by the compiler: relocatable objects (the compiler output, the
+// runtime object listed in 'linker_opt_exec' and object files passed in custom linker options),
+// shared libraries linked by '#link' (already resolved by the compile-time linker) or passed as
+// '-l<name>' and a small set of x86_64 relocations. Anything else (static libraries, other linker
+// options, indirect functions, ...) makes the linker give up and the regular linker is used
+// instead.
+//
+// Output layout:
+//   R  segment: headers, .interp, .hash, .dynsym, .dynstr, .rela.dyn, .rodata, .eh_frame
+//   RX segment: .text, .plt
+//   RW segment: .tdata, .tbss, .init_array, .fini_array, .dynamic, .got, .data, .bss
+//
+// Thread local variables use the local-exec model only (TPOFF relocations), which is what the
+// compiler emits for executables; .tdata and .tbss form the PT_TLS initialization image and .tbss
+// takes no space in the RW segment.
+//
+// Imported functions are called through PLT stubs jumping via GOT; GOT entries are resolved by
+// the dynamic loader at startup (BIND_NOW), so there is no lazy binding trampoline. Imported data
+// referenced directly from non-PIC code are copied into .bss (COPY relocation). Debug sections are
+// merged and kept in the output.
+
+s32 elf_ld(struct assembly *assembly);
+
+#if BL_PLATFORM_LINUX
+
+#include <ar.h>
+#include <elf.h>
+#include <sys/stat.h>
+
+#define BASE_ADDRESS      0x400000ULL
+#define SEGMENT_ALIGNMENT 0x1000ULL
+#define PLT_ENTRY_SIZE    8
+#define COPY_ALIGNMENT    16
+#define DEFAULT_INTERP    "/lib64/ld-linux-x86-64.so.2"
+#define DEFAULT_ENTRY     "_start"
+
+enum out_section_kind {
+	OUT_INTERP,
+	OUT_HASH,
+	OUT_DYNSYM,
+	OUT_DYNSTR,
+	OUT_RELA_DYN,
+	OUT_RODATA,
+	OUT_EH_FRAME,
+	OUT_TEXT,
+	OUT_PLT,
+	OUT_TDATA,
+	OUT_TBSS,
+	OUT_INIT_ARRAY,
+	OUT_FINI_ARRAY,
+	OUT_DYNAMIC,
+	OUT_GOT,
+	OUT_DATA,
+	OUT_BSS,
+	_OUT_ALLOC_COUNT,
+};
+
+static const struct {
+	enum out_section_kind first;
+	enum out_section_kind last;
+	u32                   flags;
+} SEGMENTS[] = {
+    {OUT_INTERP, OUT_EH_FRAME, PF_R},
+    {OUT_TEXT, OUT_PLT, PF_R | PF_X},
+    {OUT_TDATA, OUT_BSS, PF_R | PF_W},
+};
+
+// PT_PHDR, PT_INTERP, 3x PT_LOAD, PT_DYNAMIC, PT_GNU_STACK and optional PT_TLS
+#define MAX_PHDR_COUNT (5 + static_arrlenu(SEGMENTS))
+
+#define LINKER_COMMENT "Linker: blc " BL_VERSION
+
+struct out_section {
+	const char *name;
+	u32         type;
+	u64         flags;
+	u64         align;
+	u64         entsize;
+	u64         addr;
+	u64         offset;
+	u64         size;
+	array(u8) bytes; // Not used for SHT_NOBITS.
+	u32 shndx;       // Index in the section header table, 0 when the section is not emitted.
+	u32 link;
+	u32 info;
+};
+
+struct input_object {
+	str_t       filepath;
+	u8         *data;
+	usize       size;
+	bool        is_owned;
+	Elf64_Shdr *shdrs;
+	u32         shnum;
+	Elf64_Sym  *syms;
+	u32         sym_num;
+	const char *strs;
+	// Output section index and offset in the output section of each input section (-1 when the
+	// section is discarded).
+	array(s32) section_map;
+	array(u64) section_offset;
+	// Global symbol index of each input symbol (-1 for local symbols).
+	array(s32) symbol_map;
+};
+
+struct shared_lib {
+	str_t soname;
+	u8   *data;
+	usize size;
+};
+
+enum symbol_kind {
+	SYMBOL_UNDEFINED,
+	SYMBOL_DEFINED,
+	SYMBOL_IMPORTED,
+};
+
+struct symbol {
+	str_t            name;
+	enum symbol_kind kind;
+	bool             is_weak;
+	bool             is_func;
+	bool             needs_copy;
+	s32              object_index;
+	u32              sym_index;
+	u64              import_size;
+	s32              got_index;
+	s32              plt_index;
+	s32              dynsym_index;
+	u32              dynstr_offset;
+	u64              copy_offset;
+	u64              address;
+};
+
+struct symbol_entry {
+	hash_t hash;
+	str_t  key;
+	s32    index;
+};
+
+struct context {
+	struct assembly *assembly;
+	array(struct input_object) objects;
+	array(struct shared_lib) libs;
+	array(struct symbol) symbols;
+	hash_table(struct symbol_entry) symbol_table;
+	array(struct out_section) sections;
+
+	array(s32) dynsym_symbols; // Global symbol index of each dynamic symbol (starting at 1).
+	array(char) dynstrs;
+	array(u32) needed_offsets;
+	u32 runpath_offset;
+	s32 got_num;
+	s32 plt_num;
+	s32 copy_num;
+	u64 copy_size;
+	// Thread local storage initialization image (PT_TLS).
+	u64 tls_addr;
+	u64 tls_size;
+	u64 tls_align;
+
+	// Options parsed from configuration.
+	array(char *) inputs;
+	array(char *) lib_filenames; // Shared library file names of '-l<name>' options.
+	char *interp;
+	char *entry;
+	bool  export_dynamic;
+	bool  expect_interp;
+	bool  expect_entry;
+	bool  has_unsupported_option;
+};
+
+#define unsupported(format, ...)                                                             \
+	{                                                                                        \
+		builder_log("Built-in linker cannot be used: " format " Using regular linker instead.", \
+		            ##__VA_ARGS__);                                                          \
+		return false;                                                                        \
+	}                                                                                        \
+	(void)0
+
+static inline bool is_section_in_range(struct input_object *obj, u64 offset, u64 size) {
+	return offset <= obj->size && size <= obj->size - offset;
+}
+
+static u32 elf_hash(const char *name) {
+	u32 h = 0;
+	while (*name) {
+		h           = (h << 4) + (u8)*name++;
+		const u32 g = h & 0xf0000000;
+		if (g) h ^= g >> 24;
+		h &= ~g;
+	}
+	return h;
+}
+
+static u8 *read_whole_file(const str_t filepath, usize *out_size) {
+	str_buf_t tmp  = get_tmp_str();
+	FILE     *file = fopen(str_to_c(&tmp, filepath), "rb");
+	put_tmp_str(tmp);
+	if (!file) return NULL;
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (size <= 0) {
+		fclose(file);
+		return NULL;
+	}
+	u8 *data = bmalloc((usize)size);
+	if (fread(data, 1, (usize)size, file) != (usize)size) {
+		bfree(data);
+		data = NULL;
+	}
+	fclose(file);
+	*out_size = (usize)size;
+	return data;
+}
+
+// =================================================================================================
+// Options
+// =================================================================================================
+static void parse_option(struct context *ctx, const char *token) {
+	if (ctx->expect_interp) {
+		ctx->interp        = strdup(token);
+		ctx->expect_interp = false;
+	} else if (ctx->expect_entry) {
+		ctx->entry        = strdup(token);
+		ctx->expect_entry = false;
+	} else if (strcmp(token, "-dynamic-linker") == 0) {
+		ctx->expect_interp = true;
+	} else if (strcmp(token, "-e") == 0) {
+		ctx->expect_entry = true;
+	} else if (strcmp(token, "--export-dynamic") == 0) {
+		ctx->export_dynamic = true;
+	} else if (token[0] != '-' && strlen(token) > 2 && strcmp(token + strlen(token) - 2, ".o") == 0) {
+		arrput(ctx->inputs, strdup(token));
+	} else if (strncmp(token, "-l", 2) == 0 && token[2] != '\0' && token[2] != ':') {
+		str_buf_t filename = get_tmp_str();
+		str_buf_append_fmt(&filename, "lib{s}.so", token + 2);
+		arrput(ctx->lib_filenames, strdup(str_buf_to_c(filename)));
+		put_tmp_str(filename);
+	} else {
+		builder_log("Built-in linker: unsupported option '%s'.", token);
+		ctx->has_unsupported_option = true;
+	}
+}
+
+static bool parse_options(struct context *ctx) {
+	struct assembly *assembly = ctx->assembly;
+	const char      *opt      = read_config(builder.config, assembly->target, "linker_opt_exec", "");
+	process_tokens(ctx, opt, " ", (process_tokens_fn_t)&parse_option);
+	// Custom options (e.g. 'append_linker_options') have to be understood by the built-in linker too.
+	if (assembly->custom_linker_opt.len) {
+		process_tokens(ctx, str_buf_to_c(assembly->custom_linker_opt), " ", (process_tokens_fn_t)&parse_option);
+	}
+	if (ctx->has_unsupported_option || ctx->expect_interp || ctx->expect_entry) {
+		unsupported("Unsupported linker options.");
+	}
+	return true;
+}
+
+// =================================================================================================
+// Inputs
+// =================================================================================================
+static bool add_object(struct context *ctx, const str_t filepath, u8 *data, usize size, bool is_owned) {
+	struct input_object obj = {
+	    .filepath = filepath,
+	    .data     = data,
+	    .size     = size,
+	    .is_owned = is_owned,
+	};
+	arrput(ctx->objects, obj);
+	struct input_object *o = &arrlast(ctx->objects);
+
+	const Elf64_Ehdr *ehdr = (Elf64_Ehdr *)data;
+	if (size < sizeof(Elf64_Ehdr) || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+	    ehdr->e_ident[EI_CLASS] != ELFCLASS64 || ehdr->e_type != ET_REL || ehdr->e_machine != EM_X86_64) {
+		unsupported("'" STR_FMT "' is not x86_64 relocatable object.", STR_ARG(filepath));
+	}
+	if (!ehdr->e_shnum || !is_section_in_range(o, ehdr->e_shoff, (u64)ehdr->e_shnum * sizeof(Elf64_Shdr))) {
+		unsupported("Invalid section headers in '" STR_FMT "'.", STR_ARG(filepath));
+	}
+	o->shdrs = (Elf64_Shdr *)(data + ehdr->e_shoff);
+	o->shnum = ehdr->e_shnum;
+	for (u32 i = 0; i < o->shnum; ++i) {
+		const Elf64_Shdr *shdr = &o->shdrs[i];
+		if (shdr->sh_type != SHT_NOBITS && !is_section_in_range(o, shdr->sh_offset, shdr->sh_size)) {
+			unsupported("Invalid section in '" STR_FMT "'.", STR_ARG(filepath));
+		}
+		if (shdr->sh_type == SHT_SYMTAB) {
+			if (shdr->sh_link >= o->shnum) unsupported("Invalid symbol table in '" STR_FMT "'.", STR_ARG(filepath));
+			o->syms    = (Elf64_Sym *)(data + shdr->sh_offset);
+			o->sym_num = (u32)(shdr->sh_size / sizeof(Elf64_Sym));
+			o->strs    = (const char *)(data + o->shdrs[shdr->sh_link].sh_offset);
+		}
+	}
+	return true;
+}
+
+static bool load_objects(struct context *ctx) {
+	struct assembly     *assembly = ctx->assembly;
+	const struct target *target   = assembly->target;
+
+	// Compiler output is taken from the object cache, memory or the output directory.
+	if (arrlenu(assembly->llvm.obj_files)) {
+		for (usize i = 0; i < arrlenu(assembly->llvm.obj_files); ++i) {
+			const str_t filepath = make_str_from_c(assembly->llvm.obj_files[i]);
+			usize       size     = 0;
+			u8         *data     = read_whole_file(filepath, &size);
+			if (!data) unsupported("Cannot read '" STR_FMT "'.", STR_ARG(filepath));
+			if (!add_object(ctx, filepath, data, size, true)) return false;
+		}
+	} else if (assembly->llvm.obj) {
+		u8         *data = (u8 *)LLVMGetBufferStart(assembly->llvm.obj);
+		const usize size = LLVMGetBufferSize(assembly->llvm.obj);
+		if (!add_object(ctx, make_str_from_c(target->name), data, size, false)) return false;
+	} else {
+		str_buf_t filepath = get_tmp_str();
+		str_buf_append_fmt(&filepath, "{str}/{s}.{s}", target->out_dir, target->name, OBJ_EXT);
+		usize size = 0;
+		u8   *data = read_whole_file(str_buf_view(filepath), &size);
+		if (!data) {
+			put_tmp_str(filepath);
+			unsupported("Cannot read object file.");
+		}
+		put_tmp_str(filepath);
+		if (!add_object(ctx, make_str_from_c(target->name), data, size, true)) return false;
+	}
+
+	for (usize i = 0; i < arrlenu(ctx->inputs); ++i) {
+		const str_t filepath = make_str_from_c(ctx->inputs[i]);
+		usize       size     = 0;
+		u8         *data     = read_whole_file(filepath, &size);
+		if (!data) unsupported("Cannot read '" STR_FMT "'.", STR_ARG(filepath));
+		if (!add_object(ctx, filepath, data, size, true)) return false;
+	}
+	return true;
+}
+
+static Elf64_Shdr *find_section_of_type(u8 *data, usize size, u32 type) {
+	const Elf64_Ehdr *ehdr = (Elf64_Ehdr *)data;
+	if (ehdr->e_shoff > size || (u64)ehdr->e_shnum * sizeof(Elf64_Shdr) > size - ehdr->e_shoff) return NULL;
+	Elf64_Shdr *shdrs = (Elf64_Shdr *)(data + ehdr->e_shoff);
+	for (u32 i = 0; i < ehdr->e_shnum; ++i) {
+		if (shdrs[i].sh_type == type && shdrs[i].sh_link < ehdr->e_shnum) return &shdrs[i];
+	}
+	return NULL;
+}
+
+static bool add_shared_lib(struct context *ctx, const str_t filepath, const str_t soname, u8 *data, usize size) {
+	struct shared_lib shared_lib = {.soname = soname, .data = data, .size = size};
+	arrput(ctx->libs, shared_lib);
+
+	const Elf64_Ehdr *ehdr = (Elf64_Ehdr *)data;
+	if (size < sizeof(Elf64_Ehdr) || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+	    ehdr->e_ident[EI_CLASS] != ELFCLASS64 || ehdr->e_type != ET_DYN || ehdr->e_machine != EM_X86_64) {
+		unsupported("'" STR_FMT "' is not x86_64 shared library.", STR_ARG(filepath));
+	}
+
+	// Use DT_SONAME when available.
+	Elf64_Shdr *dynamic = find_section_of_type(data, size, SHT_DYNAMIC);
+	if (!dynamic) return true;
+	const Elf64_Shdr *shdrs   = (Elf64_Shdr *)(data + ehdr->e_shoff);
+	const Elf64_Shdr *strtab  = &shdrs[dynamic->sh_link];
+	const Elf64_Dyn  *entries = (Elf64_Dyn *)(data + dynamic->sh_offset);
+	const usize       count   = dynamic->sh_size / sizeof(Elf64_Dyn);
+	for (usize j = 0; j < count && entries[j].d_tag != DT_NULL; ++j) {
+		if (entries[j].d_tag != DT_SONAME) continue;
+		if (entries[j].d_un.d_val >= strtab->sh_size) break;
+		const char *soname        = (const char *)(data + strtab->sh_offset + entries[j].d_un.d_val);
+		arrlast(ctx->libs).soname = make_str_from_c((char *)soname);
+	}
+	return true;
+}
+
+// Library passed as '-l<name>' is searched in the library paths the same way as the regular linker
+// does, only shared libraries are supported. Empty static archives (e.g. 'libpthread.a' kept by
+// glibc for compatibility) are skipped.
+static bool load_lib_option(struct context *ctx, const char *filename) {
+	struct assembly *assembly = ctx->assembly;
+	for (usize i = 0; i < arrlenu(assembly->lib_paths); ++i) {
+		str_buf_t filepath = get_tmp_str();
+		str_buf_append_fmt(&filepath, "{s}/{s}", assembly->lib_paths[i], filename);
+		usize size = 0;
+		u8   *data = read_whole_file(str_buf_view(filepath), &size);
+		if (data) {
+			const bool ok = add_shared_lib(ctx, str_buf_view(filepath), make_str_from_c((char *)filename), data, size);
+			put_tmp_str(filepath);
+			return ok;
+		}
+		// Replace '.so' by '.a'.
+		filepath.len -= 2;
+		str_buf_append(&filepath, cstr("a"));
+		data = read_whole_file(str_buf_view(filepath), &size);
+		put_tmp_str(filepath);
+		if (!data) continue;
+		const bool is_empty = size == SARMAG && memcmp(data, ARMAG, SARMAG) == 0;
+		bfree(data);
+		if (is_empty) return true;
+		unsupported("Static library '%s' is not supported.", filename);
+	}
+	unsupported("Library '%s' not found.", filename);
+}
+
+static bool load_shared_libs(struct context *ctx) {
+	struct assembly *assembly = ctx->assembly;
+	for (usize i = 0; i < arrlenu(assembly->libs); ++i) {
+		struct native_lib *lib = &assembly->libs[i];
+		if ((lib->flags & NATIVE_LIB_FLAG_RUNTIME) == 0) continue;
+		if (!lib->user_name.len) continue;
+
+		usize size = 0;
+		u8   *data = read_whole_file(lib->filepath, &size);
+		if (!data) unsupported("Cannot read '" STR_FMT "'.", STR_ARG(lib->filepath));
+		if (!add_shared_lib(ctx, lib->filepath, lib->filename, data, size)) return false;
+	}
+	for (usize i = 0; i < arrlenu(ctx->lib_filenames); ++i) {
+		if (!load_lib_option(ctx, ctx->lib_filenames[i])) return false;
+	}
+	return true;
+}
+
+// =================================================================================================
+// Symbols
+// =================================================================================================
+static s32 lookup_symbol(struct context *ctx, const str_t name) {
+	const hash_t hash  = strhash(name);
+	const s32    index = tbl_lookup_index_with_key(ctx->symbol_table, hash, name);
+	if (index == -1) return -1;
+	return ctx->symbol_table[index].index;
+}
+
+static s32 add_symbol(struct context *ctx, const str_t name) {
+	const s32 index = lookup_symbol(ctx, name);
+	if (index != -1) return index;
+	struct symbol sym = {
+	    .name         = name,
+	    .kind         = SYMBOL_UNDEFINED,
+	    .is_weak      = true,
+	    .object_index = -1,
+	    .got_index    = -1,
+	    .plt_index    = -1,
+	    .dynsym_index = 0,
+	};
+	struct symbol_entry entry = {
+	    .hash  = strhash(name),
+	    .key   = name,
+	    .index = (s32)arrlen(ctx->symbols),
+	};
+	arrput(ctx->symbols, sym);
+	tbl_insert(ctx->symbol_table, entry);
+	return entry.index;
+}
+
+static bool collect_symbols(struct context *ctx) {
+	for (usize oi = 0; oi < arrlenu(ctx->objects); ++oi) {
+		struct input_object *obj = &ctx->objects[oi];
+		arrsetlen(obj->symbol_map, obj->sym_num);
+		for (u32 i = 0; i < obj->sym_num; ++i) {
+			const Elf64_Sym *elf_sym = &obj->syms[i];
+			const u8         bind    = ELF64_ST_BIND(elf_sym->st_info);
+			obj->symbol_map[i]       = -1;
+			if (ELF64_ST_TYPE(elf_sym->st_info) == STT_GNU_IFUNC) unsupported("Indirect functions are not supported.");
+			if (bind == STB_LOCAL) continue;
+			if (elf_sym->st_shndx == SHN_COMMON) unsupported("Common symbols are not supported.");
+
+			const str_t    name  = make_str_from_c((char *)obj->strs + elf_sym->st_name);
+			const s32      index = add_symbol(ctx, name);
+			struct symbol *sym   = &ctx->symbols[index];
+			obj->symbol_map[i]   = index;
+			if (elf_sym->st_shndx == SHN_UNDEF) {
+				if (bind != STB_WEAK) sym->is_weak = false;
+				continue;
+			}
+			if (sym->kind == SYMBOL_DEFINED) {
+				if (bind == STB_WEAK) continue;
+				const Elf64_Sym *prev = &ctx->objects[sym->object_index].syms[sym->sym_index];
+				if (ELF64_ST_BIND(prev->st_info) != STB_WEAK) {
+					unsupported("Duplicate symbol '" STR_FMT "'.", STR_ARG(name));
+				}
+			}
+			sym->kind         = SYMBOL_DEFINED;
+			sym->object_index = (s32)oi;
+			sym->sym_index    = i;
+			sym->is_func      = ELF64_ST_TYPE(elf_sym->st_info) == STT_FUNC;
+		}
+	}
+	return true;
+}
+
+static bool resolve_imports(struct context *ctx) {
+	for (usize li = 0; li < arrlenu(ctx->libs); ++li) {
+		struct shared_lib *lib    = &ctx->libs[li];
+		Elf64_Shdr        *dynsym = find_section_of_type(lib->data, lib->size, SHT_DYNSYM);
+		if (!dynsym) continue;
+		const Elf64_Shdr *shdrs  = (Elf64_Shdr *)(lib->data + ((Elf64_Ehdr *)lib->data)->e_shoff);
+		const Elf64_Shdr *strtab = &shdrs[dynsym->sh_link];
+		const Elf64_Sym  *syms   = (Elf64_Sym *)(lib->data + dynsym->sh_offset);
+		const usize       count  = dynsym->sh_size / sizeof(Elf64_Sym);
+		for (usize i = 1; i < count; ++i) {
+			const Elf64_Sym *elf_sym = &syms[i];
+			const u8         bind    = ELF64_ST_BIND(elf_sym->st_info);
+			if (elf_sym->st_shndx == SHN_UNDEF || bind == STB_LOCAL) continue;
+			if (elf_sym->st_name >= strtab->sh_size) continue;
+			const str_t name  = make_str_from_c((char *)lib->data + strtab->sh_offset + elf_sym->st_name);
+			const s32   index = lookup_symbol(ctx, name);
+			if (index == -1) continue;
+			struct symbol *sym = &ctx->symbols[index];
+			if (sym->kind != SYMBOL_UNDEFINED) continue;
+			const u8 type = ELF64_ST_TYPE(elf_sym->st_info);
+			if (type == STT_TLS) unsupported("Thread local symbol '" STR_FMT "' import is not supported.", STR_ARG(name));
+			sym->kind        = SYMBOL_IMPORTED;
+			sym->is_func     = type == STT_FUNC || type == STT_GNU_IFUNC;
+			sym->import_size = elf_sym->st_size;
+		}
+	}
+
+	for (usize i = 0; i < arrlenu(ctx->symbols); ++i) {
+		struct symbol *sym = &ctx->symbols[i];
+		if (sym->kind != SYMBOL_UNDEFINED || sym->is_weak) continue;
+		// Let the regular linker report the error.
+		unsupported("Undefined symbol '" STR_FMT "'.", STR_ARG(sym->name));
+	}
+	return true;
+}
+
+// =================================================================================================
+// Sections
+// =================================================================================================
+static void init_sections(struct context *ctx) {
+	const struct out_section sections[_OUT_ALLOC_COUNT] = {
+	    [OUT_INTERP]     = {.name = ".interp", .type = SHT_PROGBITS, .flags = SHF_ALLOC, .align = 1},
+	    [OUT_HASH]       = {.name = ".hash", .type = SHT_HASH, .flags = SHF_ALLOC, .align = 8, .entsize = 4},
+	    [OUT_DYNSYM]     = {.name = ".dynsym", .type = SHT_DYNSYM, .flags = SHF_ALLOC, .align = 8, .entsize = sizeof(Elf64_Sym)},
+	    [OUT_DYNSTR]     = {.name = ".dynstr", .type = SHT_STRTAB, .flags = SHF_ALLOC, .align = 1},
+	    [OUT_RELA_DYN]   = {.name = ".rela.dyn", .type = SHT_RELA, .flags = SHF_ALLOC, .align = 8, .entsize = sizeof(Elf64_Rela)},
+	    [OUT_RODATA]     = {.name = ".rodata", .type = SHT_PROGBITS, .flags = SHF_ALLOC, .align = 1},
+	    [OUT_EH_FRAME]   = {.name = ".eh_frame", .type = SHT_PROGBITS, .flags = SHF_ALLOC, .align = 8},
+	    [OUT_TEXT]       = {.name = ".text", .type = SHT_PROGBITS, .flags = SHF_ALLOC | SHF_EXECINSTR, .align = 16},
+	    [OUT_PLT]        = {.name = ".plt", .type = SHT_PROGBITS, .flags = SHF_ALLOC | SHF_EXECINSTR, .align = 16, .entsize = PLT_ENTRY_SIZE},
+	    [OUT_TDATA]      = {.name = ".tdata", .type = SHT_PROGBITS, .flags = SHF_ALLOC | SHF_WRITE | SHF_TLS, .align = 1},
+	    [OUT_TBSS]       = {.name = ".tbss", .type = SHT_NOBITS, .flags = SHF_ALLOC | SHF_WRITE | SHF_TLS, .align = 1},
+	    [OUT_INIT_ARRAY] = {.name = ".init_array", .type = SHT_INIT_ARRAY, .flags = SHF_ALLOC | SHF_WRITE, .align = 8, .entsize = 8},
+	    [OUT_FINI_ARRAY] = {.name = ".fini_array", .type = SHT_FINI_ARRAY, .flags = SHF_ALLOC | SHF_WRITE, .align = 8, .entsize = 8},
+	    [OUT_DYNAMIC]    = {.name = ".dynamic", .type = SHT_DYNAMIC, .flags = SHF_ALLOC | SHF_WRITE, .align = 8, .entsize = sizeof(Elf64_Dyn)},
+	    [OUT_GOT]        = {.name = ".got", .type = SHT_PROGBITS, .flags = SHF_ALLOC | SHF_WRITE, .align = 8, .entsize = 8},
+	    [OUT_DATA]       = {.name = ".data", .type = SHT_PROGBITS, .flags = SHF_ALLOC | SHF_WRITE, .align = 1},
+	    [OUT_BSS]        = {.name = ".bss", .type = SHT_NOBITS, .flags = SHF_ALLOC | SHF_WRITE, .align = 1},
+	};
+	arrsetlen(ctx->sections, _OUT_ALLOC_COUNT);
+	memcpy(ctx->sections, sections, sizeof(sections));
+
+	// Identifies executables produced by the built-in linker.
+	struct out_section comment = {
+	    .name    = ".comment",
+	    .type    = SHT_PROGBITS,
+	    .flags   = SHF_MERGE | SHF_STRINGS,
+	    .align   = 1,
+	    .entsize = 1,
+	    .size    = sizeof(LINKER_COMMENT),
+	};
+	arrsetlen(comment.bytes, comment.size);
+	memcpy(comment.bytes, LINKER_COMMENT, comment.size);
+	arrput(ctx->sections, comment);
+}
+
+static s32 get_debug_section(struct context *ctx, const char *name, const Elf64_Shdr *shdr) {
+	for (usize i = _OUT_ALLOC_COUNT; i < arrlenu(ctx->sections); ++i) {
+		if (strcmp(ctx->sections[i].name, name) == 0) return (s32)i;
+	}
+	const struct out_section section = {
+	    .name    = name,
+	    .type    = shdr->sh_type,
+	    .flags   = shdr->sh_flags & (SHF_MERGE | SHF_STRINGS),
+	    .align   = 1,
+	    .entsize = shdr->sh_entsize,
+	};
+	arrput(ctx->sections, section);
+	return (s32)(arrlen(ctx->sections) - 1);
+}
+
+// Returns output section index of the input section or -1 in case the section is discarded.
+static s32 classify_section(struct context *ctx, const char *name, const Elf64_Shdr *shdr) {
+	if ((shdr->sh_flags & SHF_ALLOC) == 0) {
+		if (shdr->sh_type == SHT_PROGBITS && strncmp(name, ".debug_", 7) == 0) return get_debug_section(ctx, name, shdr);
+		return -1;
+	}
+	switch (shdr->sh_type) {
+	case SHT_PROGBITS:
+	case SHT_NOBITS:
+	case SHT_INIT_ARRAY:
+	case SHT_FINI_ARRAY:
+	case SHT_NOTE:
+	case SHT_X86_64_UNWIND:
+		break;
+	default:
+		return -1;
+	}
+	if (shdr->sh_type == SHT_INIT_ARRAY || strncmp(name, ".init_array", 11) == 0) return OUT_INIT_ARRAY;
+	if (shdr->sh_type == SHT_FINI_ARRAY || strncmp(name, ".fini_array", 11) == 0) return OUT_FINI_ARRAY;
+	if (shdr->sh_flags & SHF_TLS) return shdr->sh_type == SHT_NOBITS ? OUT_TBSS : OUT_TDATA;
+	if (strcmp(name, ".eh_frame") == 0) return OUT_EH_FRAME;
+	if (shdr->sh_type == SHT_NOBITS) return OUT_BSS;
+	if (shdr->sh_flags & SHF_EXECINSTR) return OUT_TEXT;
+	if (shdr->sh_flags & SHF_WRITE) return OUT_DATA;
+	return OUT_RODATA;
+}
+
+static bool map_sections(struct context *ctx) {
+	for (usize oi = 0; oi < arrlenu(ctx->objects); ++oi) {
+		struct input_object *obj     = &ctx->objects[oi];
+		const Elf64_Ehdr    *ehdr    = (Elf64_Ehdr *)obj->data;
+		const char          *shstrs  = (const char *)(obj->data + obj->shdrs[ehdr->e_shstrndx].sh_offset);
+		arrsetlen(obj->section_map, obj->shnum);
+		arrsetlen(obj->section_offset, obj->shnum);
+		for (u32 i = 0; i < obj->shnum; ++i) {
+			const Elf64_Shdr *shdr = &obj->shdrs[i];
+			obj->section_map[i]    = -1;
+			obj->section_offset[i] = 0;
+			if (i == 0) continue;
+			const s32 index = classify_section(ctx, shstrs + shdr->sh_name, shdr);
+			if (index == -1) continue;
+
+			struct out_section *section = &ctx->sections[index];
+			const u64           align   = MAX(shdr->sh_addralign, 1);
+			const u64           offset  = next_aligned2(section->size, align);
+			section->align              = MAX(section->align, align);
+			if (section->type != SHT_NOBITS) {
+				arrsetlen(section->bytes, offset);
+				memset(section->bytes + section->size, 0, offset - section->size);
+				if (shdr->sh_type == SHT_NOBITS) {
+					arrsetlen(section->bytes, offset + shdr->sh_size);
+					memset(section->bytes + offset, 0, shdr->sh_size);
+				} else {
+					arrsetlen(section->bytes, offset + shdr->sh_size);
+					memcpy(section->bytes + offset, obj->data + shdr->sh_offset, shdr->sh_size);
+				}
+			}
+			section->size          = offset + shdr->sh_size;
+			obj->section_map[i]    = index;
+			obj->section_offset[i] = offset;
+		}
+	}
+	return true;
+}
+
+static bool is_supported_relocation(u32 type) {
+	switch (type) {
+	case R_X86_64_NONE:
+	case R_X86_64_64:
+	case R_X86_64_PC32:
+	case R_X86_64_PLT32:
+	case R_X86_64_32:
+	case R_X86_64_32S:
+	case R_X86_64_PC64:
+	case R_X86_64_GOTPCREL:
+	case R_X86_64_GOTPCRELX:
+	case R_X86_64_REX_GOTPCRELX:
+	case R_X86_64_TPOFF32:
+	case R_X86_64_TPOFF64:
+	case R_X86_64_DTPOFF32:
+	case R_X86_64_DTPOFF64:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static inline bool is_got_relocation(u32 type) {
+	return type == R_X86_64_GOTPCREL || type == R_X86_64_GOTPCRELX || type == R_X86_64_REX_GOTPCRELX;
+}
+
+// Decide which symbols need GOT entries, PLT stubs or copy relocations.
+static bool scan_relocations(struct context *ctx) {
+	for (usize oi = 0; oi < arrlenu(ctx->objects); ++oi) {
+		struct input_object *obj = &ctx->objects[oi];
+		for (u32 i = 0; i < obj->shnum; ++i) {
+			const Elf64_Shdr *shdr = &obj->shdrs[i];
+			if (shdr->sh_type == SHT_REL) unsupported("REL relocations are not supported.");
+			if (shdr->sh_type != SHT_RELA) continue;
+			if (shdr->sh_info >= obj->shnum || obj->section_map[shdr->sh_info] == -1) continue;
+			const Elf64_Rela *relocs = (Elf64_Rela *)(obj->data + shdr->sh_offset);
+			const usize       count  = shdr->sh_size / sizeof(Elf64_Rela);
+			for (usize j = 0; j < count; ++j) {
+				const u32 type      = ELF64_R_TYPE(relocs[j].r_info);
+				const u32 sym_index = ELF64_R_SYM(relocs[j].r_info);
+				if (!is_supported_relocation(type)) unsupported("Relocation type %u is not supported.", type);
+				if (sym_index >= obj->sym_num) unsupported("Invalid relocation symbol.");
+				const s32 global_index = obj->symbol_map[sym_index];
+				if (global_index == -1) {
+					if (is_got_relocation(type)) unsupported("GOT relocation of local symbol is not supported.");
+					continue;
+				}
+				struct symbol *sym = &ctx->symbols[global_index];
+				if (is_got_relocation(type)) {
+					if (sym->got_index == -1) sym->got_index = ctx->got_num++;
+					continue;
+				}
+				if (sym->kind != SYMBOL_IMPORTED) continue;
+				if (sym->is_func) {
+					if (sym->got_index == -1) sym->got_index = ctx->got_num++;
+					if (sym->plt_index == -1) sym->plt_index = ctx->plt_num++;
+				} else if (!sym->needs_copy) {
+					if (!sym->import_size) unsupported("Cannot copy imported symbol '" STR_FMT "' of unknown size.", STR_ARG(sym->name));
+					sym->needs_copy = true;
+					ctx->copy_num++;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// =================================================================================================
+// Dynamic linking
+// =================================================================================================
+static u32 add_dynstr(struct context *ctx, const str_t str) {
+	const u32 offset = (u32)arrlenu(ctx->dynstrs);
+	const u32 len    = (u32)str.len;
+	arrsetlen(ctx->dynstrs, offset + len + 1);
+	memcpy(ctx->dynstrs + offset, str.ptr, len);
+	ctx->dynstrs[offset + len] = '\0';
+	return offset;
+}
+
+static void collect_dynamic_symbols(struct context *ctx) {
+	arrput(ctx->dynstrs, '\0');
+	arrput(ctx->dynsym_symbols, -1);
+
+	for (usize i = 0; i < arrlenu(ctx->libs); ++i) {
+		arrput(ctx->needed_offsets, add_dynstr(ctx, ctx->libs[i].soname));
+	}
+
+	// Non-system libraries are found by the runtime path, same as '-rpath' passed to the regular
+	// linker.
+	str_buf_t runpath = get_tmp_str();
+	for (usize i = 0; i < arrlenu(ctx->assembly->libs); ++i) {
+		struct native_lib *lib = &ctx->assembly->libs[i];
+		if ((lib->flags & NATIVE_LIB_FLAG_RUNTIME) == 0) continue;
+		if (!lib->user_name.len) continue;
+		if (lib->flags & NATIVE_LIB_IS_SYSTEM) continue;
+		if (runpath.len) str_buf_append(&runpath, cstr(":"));
+		str_buf_append(&runpath, lib->dir);
+	}
+	ctx->runpath_offset = runpath.len ? add_dynstr(ctx, str_buf_view(runpath)) : 0;
+	put_tmp_str(runpath);
+
+	u64 copy_offset = next_aligned2(ctx->sections[OUT_BSS].size, COPY_ALIGNMENT);
+	for (usize i = 0; i < arrlenu(ctx->symbols); ++i) {
+		struct symbol *sym = &ctx->symbols[i];
+		if (sym->kind == SYMBOL_UNDEFINED) continue;
+		if (sym->kind == SYMBOL_DEFINED) {
+			if (!ctx->export_dynamic) continue;
+			const Elf64_Sym *elf_sym = &ctx->objects[sym->object_index].syms[sym->sym_index];
+			if (ELF64_ST_VISIBILITY(elf_sym->st_other) != STV_DEFAULT) continue;
+		}
+		if (sym->needs_copy) {
+			sym->copy_offset = copy_offset;
+			copy_offset      = next_aligned2(copy_offset + sym->import_size, COPY_ALIGNMENT);
+		}
+		sym->dynsym_index  = (s32)arrlen(ctx->dynsym_symbols);
+		sym->dynstr_offset = add_dynstr(ctx, sym->name);
+		arrput(ctx->dynsym_symbols, (s32)i);
+	}
+	if (ctx->copy_num) {
+		ctx->copy_size                  = copy_offset - ctx->sections[OUT_BSS].size;
+		ctx->sections[OUT_BSS].size     = copy_offset;
+		ctx->sections[OUT_BSS].align    = MAX(ctx->sections[OUT_BSS].align, COPY_ALIGNMENT);
+	}
+}
+
+static usize get_dynamic_entry_count(struct context *ctx) {
+	// DT_HASH, DT_STRTAB, DT_SYMTAB, DT_STRSZ, DT_SYMENT, DT_DEBUG, DT_FLAGS, DT_FLAGS_1, DT_NULL
+	usize count = 9 + arrlenu(ctx->needed_offsets);
+	if (ctx->runpath_offset) count += 1;
+	if (ctx->got_num || ctx->copy_num) count += 3;
+	if (ctx->sections[OUT_INIT_ARRAY].size) count += 2;
+	if (ctx->sections[OUT_FINI_ARRAY].size) count += 2;
+	return count;
+}
+
+static void set_synthetic_section_sizes(struct context *ctx) {
+	const usize dynsym_num = arrlenu(ctx->dynsym_symbols);
+	const usize nbucket    = MAX(dynsym_num / 2, 1);
+	usize       rela_num   = ctx->copy_num;
+	for (usize i = 0; i < arrlenu(ctx->symbols); ++i) {
+		if (ctx->symbols[i].kind == SYMBOL_IMPORTED && ctx->symbols[i].got_index != -1) ++rela_num;
+	}
+
+	ctx->sections[OUT_INTERP].size   = strlen(ctx->interp) + 1;
+	ctx->sections[OUT_HASH].size     = (2 + nbucket + dynsym_num) * sizeof(u32);
+	ctx->sections[OUT_DYNSYM].size   = dynsym_num * sizeof(Elf64_Sym);
+	ctx->sections[OUT_DYNSTR].size   = arrlenu(ctx->dynstrs);
+	ctx->sections[OUT_RELA_DYN].size = rela_num * sizeof(Elf64_Rela);
+	ctx->sections[OUT_PLT].size      = (u64)ctx->plt_num * PLT_ENTRY_SIZE;
+	ctx->sections[OUT_GOT].size      = (u64)ctx->got_num * 8;
+	ctx->sections[OUT_DYNAMIC].size  = get_dynamic_entry_count(ctx) * sizeof(Elf64_Dyn);
+
+	const enum out_section_kind synthetic[] = {
+	    OUT_INTERP, OUT_HASH, OUT_DYNSYM, OUT_DYNSTR, OUT_RELA_DYN, OUT_PLT, OUT_GOT, OUT_DYNAMIC};
+	for (usize i = 0; i < static_arrlenu(synthetic); ++i) {
+		struct out_section *section = &ctx->sections[synthetic[i]];
+		arrsetlen(section->bytes, section->size);
+		if (section->size) memset(section->bytes, 0, section->size);
+	}
+}
+
+// =================================================================================================
+// Layout
+// =================================================================================================
+static void assign_section_indices(struct context *ctx) {
+	u32 shndx = 1;
+	for (usize i = 0; i < arrlenu(ctx->sections); ++i) {
+		struct out_section *section = &ctx->sections[i];
+		section->shndx              = section->size ? shndx++ : 0;
+	}
+	ctx->sections[OUT_HASH].link   = ctx->sections[OUT_DYNSYM].shndx;
+	ctx->sections[OUT_DYNSYM].link = ctx->sections[OUT_DYNSTR].shndx;
+	ctx->sections[OUT_DYNSYM].info = 1;
+	ctx->sections[OUT_RELA_DYN].link = ctx->sections[OUT_DYNSYM].shndx;
+	ctx->sections[OUT_DYNAMIC].link  = ctx->sections[OUT_DYNSTR].shndx;
+}
+
+static inline bool has_tls(struct context *ctx) {
+	return ctx->sections[OUT_TDATA].size || ctx->sections[OUT_TBSS].size;
+}
+
+static inline usize get_phdr_count(struct context *ctx) {
+	return has_tls(ctx) ? MAX_PHDR_COUNT : MAX_PHDR_COUNT - 1;
+}
+
+// Returns end of the file content.
+static u64 layout_sections(struct context *ctx) {
+	// The initialization image must start at address aligned for all thread local variables.
+	struct out_section *tdata = &ctx->sections[OUT_TDATA];
+	struct out_section *tbss  = &ctx->sections[OUT_TBSS];
+	tdata->align              = MAX(tdata->align, tbss->align);
+
+	u64 offset = sizeof(Elf64_Ehdr) + get_phdr_count(ctx) * sizeof(Elf64_Phdr);
+	for (usize si = 0; si < static_arrlenu(SEGMENTS); ++si) {
+		if (si) offset = next_aligned2(offset, SEGMENT_ALIGNMENT);
+		for (u32 i = SEGMENTS[si].first; i <= SEGMENTS[si].last; ++i) {
+			struct out_section *section = &ctx->sections[i];
+			offset                      = next_aligned2(offset, section->align);
+			section->offset             = offset;
+			section->addr               = BASE_ADDRESS + offset;
+			if (section->type != SHT_NOBITS) offset += section->size;
+		}
+	}
+	for (usize i = _OUT_ALLOC_COUNT; i < arrlenu(ctx->sections); ++i) {
+		struct out_section *section = &ctx->sections[i];
+		section->offset             = offset;
+		section->addr               = 0;
+		offset += section->size;
+	}
+
+	ctx->tls_addr  = tdata->addr;
+	ctx->tls_size  = tbss->addr + tbss->size - tdata->addr;
+	ctx->tls_align = tdata->align;
+	return offset;
+}
+
+// Offset of thread local variable from the thread pointer; the initialization image is placed
+// right below the thread pointer (x86_64 TLS variant II).
+static inline s64 get_tp_offset(struct context *ctx, u64 address) {
+	return (s64)(address - ctx->tls_addr) - (s64)next_aligned2(ctx->tls_size, ctx->tls_align);
+}
+
+// Value of the symbol in the output symbol tables, thread local symbols are relative to the
+// initialization image.
+static inline u64 get_symbol_value(struct context *ctx, const Elf64_Sym *elf_sym, u64 address) {
+	if (ELF64_ST_TYPE(elf_sym->st_info) == STT_TLS) return address - ctx->tls_addr;
+	return address;
+}
+
+static u64 get_input_section_address(struct context *ctx, struct input_object *obj, u32 shndx) {
+	const s32 index = obj->section_map[shndx];
+	bassert(index != -1);
+	return ctx->sections[index].addr + obj->section_offset[shndx];
+}
+
+static bool compute_symbol_addresses(struct context *ctx) {
+	for (usize i = 0; i < arrlenu(ctx->symbols); ++i) {
+		struct symbol *sym = &ctx->symbols[i];
+		switch (sym->kind) {
+		case SYMBOL_DEFINED: {
+			struct input_object *obj     = &ctx->objects[sym->object_index];
+			const Elf64_Sym     *elf_sym = &obj->syms[sym->sym_index];
+			if (elf_sym->st_shndx == SHN_ABS) {
+				sym->address = elf_sym->st_value;
+				break;
+			}
+			if (elf_sym->st_shndx >= obj->shnum || obj->section_map[elf_sym->st_shndx] == -1) {
+				unsupported("Symbol '" STR_FMT "' is defined in discarded section.", STR_ARG(sym->name));
+			}
+			sym->address = get_input_section_address(ctx, obj, elf_sym->st_shndx) + elf_sym->st_value;
+			break;
+		}
+		case SYMBOL_IMPORTED:
+			if (sym->needs_copy) {
+				sym->address = ctx->sections[OUT_BSS].addr + sym->copy_offset;
+			} else if (sym->plt_index != -1) {
+				sym->address = ctx->sections[OUT_PLT].addr + (u64)sym->plt_index * PLT_ENTRY_SIZE;
+			}
+			break;
+		case SYMBOL_UNDEFINED:
+			sym->address = 0;
+			break;
+		}
+	}
+	return true;
+}
+
+// =================================================================================================
+// Synthetic sections
+// =================================================================================================
+static void write_dynamic_sections(struct context *ctx) {
+	memcpy(ctx->sections[OUT_INTERP].bytes, ctx->interp, ctx->sections[OUT_INTERP].size);
+	memcpy(ctx->sections[OUT_DYNSTR].bytes, ctx->dynstrs, arrlenu(ctx->dynstrs));
+
+	// Dynamic symbols.
+	const usize dynsym_num = arrlenu(ctx->dynsym_symbols);
+	Elf64_Sym  *dynsyms    = (Elf64_Sym *)ctx->sections[OUT_DYNSYM].bytes;
+	for (usize i = 1; i < dynsym_num; ++i) {
+		struct symbol *sym  = &ctx->symbols[ctx->dynsym_symbols[i]];
+		Elf64_Sym     *dsym = &dynsyms[i];
+		dsym->st_name       = sym->dynstr_offset;
+		const u8 bind = sym->is_weak && sym->kind == SYMBOL_IMPORTED ? STB_WEAK : STB_GLOBAL;
+		if (sym->kind == SYMBOL_IMPORTED && !sym->needs_copy) {
+			dsym->st_info = ELF64_ST_INFO(bind, sym->is_func ? STT_FUNC : STT_OBJECT);
+			continue;
+		}
+		if (sym->needs_copy) {
+			dsym->st_info  = ELF64_ST_INFO(STB_GLOBAL, STT_OBJECT);
+			dsym->st_shndx = (u16)ctx->sections[OUT_BSS].shndx;
+			dsym->st_value = sym->address;
+			dsym->st_size  = sym->import_size;
+			continue;
+		}
+		const struct input_object *obj     = &ctx->objects[sym->object_index];
+		const Elf64_Sym           *elf_sym = &obj->syms[sym->sym_index];
+		dsym->st_info                      = ELF64_ST_INFO(ELF64_ST_BIND(elf_sym->st_info), ELF64_ST_TYPE(elf_sym->st_info));
+		dsym->st_other                     = elf_sym->st_other;
+		dsym->st_shndx                     = elf_sym->st_shndx == SHN_ABS ? SHN_ABS : (u16)ctx->sections[obj->section_map[elf_sym->st_shndx]].shndx;
+		dsym->st_value                     = get_symbol_value(ctx, elf_sym, sym->address);
+		dsym->st_size                      = elf_sym->st_size;
+	}
+
+	// SysV hash table.
+	u32        *hash    = (u32 *)ctx->sections[OUT_HASH].bytes;
+	const u32   nbucket = (u32)MAX(dynsym_num / 2, 1);
+	u32        *buckets = hash + 2;
+	u32        *chains  = buckets + nbucket;
+	hash[0]             = nbucket;
+	hash[1]             = (u32)dynsym_num;
+	for (usize i = 1; i < dynsym_num; ++i) {
+		const u32 bucket = elf_hash(ctx->dynstrs + dynsyms[i].st_name) % nbucket;
+		chains[i]        = buckets[bucket];
+		buckets[bucket]  = (u32)i;
+	}
+
+	// GOT, PLT and dynamic relocations.
+	u64        *got      = (u64 *)ctx->sections[OUT_GOT].bytes;
+	u8         *plt      = ctx->sections[OUT_PLT].bytes;
+	Elf64_Rela *relocs   = (Elf64_Rela *)ctx->sections[OUT_RELA_DYN].bytes;
+	usize       rela_num = 0;
+	const u64   got_addr = ctx->sections[OUT_GOT].addr;
+	const u64   plt_addr = ctx->sections[OUT_PLT].addr;
+	for (usize i = 0; i < arrlenu(ctx->symbols); ++i) {
+		struct symbol *sym = &ctx->symbols[i];
+		if (sym->got_index != -1) {
+			const u64 entry_addr = got_addr + (u64)sym->got_index * 8;
+			if (sym->kind == SYMBOL_IMPORTED) {
+				relocs[rela_num++] = (Elf64_Rela){
+				    .r_offset = entry_addr,
+				    .r_info   = ELF64_R_INFO(sym->dynsym_index, R_X86_64_GLOB_DAT),
+				};
+			} else {
+				got[sym->got_index] = sym->address;
+			}
+		}
+		if (sym->plt_index != -1) {
+			// jmp *[rip + got_entry]; xchg ax, ax
+			u8       *stub       = plt + (u64)sym->plt_index * PLT_ENTRY_SIZE;
+			const u64 entry_addr = got_addr + (u64)sym->got_index * 8;
+			const s32 disp       = (s32)(entry_addr - (plt_addr + (u64)sym->plt_index * PLT_ENTRY_SIZE + 6));
+			stub[0]              = 0xFF;
+			stub[1]              = 0x25;
+			memcpy(stub + 2, &disp, sizeof(s32));
+			stub[6] = 0x66;
+			stub[7] = 0x90;
+		}
+		if (sym->needs_copy) {
+			relocs[rela_num++] = (Elf64_Rela){
+			    .r_offset = sym->address,
+			    .r_info   = ELF64_R_INFO(sym->dynsym_index, R_X86_64_COPY),
+			};
+		}
+	}
+	bassert(rela_num * sizeof(Elf64_Rela) == ctx->sections[OUT_RELA_DYN].size);
+
+	// Dynamic section.
+	Elf64_Dyn *dynamic = (Elf64_Dyn *)ctx->sections[OUT_DYNAMIC].bytes;
+	usize      di      = 0;
+#define DYN(tag, value) dynamic[di++] = (Elf64_Dyn){.d_tag = (tag), .d_un.d_val = (value)}
+	for (usize i = 0; i < arrlenu(ctx->needed_offsets); ++i) DYN(DT_NEEDED, ctx->needed_offsets[i]);
+	if (ctx->runpath_offset) DYN(DT_RUNPATH, ctx->runpath_offset);
+	DYN(DT_HASH, ctx->sections[OUT_HASH].addr);
+	DYN(DT_STRTAB, ctx->sections[OUT_DYNSTR].addr);
+	DYN(DT_SYMTAB, ctx->sections[OUT_DYNSYM].addr);
+	DYN(DT_STRSZ, ctx->sections[OUT_DYNSTR].size);
+	DYN(DT_SYMENT, sizeof(Elf64_Sym));
+	if (ctx->got_num || ctx->copy_num) {
+		DYN(DT_RELA, ctx->sections[OUT_RELA_DYN].addr);
+		DYN(DT_RELASZ, ctx->sections[OUT_RELA_DYN].size);
+		DYN(DT_RELAENT, sizeof(Elf64_Rela));
+	}
+	if (ctx->sections[OUT_INIT_ARRAY].size) {
+		DYN(DT_INIT_ARRAY, ctx->sections[OUT_INIT_ARRAY].addr);
+		DYN(DT_INIT_ARRAYSZ, ctx->sections[OUT_INIT_ARRAY].size);
+	}
+	if (ctx->sections[OUT_FINI_ARRAY].size) {
+		DYN(DT_FINI_ARRAY, ctx->sections[OUT_FINI_ARRAY].addr);
+		DYN(DT_FINI_ARRAYSZ, ctx->sections[OUT_FINI_ARRAY].size);
+	}
+	DYN(DT_DEBUG, 0);
+	DYN(DT_FLAGS, DF_BIND_NOW);
+	DYN(DT_FLAGS_1, DF_1_NOW);
+	DYN(DT_NULL, 0);
+#undef DYN
+	bassert(di == get_dynamic_entry_count(ctx));
+}
+
+// =================================================================================================
+// Relocations
+// =================================================================================================
+static bool get_relocation_symbol(struct context *ctx, struct input_object *obj, u32 sym_index, u64 *out_address, s32 *out_global) {
+	const s32 global_index = obj->symbol_map[sym_index];
+	*out_global            = global_index;
+	if (global_index != -1) {
+		*out_address = ctx->symbols[global_index].address;
+		return true;
+	}
+	const Elf64_Sym *elf_sym = &obj->syms[sym_index];
+	switch (elf_sym->st_shndx) {
+	case SHN_UNDEF:
+		*out_address = 0;
+		return true;
+	case SHN_ABS:
+		*out_address = elf_sym->st_value;
+		return true;
+	default:
+		break;
+	}
+	if (elf_sym->st_shndx >= obj->shnum || obj->section_map[elf_sym->st_shndx] == -1) {
+		unsupported("Relocation refers to discarded section.");
+	}
+	*out_address = get_input_section_address(ctx, obj, elf_sym->st_shndx) + elf_sym->st_value;
+	return true;
+}
+
+static bool apply_relocations(struct context *ctx) {
+	const u64 got_addr = ctx->sections[OUT_GOT].addr;
+	for (usize oi = 0; oi < arrlenu(ctx->objects); ++oi) {
+		struct input_object *obj = &ctx->objects[oi];
+		for (u32 i = 0; i < obj->shnum; ++i) {
+			const Elf64_Shdr *shdr = &obj->shdrs[i];
+			if (shdr->sh_type != SHT_RELA) continue;
+			if (shdr->sh_info >= obj->shnum || obj->section_map[shdr->sh_info] == -1) continue;
+			struct out_section *section        = &ctx->sections[obj->section_map[shdr->sh_info]];
+			const u64           section_offset = obj->section_offset[shdr->sh_info];
+			const u64           section_size   = obj->shdrs[shdr->sh_info].sh_size;
+			const Elf64_Rela   *relocs         = (Elf64_Rela *)(obj->data + shdr->sh_offset);
+			const usize         count          = shdr->sh_size / sizeof(Elf64_Rela);
+			for (usize j = 0; j < count; ++j) {
+				const Elf64_Rela *rela = &relocs[j];
+				const u32         type = ELF64_R_TYPE(rela->r_info);
+				if (type == R_X86_64_NONE) continue;
+				const u64 size = (type == R_X86_64_64 || type == R_X86_64_PC64 || type == R_X86_64_TPOFF64 || type == R_X86_64_DTPOFF64) ? 8 : 4;
+				if (rela->r_offset > section_size || size > section_size - rela->r_offset) unsupported("Invalid relocation offset.");
+
+				u64 S;
+				s32 global_index;
+				if (!get_relocation_symbol(ctx, obj, ELF64_R_SYM(rela->r_info), &S, &global_index)) return false;
+				const s64 A     = rela->r_addend;
+				const u64 P     = section->addr + section_offset + rela->r_offset;
+				u8       *where = section->bytes + section_offset + rela->r_offset;
+
+				s64 value;
+				switch (type) {
+				case R_X86_64_64:
+					value = (s64)(S + A);
+					break;
+				case R_X86_64_PC64:
+					value = (s64)(S + A - P);
+					break;
+				case R_X86_64_PC32:
+				case R_X86_64_PLT32:
+					value = (s64)(S + A - P);
+					if (value < INT32_MIN || value > INT32_MAX) unsupported("Relocation out of range.");
+					break;
+				case R_X86_64_32:
+					value = (s64)(S + A);
+					if (value < 0 || value > UINT32_MAX) unsupported("Relocation out of range.");
+					break;
+				case R_X86_64_32S:
+					value = (s64)(S + A);
+					if (value < INT32_MIN || value > INT32_MAX) unsupported("Relocation out of range.");
+					break;
+				case R_X86_64_GOTPCREL:
+				case R_X86_64_GOTPCRELX:
+				case R_X86_64_REX_GOTPCRELX: {
+					bassert(global_index != -1 && ctx->symbols[global_index].got_index != -1);
+					const u64 G = got_addr + (u64)ctx->symbols[global_index].got_index * 8;
+					value       = (s64)(G + A - P);
+					if (value < INT32_MIN || value > INT32_MAX) unsupported("Relocation out of range.");
+					break;
+				}
+				case R_X86_64_TPOFF32:
+				case R_X86_64_TPOFF64:
+					value = get_tp_offset(ctx, S + A);
+					if (size == 4 && (value < INT32_MIN || value > INT32_MAX)) unsupported("Relocation out of range.");
+					break;
+				case R_X86_64_DTPOFF32:
+				case R_X86_64_DTPOFF64:
+					value = (s64)(S + A - ctx->tls_addr);
+					if (size == 4 && (value < INT32_MIN || value > INT32_MAX)) unsupported("Relocation out of range.");
+					break;
+				default:
+					babort("Unexpected relocation type!");
+				}
+				if (size == 8) {
+					memcpy(where, &value, 8);
+				} else {
+					const u32 value32 = (u32)value;
+					memcpy(where, &value32, 4);
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// =================================================================================================
+// Output
+// =================================================================================================
+static void add_name(array(char) * strs, const char *name, u32 *out_offset) {
+	*out_offset     = (u32)arrlenu(*strs);
+	const usize len = strlen(name);
+	memcpy(arraddnptr(*strs, len + 1), name, len + 1);
+}
+
+// Static symbol table is kept for debuggers and stack traces.
+static void create_symtab(struct context *ctx, array(Elf64_Sym) * syms, array(char) * strs, u32 *out_first_global) {
+	arrput(*syms, (Elf64_Sym){0});
+	arrput(*strs, '\0');
+	for (usize oi = 0; oi < arrlenu(ctx->objects); ++oi) {
+		struct input_object *obj = &ctx->objects[oi];
+		for (u32 i = 1; i < obj->sym_num; ++i) {
+			const Elf64_Sym *elf_sym = &obj->syms[i];
+			const u8         type    = ELF64_ST_TYPE(elf_sym->st_info);
+			if (ELF64_ST_BIND(elf_sym->st_info) != STB_LOCAL) continue;
+			if (type != STT_FUNC && type != STT_OBJECT && type != STT_NOTYPE && type != STT_TLS) continue;
+			if (!elf_sym->st_name || elf_sym->st_shndx == SHN_UNDEF || elf_sym->st_shndx >= obj->shnum) continue;
+			const s32 section_index = obj->section_map[elf_sym->st_shndx];
+			if (section_index == -1 || section_index >= _OUT_ALLOC_COUNT) continue;
+			Elf64_Sym sym = *elf_sym;
+			add_name(strs, obj->strs + elf_sym->st_name, &sym.st_name);
+			sym.st_shndx = (u16)ctx->sections[section_index].shndx;
+			sym.st_value = get_symbol_value(ctx, elf_sym, get_input_section_address(ctx, obj, elf_sym->st_shndx) + elf_sym->st_value);
+			arrput(*syms, sym);
+		}
+	}
+	*out_first_global = (u32)arrlenu(*syms);
+	for (usize i = 0; i < arrlenu(ctx->symbols); ++i) {
+		struct symbol *sym = &ctx->symbols[i];
+		if (sym->kind != SYMBOL_DEFINED) continue;
+		const struct input_object *obj     = &ctx->objects[sym->object_index];
+		Elf64_Sym                  elf_sym = obj->syms[sym->sym_index];
+		add_name(strs, sym->name.ptr, &elf_sym.st_name);
+		if (elf_sym.st_shndx != SHN_ABS) elf_sym.st_shndx = (u16)ctx->sections[obj->section_map[elf_sym.st_shndx]].shndx;
+		elf_sym.st_value = get_symbol_value(ctx, &elf_sym, sym->address);
+		arrput(*syms, elf_sym);
+	}
+}
+
+static bool write_padding(FILE *file, u64 *position, u64 offset) {
+	static const u8 zeros[256] = {0};
+	while (*position < offset) {
+		const u64 len = MIN(offset - *position, sizeof(zeros));
+		if (fwrite(zeros, 1, len, file) != len) return false;
+		*position += len;
+	}
+	return true;
+}
+
+static bool write_at(FILE *file, u64 *position, u64 offset, const void *data, u64 size) {
+	bassert(*position <= offset);
+	if (!write_padding(file, position, offset)) return false;
+	if (size && fwrite(data, 1, size, file) != size) return false;
+	*position += size;
+	return true;
+}
+
+static bool write_executable(struct context *ctx, u64 content_end, const str_t filepath) {
+	array(Elf64_Sym) syms = NULL;
+	array(char) strs      = NULL;
+	array(char) shstrs    = NULL;
+	array(Elf64_Shdr) shdrs = NULL;
+	u32  first_global       = 0;
+	bool ok                 = false;
+	FILE *file              = NULL;
+
+	create_symtab(ctx, &syms, &strs, &first_global);
+	arrput(shstrs, '\0');
+	arrput(shdrs, (Elf64_Shdr){0});
+	for (usize i = 0; i < arrlenu(ctx->sections); ++i) {
+		struct out_section *section = &ctx->sections[i];
+		if (!section->shndx) continue;
+		Elf64_Shdr shdr = {
+		    .sh_type      = section->type,
+		    .sh_flags     = section->flags,
+		    .sh_addr      = section->addr,
+		    .sh_offset    = section->offset,
+		    .sh_size      = section->size,
+		    .sh_link      = section->link,
+		    .sh_info      = section->info,
+		    .sh_addralign = section->align,
+		    .sh_entsize   = section->entsize,
+		};
+		add_name(&shstrs, section->name, &shdr.sh_name);
+		bassert(arrlenu(shdrs) == section->shndx);
+		arrput(shdrs, shdr);
+	}
+
+	u64        offset = next_aligned2(content_end, 8);
+	Elf64_Shdr symtab = {
+	    .sh_type      = SHT_SYMTAB,
+	    .sh_offset    = offset,
+	    .sh_size      = arrlenu(syms) * sizeof(Elf64_Sym),
+	    .sh_link      = (u32)arrlenu(shdrs) + 1,
+	    .sh_info      = first_global,
+	    .sh_addralign = 8,
+	    .sh_entsize   = sizeof(Elf64_Sym),
+	};
+	add_name(&shstrs, ".symtab", &symtab.sh_name);
+	arrput(shdrs, symtab);
+	offset += symtab.sh_size;
+
+	Elf64_Shdr strtab = {.sh_type = SHT_STRTAB, .sh_offset = offset, .sh_size = arrlenu(strs), .sh_addralign = 1};
+	add_name(&shstrs, ".strtab", &strtab.sh_name);
+	arrput(shdrs, strtab);
+	offset += strtab.sh_size;
+
+	Elf64_Shdr shstrtab = {.sh_type = SHT_STRTAB, .sh_offset = offset, .sh_addralign = 1};
+	add_name(&shstrs, ".shstrtab", &shstrtab.sh_name);
+	shstrtab.sh_size = arrlenu(shstrs);
+	arrput(shdrs, shstrtab);
+	offset += shstrtab.sh_size;
+
+	const u64 shoff = next_aligned2(offset, 8);
+
+	// Program headers.
+	const usize phdr_count = get_phdr_count(ctx);
+	Elf64_Phdr  phdrs[MAX_PHDR_COUNT];
+	memset(phdrs, 0, sizeof(phdrs));
+	usize pi    = 0;
+	phdrs[pi++] = (Elf64_Phdr){
+	    .p_type   = PT_PHDR,
+	    .p_flags  = PF_R,
+	    .p_offset = sizeof(Elf64_Ehdr),
+	    .p_vaddr  = BASE_ADDRESS + sizeof(Elf64_Ehdr),
+	    .p_paddr  = BASE_ADDRESS + sizeof(Elf64_Ehdr),
+	    .p_filesz = phdr_count * sizeof(Elf64_Phdr),
+	    .p_memsz  = phdr_count * sizeof(Elf64_Phdr),
+	    .p_align  = 8,
+	};
+	const struct out_section *interp = &ctx->sections[OUT_INTERP];
+	phdrs[pi++]                      = (Elf64_Phdr){
+        .p_type   = PT_INTERP,
+        .p_flags  = PF_R,
+        .p_offset = interp->offset,
+        .p_vaddr  = interp->addr,
+        .p_paddr  = interp->addr,
+        .p_filesz = interp->size,
+        .p_memsz  = interp->size,
+        .p_align  = 1,
+    };
+	for (usize si = 0; si < static_arrlenu(SEGMENTS); ++si) {
+		const u64 begin    = si ? ctx->sections[SEGMENTS[si].first].offset : 0;
+		u64       file_end = begin;
+		u64       mem_end  = begin;
+		for (u32 i = SEGMENTS[si].first; i <= SEGMENTS[si].last; ++i) {
+			const struct out_section *section = &ctx->sections[i];
+			if (!section->size) continue;
+			// Thread local .bss exists only in the initialization image.
+			if (i == OUT_TBSS) continue;
+			const u64 end = section->offset + section->size;
+			if (section->type != SHT_NOBITS) file_end = MAX(file_end, end);
+			mem_end = MAX(mem_end, end);
+		}
+		phdrs[pi++] = (Elf64_Phdr){
+		    .p_type   = PT_LOAD,
+		    .p_flags  = SEGMENTS[si].flags,
+		    .p_offset = begin,
+		    .p_vaddr  = BASE_ADDRESS + begin,
+		    .p_paddr  = BASE_ADDRESS + begin,
+		    .p_filesz = file_end - begin,
+		    .p_memsz  = mem_end - begin,
+		    .p_align  = SEGMENT_ALIGNMENT,
+		};
+	}
+	const struct out_section *dynamic = &ctx->sections[OUT_DYNAMIC];
+	phdrs[pi++]                       = (Elf64_Phdr){
+        .p_type   = PT_DYNAMIC,
+        .p_flags  = PF_R | PF_W,
+        .p_offset = dynamic->offset,
+        .p_vaddr  = dynamic->addr,
+        .p_paddr  = dynamic->addr,
+        .p_filesz = dynamic->size,
+        .p_memsz  = dynamic->size,
+        .p_align  = 8,
+    };
+	phdrs[pi++] = (Elf64_Phdr){
+	    .p_type  = PT_GNU_STACK,
+	    .p_flags = PF_R | PF_W,
+	    .p_align = 16,
+	};
+	if (has_tls(ctx)) {
+		const struct out_section *tdata = &ctx->sections[OUT_TDATA];
+		phdrs[pi++]                     = (Elf64_Phdr){
+		    .p_type   = PT_TLS,
+		    .p_flags  = PF_R,
+		    .p_offset = tdata->offset,
+		    .p_vaddr  = ctx->tls_addr,
+		    .p_paddr  = ctx->tls_addr,
+		    .p_filesz = tdata->size,
+		    .p_memsz  = ctx->tls_size,
+		    .p_align  = ctx->tls_align,
+		};
+	}
+	bassert(pi == phdr_count);
+
+	const s32   entry_index = lookup_symbol(ctx, make_str_from_c(ctx->entry));
+	Elf64_Ehdr  ehdr        = {
+        .e_type      = ET_EXEC,
+        .e_machine   = EM_X86_64,
+        .e_version   = EV_CURRENT,
+        .e_entry     = entry_index != -1 ? ctx->symbols[entry_index].address : 0,
+        .e_phoff     = sizeof(Elf64_Ehdr),
+        .e_shoff     = shoff,
+        .e_ehsize    = sizeof(Elf64_Ehdr),
+        .e_phentsize = sizeof(Elf64_Phdr),
+        .e_phnum     = (u16)phdr_count,
+        .e_shentsize = sizeof(Elf64_Shdr),
+        .e_shnum     = (u16)arrlenu(shdrs),
+        .e_shstrndx  = (u16)(arrlenu(shdrs) - 1),
+    };
+	memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+	ehdr.e_ident[EI_CLASS]   = ELFCLASS64;
+	ehdr.e_ident[EI_DATA]    = ELFDATA2LSB;
+	ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+	ehdr.e_ident[EI_OSABI]   = ELFOSABI_SYSV;
+
+	str_buf_t tmp = get_tmp_str();
+	file          = fopen(str_to_c(&tmp, filepath), "wb");
+	put_tmp_str(tmp);
+	if (!file) {
+		builder_error("Cannot open file '" STR_FMT "' for writing.", STR_ARG(filepath));
+		goto DONE;
+	}
+
+	u64 position = 0;
+	if (!write_at(file, &position, 0, &ehdr, sizeof(ehdr))) goto DONE;
+	if (!write_at(file, &position, sizeof(ehdr), phdrs, phdr_count * sizeof(Elf64_Phdr))) goto DONE;
+	for (usize i = 0; i < arrlenu(ctx->sections); ++i) {
+		struct out_section *section = &ctx->sections[i];
+		if (!section->shndx || section->type == SHT_NOBITS) continue;
+		if (!write_at(file, &position, section->offset, section->bytes, section->size)) goto DONE;
+	}
+	if (!write_at(file, &position, symtab.sh_offset, syms, symtab.sh_size)) goto DONE;
+	if (!write_at(file, &position, strtab.sh_offset, strs, strtab.sh_size)) goto DONE;
+	if (!write_at(file, &position, shstrtab.sh_offset, shstrs, shstrtab.sh_size)) goto DONE;
+	if (!write_at(file, &position, shoff, shdrs, arrlenu(shdrs) * sizeof(Elf64_Shdr))) goto DONE;
+	ok = true;
+
+DONE:
+	if (file) {
+		fclose(file);
+		if (!ok) builder_error("Cannot write file '" STR_FMT "'.", STR_ARG(filepath));
+	}
+	if (ok) {
+		str_buf_t tmp_path = get_tmp_str();
+		chmod(str_to_c(&tmp_path, filepath), 0755);
+		put_tmp_str(tmp_path);
+	}
+	arrfree(syms);
+	arrfree(strs);
+	arrfree(shstrs);
+	arrfree(shdrs);
+	return ok;
+}
+
+static bool is_usable(struct assembly *assembly) {
+	const struct target *target = assembly->target;
+	if (!target->fast_link) return false;
+	if (target->kind != ASSEMBLY_EXECUTABLE) return false;
+	if (target->opt != ASSEMBLY_OPT_DEBUG) return false;
+	if (target->triple.arch != ARCH_x86_64 || target->triple.os != OS_linux) return false;
+	if (target->triple.env == ENV_musl) return false;
+	return true;
+}
+
+static bool link_executable(struct context *ctx) {
+	if (!parse_options(ctx)) return false;
+	if (!ctx->interp) ctx->interp = strdup(DEFAULT_INTERP);
+	if (!ctx->entry) ctx->entry = strdup(DEFAULT_ENTRY);
+	if (!load_objects(ctx)) return false;
+	if (!load_shared_libs(ctx)) return false;
+	if (!collect_symbols(ctx)) return false;
+	if (!resolve_imports(ctx)) return false;
+
+	const s32 entry = lookup_symbol(ctx, make_str_from_c(ctx->entry));
+	if (entry == -1 || ctx->symbols[entry].kind != SYMBOL_DEFINED) unsupported("Entry symbol '%s' not found.", ctx->entry);
+
+	init_sections(ctx);
+	if (!map_sections(ctx)) return false;
+	if (!scan_relocations(ctx)) return false;
+	collect_dynamic_symbols(ctx);
+	set_synthetic_section_sizes(ctx);
+	assign_section_indices(ctx);
+	const u64 content_end = layout_sections(ctx);
+	if (!compute_symbol_addresses(ctx)) return false;
+	write_dynamic_sections(ctx);
+	if (!apply_relocations(ctx)) return false;
+
+	const struct target *target   = ctx->assembly->target;
+	str_buf_t            filepath = get_tmp_str();
+	str_buf_append_fmt(&filepath, "{str}/{s}", target->out_dir, target->name);
+	const bool ok = write_executable(ctx, content_end, str_buf_view(filepath));
+	put_tmp_str(filepath);
+	return ok;
+}
+
+static void terminate(struct context *ctx) {
+	for (usize i = 0; i < arrlenu(ctx->objects); ++i) {
+		struct input_object *obj = &ctx->objects[i];
+		if (obj->is_owned) bfree(obj->data);
+		arrfree(obj->section_map);
+		arrfree(obj->section_offset);
+		arrfree(obj->symbol_map);
+	}
+	for (usize i = 0; i < arrlenu(ctx->libs); ++i) {
+		bfree(ctx->libs[i].data);
+	}
+	for (usize i = 0; i < arrlenu(ctx->sections); ++i) {
+		arrfree(ctx->sections[i].bytes);
+	}
+	for (usize i = 0; i < arrlenu(ctx->inputs); ++i) {
+		free(ctx->inputs[i]);
+	}
+	for (usize i = 0; i < arrlenu(ctx->lib_filenames); ++i) {
+		free(ctx->lib_filenames[i]);
+	}
+	free(ctx->interp);
+	free(ctx->entry);
+	arrfree(ctx->objects);
+	arrfree(ctx->libs);
+	arrfree(ctx->symbols);
+	tbl_free(ctx->symbol_table);
+	arrfree(ctx->sections);
+	arrfree(ctx->dynsym_symbols);
+	arrfree(ctx->dynstrs);
+	arrfree(ctx->needed_offsets);
+	arrfree(ctx->inputs);
+	arrfree(ctx->lib_filenames);
+}
+
+// Returns 0 on success, -1 when the built-in linker cannot be used and the regular linker should
+// be used instead.
+s32 elf_ld(struct assembly *assembly) {
+	if (!is_usable(assembly)) return -1;
+	zone();
+	runtime_measure_begin(linking);
+	struct context ctx = {.assembly = assembly};
+	const bool     ok  = link_executable(&ctx);
+	terminate(&ctx);
+	if (ok) {
+		const s32 ms = runtime_measure_end(linking);
+		batomic_fetch_add_s32(&assembly->stats.linker_ms, ms);
+		batomic_fetch_add_s32(&assembly->stats.linking_ms, ms);
+		batomic_store_s32(&assembly->stats.linker_in_process, 1);
+	}
+	return_zone(ok ? 0 : -1);
+}
+
+#else
+
+s32 elf_ld(struct assembly UNUSED(*assembly)) {
+	return -1;
+}
+
+#endif
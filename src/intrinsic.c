@@ -29,6 +29,10 @@
 #include "common.h"
 #include <math.h>
 
+#if BL_PLATFORM_WIN
+#include <intrin.h>
+#endif
+
 BL_EXPORT void __intrinsic_memmove_p0_p0_i64(u8 *dest, u8 *src, usize size, bool is_volatile) {
 	memmove(dest, src, size);
 }
@@ -128,3 +132,99 @@ BL_EXPORT f32 __intrinsic_trunc_f32(f32 v) {
 BL_EXPORT f64 __intrinsic_trunc_f64(f64 v) {
 	return trunc(v);
 }
+
+BL_EXPORT void __intrinsic_prefetch(u8 *ptr, bool is_write, s32 locality) {
+	// Nothing to do in compile-time.
+}
+
+// Atomics executed in compile-time are always sequentially consistent; the requested memory order
+// only allows weaker guarantees, so it is safe to ignore it here. Values are passed as unsigned
+// integers of matching size.
+#define atomic_op_add(a, b) ((a) + (b))
+#define atomic_op_sub(a, b) ((a) - (b))
+#define atomic_op_and(a, b) ((a) & (b))
+#define atomic_op_or(a, b)  ((a) | (b))
+#define atomic_op_xor(a, b) ((a) ^ (b))
+
+#if BL_PLATFORM_WIN
+#define atomic_cas8(p, e, d)  (u8) _InterlockedCompareExchange8((volatile char *)(p), (char)(d), (char)(e))
+#define atomic_cas16(p, e, d) (u16) _InterlockedCompareExchange16((volatile short *)(p), (short)(d), (short)(e))
+#define atomic_cas32(p, e, d) (u32) _InterlockedCompareExchange((volatile long *)(p), (long)(d), (long)(e))
+#define atomic_cas64(p, e, d) (u64) _InterlockedCompareExchange64((volatile __int64 *)(p), (__int64)(d), (__int64)(e))
+
+// Everything is implemented using compare-exchange loop to cover all integer sizes.
+#define ATOMIC_INTRINSICS(bits)                                                                          \
+	BL_EXPORT u##bits __intrinsic_atomic_load_i##bits(u##bits *ptr, s32 order) {                         \
+		return atomic_cas##bits(ptr, 0, 0);                                                              \
+	}                                                                                                    \
+	BL_EXPORT u##bits __intrinsic_atomic_xchg_i##bits(u##bits *ptr, u##bits v, s32 order) {              \
+		u##bits old = *(volatile u##bits *)ptr, prev;                                                    \
+		while ((prev = atomic_cas##bits(ptr, old, v)) != old) old = prev;                                \
+		return old;                                                                                      \
+	}                                                                                                    \
+	BL_EXPORT void __intrinsic_atomic_store_i##bits(u##bits *ptr, u##bits v, s32 order) {                \
+		__intrinsic_atomic_xchg_i##bits(ptr, v, order);                                                  \
+	}                                                                                                    \
+	BL_EXPORT bool __intrinsic_atomic_cmpxchg_i##bits(u##bits *ptr, u##bits *expected, u##bits desired, s32 order) { \
+		const u##bits old = atomic_cas##bits(ptr, *expected, desired);                                   \
+		if (old == *expected) return true;                                                               \
+		*expected = old;                                                                                 \
+		return false;                                                                                    \
+	}                                                                                                    \
+	ATOMIC_FETCH_OP(bits, add)                                                                           \
+	ATOMIC_FETCH_OP(bits, sub)                                                                           \
+	ATOMIC_FETCH_OP(bits, and)                                                                           \
+	ATOMIC_FETCH_OP(bits, or)                                                                            \
+	ATOMIC_FETCH_OP(bits, xor)
+
+#define ATOMIC_FETCH_OP(bits, op)                                                                        \
+	BL_EXPORT u##bits __intrinsic_atomic_##op##_i##bits(u##bits *ptr, u##bits v, s32 order) {            \
+		u##bits old = *(volatile u##bits *)ptr, prev;                                                    \
+		while ((prev = atomic_cas##bits(ptr, old, (u##bits)atomic_op_##op(old, v))) != old) old = prev;  \
+		return old;                                                                                      \
+	}
+
+BL_EXPORT void __intrinsic_atomic_fence(s32 order) {
+	volatile long barrier = 0;
+	_InterlockedOr(&barrier, 0);
+}
+
+#else
+
+#define ATOMIC_INTRINSICS(bits)                                                                          \
+	BL_EXPORT u##bits __intrinsic_atomic_load_i##bits(u##bits *ptr, s32 order) {                         \
+		return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);                                                   \
+	}                                                                                                    \
+	BL_EXPORT u##bits __intrinsic_atomic_xchg_i##bits(u##bits *ptr, u##bits v, s32 order) {              \
+		return __atomic_exchange_n(ptr, v, __ATOMIC_SEQ_CST);                                            \
+	}                                                                                                    \
+	BL_EXPORT void __intrinsic_atomic_store_i##bits(u##bits *ptr, u##bits v, s32 order) {                \
+		__atomic_store_n(ptr, v, __ATOMIC_SEQ_CST);                                                      \
+	}                                                                                                    \
+	BL_EXPORT bool __intrinsic_atomic_cmpxchg_i##bits(u##bits *ptr, u##bits *expected, u##bits desired, s32 order) { \
+		return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); \
+	}                                                                                                    \
+	ATOMIC_FETCH_OP(bits, add)                                                                           \
+	ATOMIC_FETCH_OP(bits, sub)                                                                           \
+	ATOMIC_FETCH_OP(bits, and)                                                                           \
+	ATOMIC_FETCH_OP(bits, or)                                                                            \
+	ATOMIC_FETCH_OP(bits, xor)
+
+#define ATOMIC_FETCH_OP(bits, op)                                                                        \
+	BL_EXPORT u##bits __intrinsic_atomic_##op##_i##bits(u##bits *ptr, u##bits v, s32 order) {            \
+		return __atomic_fetch_##op(ptr, v, __ATOMIC_SEQ_CST);                                            \
+	}
+
+BL_EXPORT void __intrinsic_atomic_fence(s32 order) {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#endif
+
+ATOMIC_INTRINSICS(8)
+ATOMIC_INTRINSICS(16)
+ATOMIC_INTRINSICS(32)
+ATOMIC_INTRINSICS(64)
+
+#undef ATOMIC_INTRINSICS
+#undef ATOMIC_FETCH_OP
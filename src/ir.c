@@ -61,11 +61,16 @@ struct context {
 
 	hash_table(struct cache_entry) gstring_cache;
 	hash_table(struct cache_entry) llvm_fn_cache;
+	hash_table(struct cache_entry) rtti_data_cache;
 	array(struct rtti_incomplete) incomplete_rtti;
+	s32 rtti_bytes;
 
 	struct builtin_types *builtin_types;
 	bool                  generate_debug_info;
+	// Variables and types are not emitted in line tables only mode.
+	bool generate_debug_info_types;
 	array(struct mir_type *) di_incomplete_types;
+	LLVMMetadataRef llvm_di_empty_fn_type;
 
 	// intrinsics
 	LLVMValueRef intrinsic_memset;
@@ -73,6 +78,10 @@ struct context {
 	LLVMValueRef intrinsic_memcpy;
 	LLVMTypeRef  intrinsic_memcpy_type;
 
+	// Lazily generated CPU feature detection used by target clone resolvers.
+	LLVMValueRef llvm_cpu_features_fn;
+	LLVMTypeRef  llvm_cpu_features_fn_type;
+
 	// stats
 	s64 emit_instruction_count;
 };
@@ -92,6 +101,7 @@ static LLVMValueRef build_call_memcpy(struct context *ctx, LLVMValueRef src, LLV
 // RTTI
 // =================================================================================================
 static LLVMValueRef rtti_emit(struct context *ctx, struct mir_type *type);
+static LLVMValueRef rtti_emit_data(struct context *ctx, LLVMValueRef llvm_data, const char *name);
 static void         rtti_satisfy_incomplete(struct context *ctx, struct rtti_incomplete incomplete);
 static LLVMValueRef _rtti_emit(struct context *ctx, struct mir_type *type);
 static LLVMValueRef rtti_emit_base(struct context    *ctx,
@@ -119,6 +129,12 @@ static LLVMValueRef rtti_emit_fn_group(struct context *ctx, struct mir_type *typ
 static LLVMValueRef rtti_emit_fn_slice(struct context *ctx, mir_types_t *fns);
 static LLVMValueRef rtti_emit_fn_array(struct context *ctx, mir_types_t *fns);
 
+// =================================================================================================
+// Function multiversioning
+// =================================================================================================
+static void emit_target_clones(struct context *ctx, struct mir_fn *fn);
+static LLVMValueRef emit_intrinsic_helper(struct context *ctx, struct mir_fn *fn);
+
 // =================================================================================================
 // Debug info
 // =================================================================================================
@@ -190,7 +206,7 @@ static inline LLVMTypeRef get_type(struct context *ctx, struct mir_type *t) {
 	bassert(t->kind != MIR_TYPE_FN_GROUP);
 	bassert(t->kind != MIR_TYPE_NAMED_SCOPE);
 	bassert(t->kind != MIR_TYPE_PLACEHOLDER);
-	if (ctx->generate_debug_info && !t->llvm_meta) {
+	if (ctx->generate_debug_info_types && !t->llvm_meta) {
 		DI_type_init(ctx, t);
 	}
 	return t->llvm_type;
@@ -384,6 +400,16 @@ LLVMMetadataRef DI_type_init(struct context *ctx, struct mir_type *type) {
 		// @Incomplete: Check this https://dwarfstd.org/doc/dwarf_1_1_0.pdf
 		LLVMMetadataRef llvm_subrange =
 		    LLVMDIBuilderGetOrCreateSubrange(ctx->llvm_di_builder, 0, type->data.array.len);
+		if (type->data.array.is_vector) {
+			type->llvm_meta =
+			    LLVMDIBuilderCreateVectorType(ctx->llvm_di_builder,
+			                                  (u64)type->size_bits,
+			                                  (u32)type->alignment * 8,
+			                                  DI_type_init(ctx, type->data.array.elem_type),
+			                                  &llvm_subrange,
+			                                  1);
+			break;
+		}
 		type->llvm_meta =
 		    LLVMDIBuilderCreateArrayType(ctx->llvm_di_builder,
 		                                 (u64)type->data.array.len,
@@ -628,23 +654,25 @@ void emit_DI_fn(struct context *ctx, struct mir_fn *fn) {
 	struct location *location  = fn->decl_node->location;
 	LLVMMetadataRef  llvm_file = DI_unit_init(ctx, location->unit);
 	bassert(llvm_file && "Missing DI file scope data!");
-	const str_t name          = fn->id ? fn->id->str : fn->linkage_name;
-	const str_t linkage_name  = fn->linkage_name;
-	const bool  is_optimized  = ctx->assembly->target->opt != ASSEMBLY_OPT_DEBUG;
-	fn->body_scope->llvm_meta = LLVMDIBuilderCreateFunction(ctx->llvm_di_builder,
-	                                                        llvm_file,
-	                                                        name.ptr,
-	                                                        (uint64_t)name.len,
-	                                                        linkage_name.ptr,
-	                                                        (uint64_t)linkage_name.len,
-	                                                        llvm_file,
-	                                                        (u32)location->line,
-	                                                        fn->type->llvm_meta,
-	                                                        false,
-	                                                        true,
-	                                                        (u32)location->line,
-	                                                        LLVMDIFlagPrototyped,
-	                                                        is_optimized);
+	const str_t name         = fn->id ? fn->id->str : fn->linkage_name;
+	const str_t linkage_name = fn->linkage_name;
+	const bool  is_optimized = ctx->assembly->target->opt != ASSEMBLY_OPT_DEBUG;
+	// Function types are not generated in line tables only mode.
+	LLVMMetadataRef llvm_fn_type = ctx->generate_debug_info_types ? fn->type->llvm_meta : ctx->llvm_di_empty_fn_type;
+	fn->body_scope->llvm_meta    = LLVMDIBuilderCreateFunction(ctx->llvm_di_builder,
+	                                                           llvm_file,
+	                                                           name.ptr,
+	                                                           (uint64_t)name.len,
+	                                                           linkage_name.ptr,
+	                                                           (uint64_t)linkage_name.len,
+	                                                           llvm_file,
+	                                                           (u32)location->line,
+	                                                           llvm_fn_type,
+	                                                           false,
+	                                                           true,
+	                                                           (u32)location->line,
+	                                                           LLVMDIFlagPrototyped,
+	                                                           is_optimized);
 	LLVMSetSubprogram(fn->llvm_value, fn->body_scope->llvm_meta);
 }
 
@@ -727,7 +755,7 @@ LLVMValueRef emit_global_var_proto(struct context *ctx, struct mir_var *var) {
 		LLVMSetThreadLocalMode(var->llvm_value, LLVMGeneralDynamicTLSModel);
 	}
 	const bool emit_DI =
-	    ctx->generate_debug_info && isnotflag(var->iflags, MIR_VAR_IMPLICIT) && var->decl_node;
+	    ctx->generate_debug_info_types && isnotflag(var->iflags, MIR_VAR_IMPLICIT) && var->decl_node;
 	if (emit_DI) emit_DI_var(ctx, var);
 	return var->llvm_value;
 }
@@ -735,6 +763,9 @@ LLVMValueRef emit_global_var_proto(struct context *ctx, struct mir_var *var) {
 LLVMValueRef emit_fn_proto(struct context *ctx, struct mir_fn *fn, bool schedule_full_generation) {
 	bassert(fn);
 	str_t linkage_name = str_empty;
+	if (isflag(fn->flags, FLAG_INTRINSIC) && (is_atomic_intrinsic(fn->linkage_name) || str_match(fn->linkage_name, cstr("prefetch")))) {
+		return fn->llvm_value = emit_intrinsic_helper(ctx, fn);
+	}
 	if (isflag(fn->flags, FLAG_INTRINSIC)) {
 		linkage_name = get_intrinsic(fn->linkage_name);
 		bassert(linkage_name.len && "Unknown LLVM intrinsic!");
@@ -807,6 +838,29 @@ LLVMValueRef emit_fn_proto(struct context *ctx, struct mir_fn *fn, bool schedule
 		LLVMAttributeRef llvm_attr = llvm_create_enum_attribute(ctx->llvm_cnt, LLVM_ATTR_NOINLINE, 0);
 		LLVMAddAttributeAtIndex(fn->llvm_value, (unsigned)LLVMAttributeFunctionIndex, llvm_attr);
 	}
+	if (isflag(fn->flags, FLAG_HOT)) {
+		bassert(!isflag(fn->flags, FLAG_COLD));
+		LLVMAttributeRef llvm_attr = llvm_create_enum_attribute(ctx->llvm_cnt, LLVM_ATTR_HOT, 0);
+		LLVMAddAttributeAtIndex(fn->llvm_value, (unsigned)LLVMAttributeFunctionIndex, llvm_attr);
+	}
+	if (isflag(fn->flags, FLAG_COLD)) {
+		bassert(!isflag(fn->flags, FLAG_HOT));
+		LLVMAttributeRef llvm_attr = llvm_create_enum_attribute(ctx->llvm_cnt, LLVM_ATTR_COLD, 0);
+		LLVMAddAttributeAtIndex(fn->llvm_value, (unsigned)LLVMAttributeFunctionIndex, llvm_attr);
+	}
+	if (isnotflag(fn->flags, FLAG_EXTERN) && isnotflag(fn->flags, FLAG_INTRINSIC)) {
+		// Selected CPU and features are visible to the optimizer per function.
+		const char *cpu      = ctx->assembly->llvm.cpu;
+		const char *features = ctx->assembly->llvm.features;
+		if (cpu[0]) {
+			LLVMAttributeRef llvm_attr = llvm_create_string_attribute(ctx->llvm_cnt, cstr("target-cpu"), make_str_from_c(cpu));
+			LLVMAddAttributeAtIndex(fn->llvm_value, (unsigned)LLVMAttributeFunctionIndex, llvm_attr);
+		}
+		if (features[0]) {
+			LLVMAttributeRef llvm_attr = llvm_create_string_attribute(ctx->llvm_cnt, cstr("target-features"), make_str_from_c(features));
+			LLVMAddAttributeAtIndex(fn->llvm_value, (unsigned)LLVMAttributeFunctionIndex, llvm_attr);
+		}
+	}
 	if (isflag(fn->flags, FLAG_EXPORT)) {
 		bassert(fn->is_global && "Exported function is supposed to be global!");
 		LLVMSetVisibility(fn->llvm_value, LLVMDefaultVisibility);
@@ -1069,11 +1123,7 @@ LLVMValueRef rtti_emit_enum_variants_array(struct context *ctx, mir_variants_t *
 	LLVMValueRef llvm_result =
 	    LLVMConstArray(get_type(ctx, elem_type), sarrdata(&llvm_vals), (u32)sarrlenu(&llvm_vals));
 
-	LLVMValueRef llvm_rtti_var =
-	    LLVMAddGlobal(ctx->llvm_module, LLVMTypeOf(llvm_result), ".rtti_variants");
-	LLVMSetLinkage(llvm_rtti_var, LLVMPrivateLinkage);
-	LLVMSetGlobalConstant(llvm_rtti_var, true);
-	LLVMSetInitializer(llvm_rtti_var, llvm_result);
+	LLVMValueRef llvm_rtti_var = rtti_emit_data(ctx, llvm_result, ".rtti_variants");
 
 	sarrfree(&llvm_vals);
 	return llvm_rtti_var;
@@ -1170,11 +1220,7 @@ LLVMValueRef rtti_emit_struct_members_array(struct context *ctx, mir_members_t *
 	LLVMValueRef llvm_result =
 	    LLVMConstArray(get_type(ctx, elem_type), sarrdata(&llvm_vals), (u32)sarrlenu(&llvm_vals));
 
-	LLVMValueRef llvm_rtti_var =
-	    LLVMAddGlobal(ctx->llvm_module, LLVMTypeOf(llvm_result), ".rtti_members");
-	LLVMSetLinkage(llvm_rtti_var, LLVMPrivateLinkage);
-	LLVMSetGlobalConstant(llvm_rtti_var, true);
-	LLVMSetInitializer(llvm_rtti_var, llvm_result);
+	LLVMValueRef llvm_rtti_var = rtti_emit_data(ctx, llvm_result, ".rtti_members");
 
 	sarrfree(&llvm_vals);
 	return llvm_rtti_var;
@@ -1254,11 +1300,7 @@ LLVMValueRef rtti_emit_fn_array(struct context *ctx, mir_types_t *fns) {
 	LLVMValueRef llvm_result =
 	    LLVMConstArray(get_type(ctx, elem_type), sarrdata(&llvm_vals), (u32)sarrlenu(&llvm_vals));
 
-	LLVMValueRef llvm_rtti_var =
-	    LLVMAddGlobal(ctx->llvm_module, LLVMTypeOf(llvm_result), ".rtti_args");
-	LLVMSetLinkage(llvm_rtti_var, LLVMPrivateLinkage);
-	LLVMSetGlobalConstant(llvm_rtti_var, true);
-	LLVMSetInitializer(llvm_rtti_var, llvm_result);
+	LLVMValueRef llvm_rtti_var = rtti_emit_data(ctx, llvm_result, ".rtti_args");
 	sarrfree(&llvm_vals);
 	return llvm_rtti_var;
 }
@@ -1286,11 +1328,7 @@ LLVMValueRef rtti_emit_fn_args_array(struct context *ctx, mir_args_t *args) {
 	LLVMValueRef llvm_result =
 	    LLVMConstArray(get_type(ctx, elem_type), sarrdata(&llvm_vals), (u32)sarrlenu(&llvm_vals));
 
-	LLVMValueRef llvm_rtti_var =
-	    LLVMAddGlobal(ctx->llvm_module, LLVMTypeOf(llvm_result), ".rtti_args");
-	LLVMSetLinkage(llvm_rtti_var, LLVMPrivateLinkage);
-	LLVMSetGlobalConstant(llvm_rtti_var, true);
-	LLVMSetInitializer(llvm_rtti_var, llvm_result);
+	LLVMValueRef llvm_rtti_var = rtti_emit_data(ctx, llvm_result, ".rtti_args");
 
 	sarrfree(&llvm_vals);
 	return llvm_rtti_var;
@@ -1362,7 +1400,7 @@ LLVMValueRef rtti_emit_ptr(struct context *ctx, struct mir_type *type) {
 
 LLVMValueRef rtti_emit_array(struct context *ctx, struct mir_type *type) {
 	struct mir_type *rtti_type = ctx->builtin_types->t_TypeInfoArray;
-	LLVMValueRef     llvm_vals[4];
+	LLVMValueRef     llvm_vals[5];
 
 	struct mir_type *base_type = mir_get_struct_elem_type(rtti_type, 0);
 	llvm_vals[0] =
@@ -1380,9 +1418,48 @@ LLVMValueRef rtti_emit_array(struct context *ctx, struct mir_type *type) {
 	llvm_vals[3]              = LLVMConstInt(
         get_type(ctx, len_type), (u32)type->data.array.len, len_type->data.integer.is_signed);
 
+	// is_vector
+	const bool       is_vector      = type->data.array.is_vector;
+	struct mir_type *is_vector_type = mir_get_struct_elem_type(rtti_type, 4);
+	llvm_vals[4]                    = LLVMConstInt(
+        get_type(ctx, is_vector_type), (u64)is_vector, is_vector_type->data.integer.is_signed);
+
 	return LLVMConstNamedStruct(get_type(ctx, rtti_type), llvm_vals, static_arrlenu(llvm_vals));
 }
 
+// Emit constant RTTI data array (members, variants, arguments...) as private global variable.
+// Identical arrays are emitted only once, LLVM constants are uniqued, so the same initializer
+// value means the same content.
+LLVMValueRef rtti_emit_data(struct context *ctx, LLVMValueRef llvm_data, const char *name) {
+	const usize  ptr   = (usize)llvm_data;
+	const hash_t hash  = hashcomb((hash_t)ptr, (hash_t)((u64)ptr >> 32));
+	const s64    index = tbl_lookup_index(ctx->rtti_data_cache, hash);
+	if (index != -1) {
+		LLVMValueRef llvm_cached = ctx->rtti_data_cache[index].value;
+		if (LLVMGetInitializer(llvm_cached) == llvm_data) return llvm_cached;
+	}
+
+	LLVMValueRef llvm_rtti_var = LLVMAddGlobal(ctx->llvm_module, LLVMTypeOf(llvm_data), name);
+	LLVMSetLinkage(llvm_rtti_var, LLVMPrivateLinkage);
+	LLVMSetGlobalConstant(llvm_rtti_var, true);
+	LLVMSetInitializer(llvm_rtti_var, llvm_data);
+	ctx->rtti_bytes += (s32)LLVMStoreSizeOfType(ctx->llvm_td, LLVMTypeOf(llvm_data));
+
+	// Colliding hashes are not cached.
+	if (index == -1) {
+		struct cache_entry entry = {
+		    .hash  = hash,
+		    .value = llvm_rtti_var,
+		};
+		tbl_insert(ctx->rtti_data_cache, entry);
+	}
+	return llvm_rtti_var;
+}
+
+// Type info is emitted only from generated 'typeinfo' and 'to any' instructions (see
+// 'emit_instr_type_info' and 'emit_instr_toany'), and these are generated only for functions reachable
+// from exported instructions (see 'ir_run'). Unused private RTTI globals left after optimization are
+// removed by LLVM global DCE.
 LLVMValueRef rtti_emit(struct context *ctx, struct mir_type *type) {
 	LLVMValueRef llvm_value = _rtti_emit(ctx, type);
 
@@ -1413,10 +1490,11 @@ LLVMValueRef _rtti_emit(struct context *ctx, struct mir_type *type) {
 		return rtti_var->llvm_value;
 	}
 
-	LLVMValueRef llvm_rtti_var = llvm_add_global(
-	    ctx->llvm_module, get_type(ctx, rtti_var->value.type), rtti_var->linkage_name);
+	LLVMTypeRef  llvm_rtti_type = get_type(ctx, rtti_var->value.type);
+	LLVMValueRef llvm_rtti_var  = llvm_add_global(ctx->llvm_module, llvm_rtti_type, rtti_var->linkage_name);
 	LLVMSetLinkage(llvm_rtti_var, LLVMPrivateLinkage);
 	LLVMSetGlobalConstant(llvm_rtti_var, true);
+	ctx->rtti_bytes += (s32)LLVMStoreSizeOfType(ctx->llvm_td, llvm_rtti_type);
 
 	LLVMValueRef llvm_value = NULL;
 
@@ -1947,7 +2025,9 @@ enum state emit_instr_unop(struct context *ctx, struct mir_instr_unop *unop) {
 	LLVMValueRef llvm_val = unop->expr->llvm_value;
 	bassert(llvm_val);
 
-	LLVMTypeKind lhs_kind   = LLVMGetTypeKind(LLVMTypeOf(llvm_val));
+	LLVMTypeRef llvm_type = LLVMTypeOf(llvm_val);
+	if (LLVMGetTypeKind(llvm_type) == LLVMVectorTypeKind) llvm_type = LLVMGetElementType(llvm_type);
+	LLVMTypeKind lhs_kind   = LLVMGetTypeKind(llvm_type);
 	const bool   float_kind = lhs_kind == LLVMFloatTypeKind || lhs_kind == LLVMDoubleTypeKind;
 
 	switch (unop->op) {
@@ -2053,7 +2133,11 @@ LLVMValueRef _emit_instr_compound_comptime(struct context *ctx, struct mir_instr
 			bassert(LLVMIsConstant(llvm_elem) && "Expected constant!");
 			sarrput(&llvm_elems, llvm_elem);
 		}
-		cmp->base.llvm_value = LLVMConstArray(llvm_elem_type, sarrdata(&llvm_elems), len);
+		if (type->data.array.is_vector) {
+			cmp->base.llvm_value = LLVMConstVector(sarrdata(&llvm_elems), len);
+		} else {
+			cmp->base.llvm_value = LLVMConstArray(llvm_elem_type, sarrdata(&llvm_elems), len);
+		}
 		sarrfree(&llvm_elems);
 		break;
 	}
@@ -2195,7 +2279,10 @@ enum state emit_instr_binop(struct context *ctx, struct mir_instr_binop *binop)
 	LLVMValueRef rhs = binop->rhs->llvm_value;
 	bassert(lhs && rhs);
 
-	struct mir_type *type           = binop->lhs->value.type;
+	struct mir_type *type = binop->lhs->value.type;
+	// SIMD vectors map directly to LLVM vector operations, we only need the lane type here.
+	const bool is_vector = mir_is_vector_type(type);
+	if (is_vector) type = type->data.array.elem_type;
 	const bool       real_type      = type->kind == MIR_TYPE_REAL;
 	const bool       signed_integer = type->kind == MIR_TYPE_INT && type->data.integer.is_signed;
 	DI_LOCATION_SET(&binop->base);
@@ -2310,6 +2397,10 @@ enum state emit_instr_binop(struct context *ctx, struct mir_instr_binop *binop)
 	default:
 		babort("Invalid binary operation.");
 	}
+	if (is_vector && ast_binop_is_logic(binop->op)) {
+		// Vector comparison produce vector of i1, we extend it to the lane mask.
+		binop->base.llvm_value = LLVMBuildSExt(ctx->llvm_builder, binop->base.llvm_value, get_type(ctx, binop->base.value.type), "");
+	}
 	DI_LOCATION_RESET();
 	return STATE_PASSED;
 }
@@ -2548,7 +2639,7 @@ enum state emit_instr_decl_var(struct context *ctx, struct mir_instr_decl_var *d
 	// user definition in code. @CLEANUP This is little bit confusing, we should unify meaning of
 	// `implicit` across the compiler.
 	const bool emit_DI =
-	    ctx->generate_debug_info && isnotflag(var->iflags, MIR_VAR_IMPLICIT) && var->decl_node;
+	    ctx->generate_debug_info_types && isnotflag(var->iflags, MIR_VAR_IMPLICIT) && var->decl_node;
 
 	// Skip when we should not generate LLVM representation
 	if (!mir_type_has_llvm_representation(var->value.type)) return STATE_PASSED;
@@ -2763,8 +2854,12 @@ enum state emit_instr_const(struct context *ctx, struct mir_instr_const *c) {
 			bassert(tmp.base.llvm_value);
 			sarrput(&llvm_elems, tmp.base.llvm_value);
 		}
-		llvm_value =
-		    LLVMConstArray(elem_type->llvm_type, sarrdata(&llvm_elems), sarrlen(&llvm_elems));
+		if (type->data.array.is_vector) {
+			llvm_value = LLVMConstVector(sarrdata(&llvm_elems), sarrlen(&llvm_elems));
+		} else {
+			llvm_value =
+			    LLVMConstArray(elem_type->llvm_type, sarrdata(&llvm_elems), sarrlen(&llvm_elems));
+		}
 		sarrfree(&llvm_elems);
 		break;
 	}
@@ -2787,6 +2882,14 @@ enum state emit_instr_cond_br(struct context *ctx, struct mir_instr_cond_br *br)
 	DI_LOCATION_SET(&br->base);
 	br->base.llvm_value =
 	    LLVMBuildCondBr(ctx->llvm_builder, llvm_cond, llvm_then_block, llvm_else_block);
+	if (br->hint != BRANCH_HINT_NONE) {
+		// Same weights as produced by 'llvm.expect' lowering.
+		const u32 likely_weight   = 2000;
+		const u32 unlikely_weight = 1;
+		const u32 then_weight     = br->hint == BRANCH_HINT_LIKELY ? likely_weight : unlikely_weight;
+		const u32 else_weight     = br->hint == BRANCH_HINT_LIKELY ? unlikely_weight : likely_weight;
+		llvm_set_branch_weights(br->base.llvm_value, then_weight, else_weight);
+	}
 	DI_LOCATION_RESET();
 	return STATE_PASSED;
 }
@@ -2978,6 +3081,476 @@ void emit_allocas(struct context *ctx, struct mir_fn *fn) {
 	}
 }
 
+// =================================================================================================
+// Function multiversioning
+// =================================================================================================
+// Function marked with #target_clones is emitted in several variants compiled for different CPU
+// feature sets. Original symbol name is used for ELF indirect function (ifunc); its resolver
+// detects CPU features using 'cpuid' and picks the best variant when the binary is loaded.
+
+enum cpu_feature_state {
+	CPU_FEATURE_STATE_NONE,
+	CPU_FEATURE_STATE_AVX,    // Requires OS support of AVX registers.
+	CPU_FEATURE_STATE_AVX512, // Requires OS support of AVX-512 registers.
+};
+
+// Leaf 0x80000001 of cpuid.
+#define CPUID_EXT 0x80000001
+
+struct cpu_feature {
+	const char            *name;
+	u32                    leaf;
+	u32                    reg; // eax, ebx, ecx, edx
+	u32                    bit;
+	enum cpu_feature_state state;
+};
+
+static const struct cpu_feature cpu_features[] = {
+    {"sse3", 1, 2, 0, CPU_FEATURE_STATE_NONE},
+    {"pclmul", 1, 2, 1, CPU_FEATURE_STATE_NONE},
+    {"ssse3", 1, 2, 9, CPU_FEATURE_STATE_NONE},
+    {"fma", 1, 2, 12, CPU_FEATURE_STATE_AVX},
+    {"cx16", 1, 2, 13, CPU_FEATURE_STATE_NONE},
+    {"sse4.1", 1, 2, 19, CPU_FEATURE_STATE_NONE},
+    {"sse4.2", 1, 2, 20, CPU_FEATURE_STATE_NONE},
+    {"movbe", 1, 2, 22, CPU_FEATURE_STATE_NONE},
+    {"popcnt", 1, 2, 23, CPU_FEATURE_STATE_NONE},
+    {"aes", 1, 2, 25, CPU_FEATURE_STATE_NONE},
+    {"avx", 1, 2, 28, CPU_FEATURE_STATE_AVX},
+    {"f16c", 1, 2, 29, CPU_FEATURE_STATE_AVX},
+    {"bmi", 7, 1, 3, CPU_FEATURE_STATE_NONE},
+    {"avx2", 7, 1, 5, CPU_FEATURE_STATE_AVX},
+    {"bmi2", 7, 1, 8, CPU_FEATURE_STATE_NONE},
+    {"avx512f", 7, 1, 16, CPU_FEATURE_STATE_AVX512},
+    {"avx512dq", 7, 1, 17, CPU_FEATURE_STATE_AVX512},
+    {"avx512cd", 7, 1, 28, CPU_FEATURE_STATE_AVX512},
+    {"avx512bw", 7, 1, 30, CPU_FEATURE_STATE_AVX512},
+    {"avx512vl", 7, 1, 31, CPU_FEATURE_STATE_AVX512},
+    {"lzcnt", CPUID_EXT, 2, 5, CPU_FEATURE_STATE_NONE},
+};
+
+// Micro-architecture levels usable as 'arch=<level>'.
+static const char *cpu_levels[][2] = {
+    {"x86-64-v2", "cx16+popcnt+sse3+sse4.1+sse4.2+ssse3"},
+    {"x86-64-v3", "cx16+popcnt+sse3+sse4.1+sse4.2+ssse3+avx+avx2+bmi+bmi2+f16c+fma+lzcnt+movbe"},
+    {"x86-64-v4", "cx16+popcnt+sse3+sse4.1+sse4.2+ssse3+avx+avx2+bmi+bmi2+f16c+fma+lzcnt+movbe+avx512f+avx512bw+avx512cd+avx512dq+avx512vl"},
+};
+
+struct target_clone {
+	str_t cpu;  // Optional.
+	u64   mask; // Bits of required features in cpu_features table.
+};
+
+static bool target_clone_add_features(str_t features, struct target_clone *clone) {
+	while (features.len) {
+		s32 len = 0;
+		while (len < features.len && features.ptr[len] != '+') ++len;
+		const str_t name  = make_str(features.ptr, len);
+		bool        found = false;
+		for (usize i = 0; i < static_arrlenu(cpu_features); ++i) {
+			if (!str_match(name, make_str_from_c(cpu_features[i].name))) continue;
+			clone->mask |= 1ull << i;
+			found = true;
+			break;
+		}
+		if (!found) return false;
+		features.ptr += MIN(len + 1, features.len);
+		features.len -= MIN(len + 1, features.len);
+	}
+	return true;
+}
+
+static bool target_clone_parse(str_t variant, struct target_clone *clone) {
+	const str_t arch = cstr("arch=");
+	if (variant.len > arch.len && str_match(make_str(variant.ptr, arch.len), arch)) {
+		const str_t level = make_str(variant.ptr + arch.len, variant.len - arch.len);
+		for (usize i = 0; i < static_arrlenu(cpu_levels); ++i) {
+			if (!str_match(level, make_str_from_c(cpu_levels[i][0]))) continue;
+			clone->cpu = level;
+			return target_clone_add_features(make_str_from_c(cpu_levels[i][1]), clone);
+		}
+		return false;
+	}
+	return variant.len && target_clone_add_features(variant, clone);
+}
+
+static LLVMValueRef build_cpuid(struct context *ctx, LLVMBuilderRef builder, u32 leaf) {
+	LLVMTypeRef  llvm_i32         = get_type(ctx, ctx->builtin_types->t_u32);
+	LLVMTypeRef  llvm_ret_types[] = {llvm_i32, llvm_i32, llvm_i32, llvm_i32};
+	LLVMTypeRef  llvm_arg_types[] = {llvm_i32, llvm_i32};
+	LLVMTypeRef  llvm_ret_type    = llvm_struct_type_in_context(ctx->llvm_cnt, llvm_ret_types, 4, false);
+	LLVMTypeRef  llvm_fn_type     = LLVMFunctionType(llvm_ret_type, llvm_arg_types, 2, false);
+	const char   asm_str[]        = "cpuid";
+	const char   constraints[]    = "={ax},={bx},={cx},={dx},{ax},{cx}";
+	LLVMValueRef llvm_asm         = LLVMGetInlineAsm(llvm_fn_type, (char *)asm_str, sizeof(asm_str) - 1, (char *)constraints, sizeof(constraints) - 1, false, false, LLVMInlineAsmDialectATT, false);
+	LLVMValueRef llvm_args[]      = {LLVMConstInt(llvm_i32, leaf, false), LLVMConstInt(llvm_i32, 0, false)};
+	return LLVMBuildCall2(builder, llvm_fn_type, llvm_asm, llvm_args, 2, "");
+}
+
+// Generate function returning mask of CPU features available at runtime (bits matching the
+// cpu_features table).
+static LLVMValueRef get_cpu_features_fn(struct context *ctx) {
+	if (ctx->llvm_cpu_features_fn) return ctx->llvm_cpu_features_fn;
+	LLVMTypeRef llvm_i32 = get_type(ctx, ctx->builtin_types->t_u32);
+	LLVMTypeRef llvm_i64 = get_type(ctx, ctx->builtin_types->t_u64);
+
+	LLVMTypeRef  llvm_fn_type = LLVMFunctionType(llvm_i64, NULL, 0, false);
+	LLVMValueRef llvm_fn      = llvm_add_function(ctx->llvm_module, cstr(".bl.cpu_features"), llvm_fn_type);
+	LLVMSetLinkage(llvm_fn, LLVMInternalLinkage);
+
+	LLVMBuilderRef    builder    = llvm_create_builder_in_context(ctx->llvm_cnt);
+	LLVMBasicBlockRef llvm_entry = llvm_append_basic_block_in_context(ctx->llvm_cnt, llvm_fn, cstr("entry"));
+	LLVMBasicBlockRef llvm_xcr   = llvm_append_basic_block_in_context(ctx->llvm_cnt, llvm_fn, cstr("xgetbv"));
+	LLVMBasicBlockRef llvm_done  = llvm_append_basic_block_in_context(ctx->llvm_cnt, llvm_fn, cstr("done"));
+
+	LLVMPositionBuilderAtEnd(builder, llvm_entry);
+	LLVMValueRef llvm_zero = LLVMConstInt(llvm_i32, 0, false);
+	// Leaf 7 and extended leaf are used only if supported.
+	LLVMValueRef llvm_max_leaf     = LLVMBuildExtractValue(builder, build_cpuid(ctx, builder, 0), 0, "");
+	LLVMValueRef llvm_max_ext_leaf = LLVMBuildExtractValue(builder, build_cpuid(ctx, builder, 0x80000000), 0, "");
+	LLVMValueRef llvm_has_7        = LLVMBuildICmp(builder, LLVMIntUGE, llvm_max_leaf, LLVMConstInt(llvm_i32, 7, false), "");
+	LLVMValueRef llvm_has_ext      = LLVMBuildICmp(builder, LLVMIntUGE, llvm_max_ext_leaf, LLVMConstInt(llvm_i32, CPUID_EXT, false), "");
+
+	LLVMValueRef llvm_leaf_1   = build_cpuid(ctx, builder, 1);
+	LLVMValueRef llvm_leaf_7   = build_cpuid(ctx, builder, 7);
+	LLVMValueRef llvm_leaf_ext = build_cpuid(ctx, builder, CPUID_EXT);
+	LLVMValueRef llvm_regs[3][4];
+	for (u32 i = 0; i < 4; ++i) {
+		llvm_regs[0][i] = LLVMBuildExtractValue(builder, llvm_leaf_1, i, "");
+		llvm_regs[1][i] = LLVMBuildSelect(builder, llvm_has_7, LLVMBuildExtractValue(builder, llvm_leaf_7, i, ""), llvm_zero, "");
+		llvm_regs[2][i] = LLVMBuildSelect(builder, llvm_has_ext, LLVMBuildExtractValue(builder, llvm_leaf_ext, i, ""), llvm_zero, "");
+	}
+	// The xgetbv instruction is available only when OSXSAVE is set.
+	LLVMValueRef llvm_osxsave = LLVMBuildAnd(builder, llvm_regs[0][2], LLVMConstInt(llvm_i32, 1u << 27, false), "");
+	LLVMBuildCondBr(builder, LLVMBuildICmp(builder, LLVMIntNE, llvm_osxsave, llvm_zero, ""), llvm_xcr, llvm_done);
+
+	LLVMPositionBuilderAtEnd(builder, llvm_xcr);
+	LLVMValueRef llvm_xcr0;
+	{
+		LLVMTypeRef  llvm_ret_types[] = {llvm_i32, llvm_i32};
+		LLVMTypeRef  llvm_ret_type    = llvm_struct_type_in_context(ctx->llvm_cnt, llvm_ret_types, 2, false);
+		LLVMTypeRef  llvm_asm_type    = LLVMFunctionType(llvm_ret_type, &llvm_i32, 1, false);
+		const char   asm_str[]        = "xgetbv";
+		const char   constraints[]    = "={ax},={dx},{cx}";
+		LLVMValueRef llvm_asm         = LLVMGetInlineAsm(llvm_asm_type, (char *)asm_str, sizeof(asm_str) - 1, (char *)constraints, sizeof(constraints) - 1, false, false, LLVMInlineAsmDialectATT, false);
+		LLVMValueRef llvm_call        = LLVMBuildCall2(builder, llvm_asm_type, llvm_asm, &llvm_zero, 1, "");
+		llvm_xcr0                     = LLVMBuildExtractValue(builder, llvm_call, 0, "");
+	}
+	LLVMBuildBr(builder, llvm_done);
+
+	LLVMPositionBuilderAtEnd(builder, llvm_done);
+	LLVMValueRef      llvm_state          = LLVMBuildPhi(builder, llvm_i32, "");
+	LLVMValueRef      llvm_state_values[] = {llvm_zero, llvm_xcr0};
+	LLVMBasicBlockRef llvm_state_blocks[] = {llvm_entry, llvm_xcr};
+	LLVMAddIncoming(llvm_state, llvm_state_values, llvm_state_blocks, 2);
+
+	// XMM and YMM state, OPMASK and ZMM state.
+	const u32    avx_state       = 0x6;
+	const u32    avx512_state    = 0xe6;
+	LLVMValueRef llvm_has_avx    = LLVMBuildICmp(builder, LLVMIntEQ, LLVMBuildAnd(builder, llvm_state, LLVMConstInt(llvm_i32, avx_state, false), ""), LLVMConstInt(llvm_i32, avx_state, false), "");
+	LLVMValueRef llvm_has_avx512 = LLVMBuildICmp(builder, LLVMIntEQ, LLVMBuildAnd(builder, llvm_state, LLVMConstInt(llvm_i32, avx512_state, false), ""), LLVMConstInt(llvm_i32, avx512_state, false), "");
+	LLVMValueRef llvm_mask       = LLVMConstInt(llvm_i64, 0, false);
+	for (usize i = 0; i < static_arrlenu(cpu_features); ++i) {
+		const struct cpu_feature *feature  = &cpu_features[i];
+		const u32                 leaf     = feature->leaf == 1 ? 0 : (feature->leaf == 7 ? 1 : 2);
+		LLVMValueRef              llvm_reg = llvm_regs[leaf][feature->reg];
+		LLVMValueRef              llvm_bit = LLVMBuildAnd(builder, llvm_reg, LLVMConstInt(llvm_i32, 1u << feature->bit, false), "");
+		LLVMValueRef              llvm_has = LLVMBuildICmp(builder, LLVMIntNE, llvm_bit, llvm_zero, "");
+		if (feature->state == CPU_FEATURE_STATE_AVX) llvm_has = LLVMBuildAnd(builder, llvm_has, llvm_has_avx, "");
+		if (feature->state == CPU_FEATURE_STATE_AVX512) llvm_has = LLVMBuildAnd(builder, llvm_has, llvm_has_avx512, "");
+		LLVMValueRef llvm_feature = LLVMBuildShl(builder, LLVMBuildZExt(builder, llvm_has, llvm_i64, ""), LLVMConstInt(llvm_i64, i, false), "");
+		llvm_mask                 = LLVMBuildOr(builder, llvm_mask, llvm_feature, "");
+	}
+	LLVMBuildRet(builder, llvm_mask);
+	LLVMDisposeBuilder(builder);
+
+	ctx->llvm_cpu_features_fn_type = llvm_fn_type;
+	return ctx->llvm_cpu_features_fn = llvm_fn;
+}
+
+void emit_target_clones(struct context *ctx, struct mir_fn *fn) {
+	const struct target *target = ctx->assembly->target;
+
+	array(struct target_clone) clones = NULL;
+	str_t spec                        = fn->target_clones;
+	while (spec.len) {
+		s32 len = 0;
+		while (len < spec.len && spec.ptr[len] != ',') ++len;
+		str_t variant = make_str(spec.ptr, len);
+		while (variant.len && variant.ptr[0] == ' ') ++variant.ptr, --variant.len;
+		while (variant.len && variant.ptr[variant.len - 1] == ' ') --variant.len;
+
+		struct target_clone clone = {0};
+		if (!target_clone_parse(variant, &clone)) {
+			builder_msg(MSG_ERR, ERR_INVALID_DIRECTIVE, fn->decl_node ? fn->decl_node->location : NULL, CARET_WORD, "Invalid target clone '" STR_FMT "', expected list of CPU features separated by '+' or 'arch=<x86-64-v2|x86-64-v3|x86-64-v4>'.", STR_ARG(variant));
+			arrfree(clones);
+			return;
+		}
+		arrput(clones, clone);
+		spec.ptr += MIN(len + 1, spec.len);
+		spec.len -= MIN(len + 1, spec.len);
+	}
+
+	// IFUNC resolvers are not supported by musl.
+	if (target->triple.arch != ARCH_x86_64 || target->triple.os != OS_linux || target->triple.env == ENV_musl) {
+		builder_msg(MSG_WARN, 0, fn->decl_node ? fn->decl_node->location : NULL, CARET_WORD, "Target clones are supported only on x86_64 Linux with glibc, only default variant is generated.");
+		arrfree(clones);
+		return;
+	}
+	if (!arrlenu(clones)) return;
+
+	LLVMValueRef         llvm_default = fn->llvm_value;
+	LLVMTypeRef          llvm_fn_type = get_type(ctx, fn->type);
+	const str_t          name         = fn->linkage_name;
+	const LLVMLinkage    linkage      = LLVMGetLinkage(llvm_default);
+	const LLVMVisibility visibility   = LLVMGetVisibility(llvm_default);
+
+	str_buf_t tmp = get_tmp_str();
+	// Variants are private to the module; the original name belongs to the dispatching ifunc.
+	str_buf_append_fmt(&tmp, "{str}.default", name);
+	LLVMSetValueName2(llvm_default, tmp.ptr, tmp.len);
+
+	array(LLVMValueRef) llvm_variants = NULL;
+	const char *base_features         = ctx->assembly->llvm.features;
+	for (usize i = 0; i < arrlenu(clones); ++i) {
+		struct target_clone *clone = &clones[i];
+		str_buf_clr(&tmp);
+		str_buf_append_fmt(&tmp, "{str}.clone{s32}", name, (s32)i);
+		LLVMValueRef llvm_variant = llvm_clone_function(llvm_default, str_buf_view(tmp));
+
+		str_buf_clr(&tmp);
+		if (base_features[0]) str_buf_append_fmt(&tmp, "{s},", base_features);
+		for (usize j = 0; j < static_arrlenu(cpu_features); ++j) {
+			if (clone->mask & (1ull << j)) str_buf_append_fmt(&tmp, "+{s},", cpu_features[j].name);
+		}
+		--tmp.len; // Trailing comma.
+		LLVMAddAttributeAtIndex(llvm_variant, (unsigned)LLVMAttributeFunctionIndex, llvm_create_string_attribute(ctx->llvm_cnt, cstr("target-features"), str_buf_view(tmp)));
+		if (clone->cpu.len) {
+			LLVMAddAttributeAtIndex(llvm_variant, (unsigned)LLVMAttributeFunctionIndex, llvm_create_string_attribute(ctx->llvm_cnt, cstr("target-cpu"), clone->cpu));
+		}
+		LLVMSetLinkage(llvm_variant, LLVMInternalLinkage);
+		LLVMSetVisibility(llvm_variant, LLVMDefaultVisibility);
+		arrput(llvm_variants, llvm_variant);
+	}
+	LLVMSetLinkage(llvm_default, LLVMInternalLinkage);
+	LLVMSetVisibility(llvm_default, LLVMDefaultVisibility);
+
+	// Resolver returns pointer to the first variant supported by the CPU.
+	LLVMTypeRef llvm_ptr_type      = get_type(ctx, ctx->builtin_types->t_u8_ptr);
+	LLVMTypeRef llvm_resolver_type = LLVMFunctionType(llvm_ptr_type, NULL, 0, false);
+	str_buf_clr(&tmp);
+	str_buf_append_fmt(&tmp, "{str}.resolver", name);
+	LLVMValueRef llvm_resolver = llvm_add_function(ctx->llvm_module, str_buf_view(tmp), llvm_resolver_type);
+	LLVMSetLinkage(llvm_resolver, LLVMInternalLinkage);
+
+	LLVMValueRef llvm_ifunc = LLVMAddGlobalIFunc(ctx->llvm_module, name.ptr, (size_t)name.len, llvm_fn_type, 0, llvm_resolver);
+	LLVMSetLinkage(llvm_ifunc, linkage);
+	LLVMSetVisibility(llvm_ifunc, visibility);
+	LLVMReplaceAllUsesWith(llvm_default, llvm_ifunc);
+
+	LLVMBuilderRef builder = llvm_create_builder_in_context(ctx->llvm_cnt);
+	LLVMPositionBuilderAtEnd(builder, llvm_append_basic_block_in_context(ctx->llvm_cnt, llvm_resolver, cstr("entry")));
+	LLVMValueRef llvm_cpu_features_fn = get_cpu_features_fn(ctx);
+	LLVMTypeRef  llvm_i64             = get_type(ctx, ctx->builtin_types->t_u64);
+	LLVMValueRef llvm_mask            = LLVMBuildCall2(builder, ctx->llvm_cpu_features_fn_type, llvm_cpu_features_fn, NULL, 0, "");
+	LLVMValueRef llvm_result          = llvm_default;
+	// Later variants have lower priority, so the selection is built from the last one.
+	for (usize i = arrlenu(clones); i-- > 0;) {
+		LLVMValueRef llvm_required = LLVMConstInt(llvm_i64, clones[i].mask, false);
+		LLVMValueRef llvm_has      = LLVMBuildICmp(builder, LLVMIntEQ, LLVMBuildAnd(builder, llvm_mask, llvm_required, ""), llvm_required, "");
+		llvm_result                = LLVMBuildSelect(builder, llvm_has, llvm_variants[i], llvm_result, "");
+	}
+	LLVMBuildRet(builder, llvm_result);
+	LLVMDisposeBuilder(builder);
+
+	// All following references use the ifunc.
+	fn->llvm_value     = llvm_ifunc;
+	const hash_t hash  = strhash(name);
+	const s64    index = tbl_lookup_index_with_key(ctx->llvm_fn_cache, hash, name);
+	if (index != -1) ctx->llvm_fn_cache[index].value = llvm_ifunc;
+
+	put_tmp_str(tmp);
+	arrfree(llvm_variants);
+	arrfree(clones);
+}
+
+// Memory orders in the same order as in 'std/atomic' MemoryOrder enum.
+static const LLVMAtomicOrdering atomic_orders[] = {
+    LLVMAtomicOrderingMonotonic,
+    LLVMAtomicOrderingAcquire,
+    LLVMAtomicOrderingRelease,
+    LLVMAtomicOrderingAcquireRelease,
+    LLVMAtomicOrderingSequentiallyConsistent,
+};
+
+static void emit_atomic_operation(struct context *ctx, LLVMBuilderRef builder, LLVMValueRef llvm_fn, LLVMTypeRef llvm_fn_type, str_t op, LLVMAtomicOrdering order) {
+	if (str_match(op, cstr("fence"))) {
+		// There is no relaxed fence.
+		if (order != LLVMAtomicOrderingMonotonic) LLVMBuildFence(builder, order, false, "");
+		LLVMBuildRetVoid(builder);
+		return;
+	}
+
+	LLVMValueRef llvm_ptr = LLVMGetParam(llvm_fn, 0);
+	if (str_match(op, cstr("load"))) {
+		// Release semantics does not make sense for load.
+		if (order == LLVMAtomicOrderingRelease || order == LLVMAtomicOrderingAcquireRelease) {
+			order = LLVMAtomicOrderingSequentiallyConsistent;
+		}
+		LLVMTypeRef  llvm_type  = LLVMGetReturnType(llvm_fn_type);
+		LLVMValueRef llvm_value = LLVMBuildLoad2(builder, llvm_type, llvm_ptr, "");
+		LLVMSetOrdering(llvm_value, order);
+		LLVMSetAlignment(llvm_value, (unsigned)LLVMStoreSizeOfType(ctx->llvm_td, llvm_type));
+		LLVMBuildRet(builder, llvm_value);
+		return;
+	}
+
+	LLVMValueRef llvm_value = LLVMGetParam(llvm_fn, 1);
+	if (str_match(op, cstr("store"))) {
+		// Acquire semantics does not make sense for store.
+		if (order == LLVMAtomicOrderingAcquire || order == LLVMAtomicOrderingAcquireRelease) {
+			order = LLVMAtomicOrderingSequentiallyConsistent;
+		}
+		LLVMValueRef llvm_store = LLVMBuildStore(builder, llvm_value, llvm_ptr);
+		LLVMSetOrdering(llvm_store, order);
+		LLVMSetAlignment(llvm_store, (unsigned)LLVMStoreSizeOfType(ctx->llvm_td, LLVMTypeOf(llvm_value)));
+		LLVMBuildRetVoid(builder);
+		return;
+	}
+
+	if (str_match(op, cstr("cmpxchg"))) {
+		// Failure order cannot contain release semantics.
+		LLVMAtomicOrdering failure_order = order;
+		if (order == LLVMAtomicOrderingRelease) failure_order = LLVMAtomicOrderingMonotonic;
+		if (order == LLVMAtomicOrderingAcquireRelease) failure_order = LLVMAtomicOrderingAcquire;
+
+		LLVMValueRef llvm_desired  = LLVMGetParam(llvm_fn, 2);
+		LLVMValueRef llvm_expected = LLVMBuildLoad2(builder, LLVMTypeOf(llvm_desired), llvm_value, "");
+		LLVMValueRef llvm_result   = LLVMBuildAtomicCmpXchg(builder, llvm_ptr, llvm_expected, llvm_desired, order, failure_order, false);
+		// Expected value is updated to the current one; it's the same in case of success.
+		LLVMBuildStore(builder, LLVMBuildExtractValue(builder, llvm_result, 0, ""), llvm_value);
+		LLVMBuildRet(builder, LLVMBuildExtractValue(builder, llvm_result, 1, ""));
+		return;
+	}
+
+	LLVMAtomicRMWBinOp rmw_op;
+	if (str_match(op, cstr("xchg"))) {
+		rmw_op = LLVMAtomicRMWBinOpXchg;
+	} else if (str_match(op, cstr("add"))) {
+		rmw_op = LLVMAtomicRMWBinOpAdd;
+	} else if (str_match(op, cstr("sub"))) {
+		rmw_op = LLVMAtomicRMWBinOpSub;
+	} else if (str_match(op, cstr("and"))) {
+		rmw_op = LLVMAtomicRMWBinOpAnd;
+	} else if (str_match(op, cstr("or"))) {
+		rmw_op = LLVMAtomicRMWBinOpOr;
+	} else if (str_match(op, cstr("xor"))) {
+		rmw_op = LLVMAtomicRMWBinOpXor;
+	} else {
+		babort("Unknown atomic intrinsic operation '" STR_FMT "'.", STR_ARG(op));
+	}
+	LLVMBuildRet(builder, LLVMBuildAtomicRMW(builder, rmw_op, llvm_ptr, llvm_value, order, false));
+}
+
+// Atomic intrinsics take the memory order as the last argument. The helper switches over all
+// possible orders, so the switch is folded away after inlining when the order is known in
+// compile-time (it's usually the case).
+static void emit_atomic_intrinsic_body(struct context *ctx, LLVMBuilderRef builder, LLVMValueRef llvm_fn, LLVMTypeRef llvm_fn_type, const str_t name) {
+	// Name format is 'atomic.<operation>[.i<bits>]'.
+	str_t op = {.ptr = name.ptr + 7, .len = name.len - 7};
+	for (s32 i = 0; i < op.len; ++i) {
+		if (op.ptr[i] == '.') {
+			op.len = i;
+			break;
+		}
+	}
+
+	LLVMBasicBlockRef llvm_blocks[static_arrlenu(atomic_orders)];
+	for (usize i = 0; i < static_arrlenu(atomic_orders); ++i) {
+		llvm_blocks[i] = llvm_append_basic_block_in_context(ctx->llvm_cnt, llvm_fn, cstr("order"));
+	}
+
+	// Unknown order values fall back to the sequentially consistent one (the last).
+	const usize  default_index = static_arrlenu(atomic_orders) - 1;
+	LLVMValueRef llvm_order    = LLVMGetParam(llvm_fn, LLVMCountParams(llvm_fn) - 1);
+	LLVMValueRef llvm_switch   = LLVMBuildSwitch(builder, llvm_order, llvm_blocks[default_index], (unsigned)default_index);
+	for (usize i = 0; i < default_index; ++i) {
+		LLVMAddCase(llvm_switch, LLVMConstInt(LLVMTypeOf(llvm_order), i, false), llvm_blocks[i]);
+	}
+
+	for (usize i = 0; i < static_arrlenu(atomic_orders); ++i) {
+		LLVMPositionBuilderAtEnd(builder, llvm_blocks[i]);
+		emit_atomic_operation(ctx, builder, llvm_fn, llvm_fn_type, op, atomic_orders[i]);
+	}
+}
+
+// The 'llvm.prefetch' requires read/write and locality arguments to be constants, the helper
+// switches over all valid combinations. Locality out of 0-3 range is treated as 3.
+static void emit_prefetch_intrinsic_body(struct context *ctx, LLVMBuilderRef builder, LLVMValueRef llvm_fn) {
+	LLVMTypeRef  llvm_ptr_type  = get_type(ctx, ctx->builtin_types->t_u8_ptr);
+	LLVMTypeRef  llvm_i32       = get_type(ctx, ctx->builtin_types->t_s32);
+	const u32    id             = LLVMLookupIntrinsicID("llvm.prefetch", 13);
+	LLVMValueRef llvm_prefetch  = LLVMGetIntrinsicDeclaration(ctx->llvm_module, id, &llvm_ptr_type, 1);
+	LLVMTypeRef  llvm_type      = llvm_intrinsic_get_type(ctx->llvm_cnt, id, &llvm_ptr_type, 1);
+	LLVMValueRef llvm_ptr       = LLVMGetParam(llvm_fn, 0);
+	LLVMValueRef llvm_is_write  = LLVMGetParam(llvm_fn, 1);
+	LLVMValueRef llvm_locality  = LLVMGetParam(llvm_fn, 2);
+	const u32    locality_count = 4;
+
+	LLVMBasicBlockRef llvm_rw_blocks[2];
+	for (u32 rw = 0; rw < 2; ++rw) {
+		llvm_rw_blocks[rw] = llvm_append_basic_block_in_context(ctx->llvm_cnt, llvm_fn, cstr("rw"));
+	}
+	LLVMValueRef llvm_rw_switch = LLVMBuildSwitch(builder, llvm_is_write, llvm_rw_blocks[0], 1);
+	LLVMAddCase(llvm_rw_switch, LLVMConstInt(LLVMTypeOf(llvm_is_write), 1, false), llvm_rw_blocks[1]);
+
+	for (u32 rw = 0; rw < 2; ++rw) {
+		LLVMBasicBlockRef llvm_blocks[4];
+		for (u32 i = 0; i < locality_count; ++i) {
+			llvm_blocks[i] = llvm_append_basic_block_in_context(ctx->llvm_cnt, llvm_fn, cstr("locality"));
+		}
+		LLVMPositionBuilderAtEnd(builder, llvm_rw_blocks[rw]);
+		LLVMValueRef llvm_switch = LLVMBuildSwitch(builder, llvm_locality, llvm_blocks[locality_count - 1], locality_count - 1);
+		for (u32 i = 0; i < locality_count - 1; ++i) {
+			LLVMAddCase(llvm_switch, LLVMConstInt(LLVMTypeOf(llvm_locality), i, false), llvm_blocks[i]);
+		}
+		for (u32 i = 0; i < locality_count; ++i) {
+			LLVMPositionBuilderAtEnd(builder, llvm_blocks[i]);
+			// Last argument selects data cache.
+			LLVMValueRef llvm_args[] = {llvm_ptr, LLVMConstInt(llvm_i32, rw, false), LLVMConstInt(llvm_i32, i, false), LLVMConstInt(llvm_i32, 1, false)};
+			LLVMBuildCall2(builder, llvm_type, llvm_prefetch, llvm_args, static_arrlenu(llvm_args), "");
+			LLVMBuildRetVoid(builder);
+		}
+	}
+}
+
+// Intrinsics with arguments required to be constants in LLVM are lowered into small always-inline
+// helper functions.
+LLVMValueRef emit_intrinsic_helper(struct context *ctx, struct mir_fn *fn) {
+	const str_t  name    = fn->linkage_name;
+	LLVMValueRef llvm_fn = llvm_lookup_fn(ctx, name);
+	if (llvm_fn) return llvm_fn;
+
+	LLVMTypeRef llvm_fn_type = get_type(ctx, fn->type);
+	str_buf_t   tmp          = get_tmp_str();
+	str_buf_append_fmt(&tmp, ".bl.{str}", name);
+	llvm_fn = llvm_cache_fn(ctx, name, llvm_add_function(ctx->llvm_module, str_buf_view(tmp), llvm_fn_type));
+	put_tmp_str(tmp);
+	LLVMSetLinkage(llvm_fn, LLVMInternalLinkage);
+	LLVMAddAttributeAtIndex(llvm_fn, (unsigned)LLVMAttributeFunctionIndex, llvm_create_enum_attribute(ctx->llvm_cnt, LLVM_ATTR_ALWAYSINLINE, 0));
+
+	LLVMBuilderRef builder = llvm_create_builder_in_context(ctx->llvm_cnt);
+	LLVMPositionBuilderAtEnd(builder, llvm_append_basic_block_in_context(ctx->llvm_cnt, llvm_fn, cstr("entry")));
+	if (is_atomic_intrinsic(name)) {
+		emit_atomic_intrinsic_body(ctx, builder, llvm_fn, llvm_fn_type, name);
+	} else {
+		bassert(str_match(name, cstr("prefetch")));
+		emit_prefetch_intrinsic_body(ctx, builder, llvm_fn);
+	}
+	LLVMDisposeBuilder(builder);
+	return llvm_fn;
+}
+
 enum state emit_instr_fn_proto(struct context *ctx, struct mir_instr_fn_proto *fn_proto) {
 	struct mir_fn *fn = MIR_CEV_READ_AS(struct mir_fn *, &fn_proto->base.value);
 	bmagic_assert(fn);
@@ -2996,6 +3569,7 @@ enum state emit_instr_fn_proto(struct context *ctx, struct mir_instr_fn_proto *f
 			}
 			block = (struct mir_instr_block *)block->base.next;
 		}
+		if (fn->target_clones.len) emit_target_clones(ctx, fn);
 	}
 
 	return STATE_PASSED;
@@ -3196,6 +3770,7 @@ static void DI_init(struct context *ctx) {
 	                                            1);
 
 	const bool is_optimized = ctx->assembly->target->opt != ASSEMBLY_OPT_DEBUG;
+	const bool line_tables  = !ctx->generate_debug_info_types;
 
 	// create main compile unit
 	LLVMDIBuilderCreateCompileUnit(ctx->llvm_di_builder,
@@ -3209,7 +3784,7 @@ static void DI_init(struct context *ctx) {
 	                               1,
 	                               "",
 	                               0,
-	                               LLVMDWARFEmissionFull,
+	                               line_tables ? LLVMDWARFEmissionLineTablesOnly : LLVMDWARFEmissionFull,
 	                               0,
 	                               false,
 	                               false,
@@ -3218,6 +3793,10 @@ static void DI_init(struct context *ctx) {
 	                               NULL,
 	                               0);
 	// llvm_di_create_compile_unit(ctx->llvm_di_builder, gscope->llvm_meta, producer);
+
+	if (line_tables) {
+		ctx->llvm_di_empty_fn_type = LLVMDIBuilderCreateSubroutineType(ctx->llvm_di_builder, gscope->llvm_meta, NULL, 0, LLVMDIFlagZero);
+	}
 }
 
 static void DI_terminate(struct context *ctx) {
@@ -3243,14 +3822,16 @@ void ir_run(struct assembly *assembly) {
 	ctx.builtin_types       = &assembly->builtin_types;
 	ctx.generate_debug_info = assembly->target->opt == ASSEMBLY_OPT_DEBUG ||
 	                          assembly->target->opt == ASSEMBLY_OPT_RELEASE_WITH_DEBUG_INFO;
-	ctx.llvm_cnt     = assembly->llvm.ctx;
-	ctx.llvm_td      = assembly->llvm.TD;
-	ctx.llvm_builder = llvm_create_builder_in_context(ctx.llvm_cnt);
+	ctx.generate_debug_info_types = ctx.generate_debug_info && assembly->target->di_level == ASSEMBLY_DI_LEVEL_FULL;
+	ctx.llvm_cnt                  = assembly->llvm.ctx;
+	ctx.llvm_td                   = assembly->llvm.TD;
+	ctx.llvm_builder              = llvm_create_builder_in_context(ctx.llvm_cnt);
 
 	qsetcap(&ctx.queue, 1024 * 8);
 
 	tbl_init(ctx.gstring_cache, 2048);
 	tbl_init(ctx.llvm_fn_cache, 2048);
+	tbl_init(ctx.rtti_data_cache, 256);
 
 	init_llvm_module(&ctx);
 
@@ -3287,6 +3868,7 @@ void ir_run(struct assembly *assembly) {
 
 	blog("Generated %d instructions.", ctx.emit_instruction_count);
 	batomic_fetch_add_s32(&assembly->stats.llvm_ms, runtime_measure_end(llvm));
+	batomic_fetch_add_s32(&assembly->stats.rtti_bytes, ctx.rtti_bytes);
 
 	if (!builder.options->do_cleanup_when_done) return_zone();
 
@@ -3299,6 +3881,7 @@ void ir_run(struct assembly *assembly) {
 	arrfree(ctx.incomplete_rtti);
 	tbl_free(ctx.gstring_cache);
 	tbl_free(ctx.llvm_fn_cache);
+	tbl_free(ctx.rtti_data_cache);
 
 	return_zone();
 }
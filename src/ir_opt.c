@@ -1,10 +1,50 @@
 #include "bldebug.h"
 #include "builder.h"
 
+// Validate PGO options and setup linking of the profile runtime.
+static bool pgo_init(struct assembly *assembly) {
+	const struct target *target = assembly->target;
+	switch (target->pgo) {
+	case ASSEMBLY_PGO_GENERATE: {
+		// Instrumented binary needs the profile runtime writing counters at exit. The runtime shipped
+		// with the compiler is used by default, the 'pgo_runtime' config entry can override it (e.g.
+		// 'clang_rt.profile' from LLVM compiler-rt on platforms without the shipped one).
+		const char *runtime = read_config(builder.config, target, "pgo_runtime", "");
+		str_buf_t   tmp     = get_tmp_str();
+		if (!runtime[0]) {
+#if BL_PLATFORM_LINUX
+			str_buf_append_fmt(&tmp, "{str}/../" PGO_RUNTIME_PATH, builder_get_exec_dir());
+#endif
+			if (!tmp.len || !normalize_path(&tmp)) {
+				builder_error("Profile runtime library required by '--pgo=generate' not found, add 'pgo_runtime' "
+				              "entry with path to 'clang_rt.profile' library into the config file.");
+				put_tmp_str(tmp);
+				return false;
+			}
+			runtime = str_buf_to_c(tmp);
+		}
+		assembly_append_linker_options(assembly, runtime);
+		put_tmp_str(tmp);
+		break;
+	}
+	case ASSEMBLY_PGO_USE:
+		if (!target->pgo_profile || !file_exists(make_str_from_c(target->pgo_profile))) {
+			builder_error("Profile file required by '--pgo=use' not found (use '--pgo-profile' to set it).");
+			return false;
+		}
+		break;
+	case ASSEMBLY_PGO_OFF:
+		break;
+	}
+	return true;
+}
+
+
 void ir_opt_run(struct assembly *assembly) {
 	zone();
 	// 2024-08-09 LLVM is slow, so no passes for debug.
 	if (assembly->target->opt == ASSEMBLY_OPT_DEBUG) return_zone();
+	if (use_pgo(assembly->target) && !pgo_init(assembly)) return_zone();
 
 	LLVMModuleRef        llvm_module = assembly->llvm.module;
 	LLVMTargetMachineRef llvm_tm     = assembly->llvm.TM;
@@ -12,12 +52,24 @@ void ir_opt_run(struct assembly *assembly) {
 	str_t opt = opt_to_LLVM_pass_str(assembly->target->opt);
 
 	str_buf_t tmp = get_tmp_str();
-	str_buf_append_fmt(&tmp, "default<{str}>", opt);
-
-	LLVMPassBuilderOptionsRef options = LLVMCreatePassBuilderOptions();
+	// In ThinLTO mode only pre-link simplification runs here, the rest is done per partition in
+	// parallel when the object files are generated.
+	if (use_thin_lto(assembly->target)) {
+		str_buf_append_fmt(&tmp, "thinlto-pre-link<{str}>", opt);
+	} else {
+		str_buf_append_fmt(&tmp, "default<{str}>", opt);
+	}
 
 	const char  *passes = str_buf_to_c(tmp);
-	LLVMErrorRef err    = LLVMRunPasses(llvm_module, passes, llvm_tm, options);
+	LLVMErrorRef err    = LLVMErrorSuccess;
+	if (use_pgo(assembly->target)) {
+		const enum llvm_pgo_action action = assembly->target->pgo == ASSEMBLY_PGO_GENERATE ? LLVM_PGO_GENERATE : LLVM_PGO_USE;
+		err = llvm_run_passes_with_pgo(llvm_module, passes, llvm_tm, action, assembly->target->pgo_profile);
+	} else {
+		LLVMPassBuilderOptionsRef options = LLVMCreatePassBuilderOptions();
+		err                               = LLVMRunPasses(llvm_module, passes, llvm_tm, options);
+		LLVMDisposePassBuilderOptions(options);
+	}
 	if (err != LLVMErrorSuccess) {
 		char *msg = LLVMGetErrorMessage(err);
 		builder_error("LLVM error: %s", msg);
@@ -2,7 +2,14 @@
 #include "builder.h"
 #include "common.h"
 #include "conf.h"
+#include "llvm_api.h"
 #include "stb_ds.h"
+#include <ctype.h>
+
+#if BL_PLATFORM_LINUX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #if BL_PLATFORM_MACOS
 #define SHARED_EXT    "dylib"
@@ -81,10 +88,27 @@ static void append_custom_opt(struct assembly *assembly, str_buf_t *buf) {
 	if (custom_opt.len) str_buf_append_fmt(buf, "{str} ", custom_opt);
 }
 
-static void append_linker_exec(struct assembly *assembly, str_buf_t *buf) {
+static bool has_custom_linker(struct assembly *assembly) {
 	const char *custom_linker =
 	    read_config(builder.config, assembly->target, "linker_executable", "");
-	if (strlen(custom_linker)) {
+	return strlen(custom_linker);
+}
+
+// LLD is linked into the compiler only on Linux (ELF driver); custom linker executable always runs
+// as an external process.
+static bool use_in_process_linker(struct assembly *assembly) {
+#if BL_PLATFORM_LINUX
+	return !has_custom_linker(assembly) && llvm_lld_is_available();
+#else
+	(void)assembly;
+	return false;
+#endif
+}
+
+static void append_linker_exec(struct assembly *assembly, str_buf_t *buf) {
+	if (has_custom_linker(assembly)) {
+		const char *custom_linker =
+		    read_config(builder.config, assembly->target, "linker_executable", "");
 		str_buf_append(buf, make_str_from_c(custom_linker));
 		str_buf_append(buf, cstr(" "));
 		return;
@@ -96,6 +120,93 @@ static void append_linker_exec(struct assembly *assembly, str_buf_t *buf) {
 #endif
 }
 
+// Split the linker command line into null-terminated arguments in place. Arguments are separated by
+// whitespace; single or double quotes can be used to keep whitespace inside an argument.
+static void split_args(char *cmd, array(const char *) * argv) {
+	char *c = cmd;
+	while (*c) {
+		while (*c && isspace((unsigned char)*c)) ++c;
+		if (!*c) break;
+		char *arg = c;
+		char *dst = c;
+		char  quote = '\0';
+		while (*c && (quote || !isspace((unsigned char)*c))) {
+			if (quote && *c == quote) {
+				quote = '\0';
+			} else if (!quote && (*c == '"' || *c == '\'')) {
+				quote = *c;
+			} else {
+				*dst++ = *c;
+			}
+			++c;
+		}
+		if (*c) ++c;
+		*dst = '\0';
+		arrput(*argv, arg);
+	}
+}
+
+static s32 link_in_process(const str_buf_t args) {
+	// Arguments are split in place, so we need a copy to keep the original command for fallback.
+	str_buf_t tmp = get_tmp_str();
+	str_buf_append(&tmp, args);
+	array(const char *) argv = NULL;
+	arrput(argv, "ld.lld");
+	if (tmp.len) split_args(tmp.ptr, &argv);
+	const s32 state = llvm_lld_link(argv, (s32)arrlen(argv));
+	arrfree(argv);
+	put_tmp_str(tmp);
+	return state;
+}
+
+static s32 link_external(struct assembly *assembly, const str_buf_t args) {
+	str_buf_t cmd = get_tmp_str();
+	append_linker_exec(assembly, &cmd);
+	str_buf_append(&cmd, args);
+	builder_log(STR_FMT, STR_ARG(cmd));
+	const s32 state = system(str_buf_to_c(cmd));
+	put_tmp_str(cmd);
+	return state;
+}
+
+// Object file emitted into memory is exposed to the linker as anonymous memory file, so it's never
+// written to disk. The descriptor is not closed on exec to be usable also by the external linker.
+// Returns -1 in case there is no object in memory or the file cannot be created.
+static s32 create_obj_memfd(struct assembly *assembly) {
+#if BL_PLATFORM_LINUX
+	LLVMMemoryBufferRef obj = assembly->llvm.obj;
+	if (!obj) return -1;
+	const s32 fd = memfd_create(assembly->target->name, 0);
+	if (fd == -1) return -1;
+	const char *data = LLVMGetBufferStart(obj);
+	usize       len  = LLVMGetBufferSize(obj);
+	while (len) {
+		const ssize_t written = write(fd, data, len);
+		if (written <= 0) {
+			close(fd);
+			return -1;
+		}
+		data += written;
+		len -= (usize)written;
+	}
+	return fd;
+#else
+	(void)assembly;
+	return -1;
+#endif
+}
+
+// Fallback in case the object file cannot be passed to the linker from memory.
+static bool write_obj_file(struct assembly *assembly, const str_buf_t filepath) {
+	LLVMMemoryBufferRef obj = assembly->llvm.obj;
+	FILE               *f   = fopen(str_buf_to_c(filepath), "wb");
+	if (!f) return false;
+	const usize len = LLVMGetBufferSize(obj);
+	const bool  ok  = fwrite(LLVMGetBufferStart(obj), 1, len, f) == len;
+	fclose(f);
+	return ok;
+}
+
 s32 lld_ld(struct assembly *assembly) {
 	runtime_measure_begin(linking);
 	str_buf_t            buf     = get_tmp_str();
@@ -103,10 +214,23 @@ s32 lld_ld(struct assembly *assembly) {
 	const str_t          out_dir = str_buf_view(target->out_dir);
 	const char          *name    = target->name;
 
-	// set executable
-	append_linker_exec(assembly, &buf);
-	// set input file
-	str_buf_append_fmt(&buf, "{str}/{s}.{s} ", out_dir, name, OBJECT_EXT);
+	// set input files
+	const s32 obj_fd = create_obj_memfd(assembly);
+	if (arrlenu(assembly->llvm.obj_files)) {
+		for (usize i = 0; i < arrlenu(assembly->llvm.obj_files); ++i) {
+			str_buf_append_fmt(&buf, "{s} ", assembly->llvm.obj_files[i]);
+		}
+	} else if (obj_fd != -1) {
+		str_buf_append_fmt(&buf, "/proc/self/fd/{s32} ", obj_fd);
+	} else {
+		str_buf_t obj_filepath = get_tmp_str();
+		str_buf_append_fmt(&obj_filepath, "{str}/{s}.{s}", out_dir, name, OBJECT_EXT);
+		if (assembly->llvm.obj && !write_obj_file(assembly, obj_filepath)) {
+			builder_error("Cannot write object file: " STR_FMT, STR_ARG(obj_filepath));
+		}
+		str_buf_append_fmt(&buf, "{str} ", obj_filepath);
+		put_tmp_str(obj_filepath);
+	}
 	// set output file
 	const char *ext    = get_out_extension(assembly);
 	const char *prefix = get_out_prefix(assembly);
@@ -120,8 +244,19 @@ s32 lld_ld(struct assembly *assembly) {
 	append_default_opt(assembly, &buf);
 	append_custom_opt(assembly, &buf);
 
-	builder_log(STR_FMT, STR_ARG(buf));
-	s32 state = system(str_buf_to_c(buf));
+	s32 state = -1;
+	runtime_measure_begin(linker);
+	if (use_in_process_linker(assembly)) {
+		builder_log("ld.lld (in-process) " STR_FMT, STR_ARG(buf));
+		state = link_in_process(buf);
+		if (state != -1) batomic_store_s32(&assembly->stats.linker_in_process, 1);
+	}
+	// Use external linker as fallback in case the in-process one is not available.
+	if (state == -1) state = link_external(assembly, buf);
+	batomic_fetch_add_s32(&assembly->stats.linker_ms, runtime_measure_end(linker));
+#if BL_PLATFORM_LINUX
+	if (obj_fd != -1) close(obj_fd);
+#endif
 	put_tmp_str(buf);
 	batomic_fetch_add_s32(&assembly->stats.linking_ms, runtime_measure_end(linking));
 
@@ -87,7 +87,13 @@ s32 lld_link(struct assembly *assembly) {
 	// set executable
 	append_linker_exec(assembly, &buf);
 	// set input file
-	str_buf_append_fmt(&buf, "\"{str}/{s}.{s}\" ", out_dir, name, OBJECT_EXT);
+	if (arrlenu(assembly->llvm.obj_files)) {
+		for (usize i = 0; i < arrlenu(assembly->llvm.obj_files); ++i) {
+			str_buf_append_fmt(&buf, "\"{s}\" ", assembly->llvm.obj_files[i]);
+		}
+	} else {
+		str_buf_append_fmt(&buf, "\"{str}/{s}.{s}\" ", out_dir, name, OBJECT_EXT);
+	}
 	// set output file
 	str_buf_append_fmt(&buf, "{s}:\"{str}/{s}.{s}\" ", FLAG_OUT, out_dir, name, get_out_extension(assembly));
 	append_lib_paths(assembly, &buf);
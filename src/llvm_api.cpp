@@ -36,14 +36,36 @@ _SHUT_UP_BEGIN
 #include <llvm/IR/GlobalVariable.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Type.h>
+#include <llvm/Analysis/ModuleSummaryAnalysis.h>
+#include <llvm/Analysis/ProfileSummaryInfo.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/PGOOptions.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+#if BL_THIN_LTO_ENABLE
+#include <llvm/LTO/legacy/ThinLTOCodeGenerator.h>
+#endif
+#if BL_LLD_ENABLE
+#include <lld/Common/Driver.h>
+#include <llvm/Support/raw_ostream.h>
+#endif
 _SHUT_UP_END
 
 #include <mutex>
 
 using namespace llvm;
 
+#if BL_LLD_ENABLE
+LLD_HAS_DRIVER(elf)
+#endif
+
 struct llvm_context {
 	LLVMContext       ctx;
 	LLVMTargetDataRef TD;
@@ -129,6 +151,10 @@ LLVMAttributeRef llvm_create_type_attribute(llvm_context_ref_t ctx, u32 kind, LL
 	return wrap(Attribute::get(ctx->ctx, AttrKind, unwrap(type_ref)));
 }
 
+LLVMAttributeRef llvm_create_string_attribute(llvm_context_ref_t ctx, const str_t kind, const str_t val) {
+	return wrap(Attribute::get(ctx->ctx, StringRef(kind.ptr, (size_t)kind.len), StringRef(val.ptr, (size_t)val.len)));
+}
+
 LLVMValueRef llvm_const_string_in_context(llvm_context_ref_t ctx, const str_t str, bool dont_null_terminate) {
 	return wrap(ConstantDataArray::getString(ctx->ctx, StringRef(str.ptr, (size_t)str.len), dont_null_terminate == 0));
 }
@@ -161,4 +187,147 @@ LLVMTypeRef llvm_intrinsic_get_type(llvm_context_ref_t ctx, u32 id, LLVMTypeRef
 
 LLVMBuilderRef llvm_create_builder_in_context(llvm_context_ref_t ctx) {
 	return wrap(new IRBuilder<>(ctx->ctx));
-}
\ No newline at end of file
+}
+
+LLVMValueRef llvm_clone_function(LLVMValueRef Fn, const str_t Name) {
+	ValueToValueMapTy map;
+	Function         *clone = CloneFunction(unwrap<Function>(Fn), map);
+	clone->setName(StringRef(Name.ptr, (size_t)Name.len));
+	return wrap(clone);
+}
+
+void llvm_set_branch_weights(LLVMValueRef Br, u32 then_weight, u32 else_weight) {
+	Instruction *br = unwrap<Instruction>(Br);
+	MDBuilder    builder(br->getContext());
+	br->setMetadata(LLVMContext::MD_prof, builder.createBranchWeights(then_weight, else_weight));
+}
+
+void llvm_split_module(LLVMModuleRef M, u32 partition_count, llvm_module_partition_fn_t fn, void *ctx) {
+	SplitModule(*unwrap(M), partition_count, [&](std::unique_ptr<Module> partition) {
+		fn(ctx, wrap(partition.release()));
+	});
+}
+
+void llvm_module_hash(LLVMModuleRef M, const str_t salt, char out[33]) {
+	SmallVector<char, 0> buffer;
+	raw_svector_ostream  stream(buffer);
+	WriteBitcodeToFile(*unwrap(M), stream);
+
+	MD5 hash;
+	hash.update(StringRef(salt.ptr, (size_t)salt.len));
+	hash.update(StringRef(buffer.data(), buffer.size()));
+	MD5::MD5Result result;
+	hash.final(result);
+	const SmallString<32> hex = result.digest();
+	memcpy(out, hex.c_str(), 33);
+}
+
+LLVMErrorRef llvm_run_passes_with_pgo(LLVMModuleRef M, const char *passes, LLVMTargetMachineRef TM, enum llvm_pgo_action action, const char *profile) {
+	TargetMachine *tm = reinterpret_cast<TargetMachine *>(TM);
+
+	const PGOOptions::PGOAction pgo_action = action == LLVM_PGO_GENERATE ? PGOOptions::IRInstr : PGOOptions::IRUse;
+	// Raw profile file name is embedded into the instrumented binary, empty name means
+	// 'default.profraw' in the current working directory.
+	PGOOptions pgo(profile ? profile : "", "", "", "", vfs::getRealFileSystem(), pgo_action);
+
+	LoopAnalysisManager     lam;
+	FunctionAnalysisManager fam;
+	CGSCCAnalysisManager    cgam;
+	ModuleAnalysisManager   mam;
+
+	PassBuilder pb(tm, PipelineTuningOptions(), pgo);
+	pb.registerModuleAnalyses(mam);
+	pb.registerCGSCCAnalyses(cgam);
+	pb.registerFunctionAnalyses(fam);
+	pb.registerLoopAnalyses(lam);
+	pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+	ModulePassManager mpm;
+	if (Error err = pb.parsePassPipeline(mpm, passes)) return wrap(std::move(err));
+	mpm.run(*unwrap(M), mam);
+	return LLVMErrorSuccess;
+}
+
+#if BL_THIN_LTO_ENABLE
+struct llvm_thin_lto {
+	ThinLTOCodeGenerator generator;
+	// Bitcode of added modules must live until the code generator is done.
+	std::vector<std::unique_ptr<SmallVector<char, 0>>> buffers;
+};
+
+llvm_thin_lto_ref_t llvm_thin_lto_create(LLVMTargetMachineRef TM, const char *cache_dir, const char *objects_dir) {
+	const TargetMachine *tm  = reinterpret_cast<TargetMachine *>(TM);
+	llvm_thin_lto_ref_t  lto = new llvm_thin_lto();
+	lto->generator.setTargetOptions(tm->Options);
+	lto->generator.setCpu(tm->getTargetCPU().str());
+	lto->generator.setAttr(tm->getTargetFeatureString().str());
+	lto->generator.setCodePICModel(tm->getRelocationModel());
+	lto->generator.setCodeGenOptLevel(tm->getOptLevel());
+	lto->generator.setOptLevel(static_cast<unsigned>(tm->getOptLevel()));
+	lto->generator.setGeneratedObjectsDirectory(objects_dir);
+	if (cache_dir) lto->generator.setCacheDir(cache_dir);
+	return lto;
+}
+
+void llvm_thin_lto_dispose(llvm_thin_lto_ref_t lto) {
+	delete lto;
+}
+
+void llvm_thin_lto_preserve_symbols(llvm_thin_lto_ref_t lto, LLVMModuleRef M) {
+	for (const GlobalValue &gv : unwrap(M)->global_values()) {
+		if (gv.isDeclaration() || gv.hasLocalLinkage()) continue;
+		lto->generator.preserveSymbol(gv.getName());
+	}
+}
+
+void llvm_thin_lto_add_module(llvm_thin_lto_ref_t lto, LLVMModuleRef M) {
+	const Module      &module = *unwrap(M);
+	ProfileSummaryInfo psi(module);
+	ModuleSummaryIndex index = buildModuleSummaryIndex(module, nullptr, &psi);
+
+	auto                buffer = std::make_unique<SmallVector<char, 0>>();
+	raw_svector_ostream stream(*buffer);
+	WriteBitcodeToFile(module, stream, false, &index);
+	lto->generator.addModule(module.getModuleIdentifier(), StringRef(buffer->data(), buffer->size()));
+	lto->buffers.push_back(std::move(buffer));
+}
+
+void llvm_thin_lto_run(llvm_thin_lto_ref_t lto, llvm_object_file_fn_t fn, void *ctx) {
+	lto->generator.run();
+	for (const std::string &filepath : lto->generator.getProducedBinaryFiles()) {
+		fn(ctx, filepath.c_str());
+	}
+}
+#endif
+
+#if BL_LLD_ENABLE
+// LLD keeps global state and does not support concurrent runs in a single process.
+static std::mutex lld_lock;
+static bool       lld_can_run_again = true;
+#endif
+
+bool llvm_lld_is_available(void) {
+#if BL_LLD_ENABLE
+	std::lock_guard<std::mutex> guard(lld_lock);
+	return lld_can_run_again;
+#else
+	return false;
+#endif
+}
+
+s32 llvm_lld_link(const char **argv, s32 argc) {
+#if BL_LLD_ENABLE
+	std::lock_guard<std::mutex> guard(lld_lock);
+	if (!lld_can_run_again) return -1;
+	const ArrayRef<const char *> args(argv, (size_t)argc);
+	const lld::Result            result = lld::lldMain(args, outs(), errs(), {{lld::Gnu, &lld::elf::link}});
+	outs().flush();
+	errs().flush();
+	lld_can_run_again = result.canRunAgain;
+	return result.retCode;
+#else
+	(void)argv;
+	(void)argc;
+	return -1;
+#endif
+}
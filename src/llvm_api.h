@@ -53,6 +53,8 @@ _SHUT_UP_END
 #define LLVM_ATTR_NOALIAS      LLVMGetEnumAttributeKindForName("noalias", 7)
 #define LLVM_ATTR_STRUCTRET    LLVMGetEnumAttributeKindForName("sret", 4)
 #define LLVM_ATTR_ALIGNMENT    LLVMGetEnumAttributeKindForName("align", 5)
+#define LLVM_ATTR_HOT          LLVMGetEnumAttributeKindForName("hot", 3)
+#define LLVM_ATTR_COLD         LLVMGetEnumAttributeKindForName("cold", 4)
 
 #define LLVM_MEMSET_INTRINSIC_ID LLVMLookupIntrinsicID("llvm.memset", 11)
 #define LLVM_MEMCPY_INTRINSIC_ID LLVMLookupIntrinsicID("llvm.memcpy", 11)
@@ -107,12 +109,56 @@ LLVMMetadataRef    llvm_di_builder_create_debug_location(llvm_context_ref_t ctx,
 u32                llvm_get_md_kind_id_in_context(llvm_context_ref_t ctx, const str_t name);
 LLVMAttributeRef   llvm_create_enum_attribute(llvm_context_ref_t ctx, u32 kind, u64 val);
 LLVMAttributeRef   llvm_create_type_attribute(llvm_context_ref_t ctx, u32 kind, LLVMTypeRef type_ref);
+LLVMAttributeRef   llvm_create_string_attribute(llvm_context_ref_t ctx, const str_t kind, const str_t val);
 LLVMValueRef       llvm_const_string_in_context(llvm_context_ref_t ctx, const str_t str, bool dont_null_terminate);
 LLVMValueRef       llvm_const_byte_blob_in_context(llvm_context_ref_t ctx, LLVMTypeRef elem_type_ref, const u8 *ptr, s64 len);
 LLVMTypeRef        llvm_struct_type_in_context(llvm_context_ref_t ctx, LLVMTypeRef *elems, u32 elem_num, LLVMBool packed);
 LLVMModuleRef      llvm_module_create_with_name_in_context(llvm_context_ref_t ctx, const char *name);
 LLVMTypeRef        llvm_intrinsic_get_type(llvm_context_ref_t ctx, u32 id, LLVMTypeRef *types, size_t types_num);
 LLVMBuilderRef     llvm_create_builder_in_context(llvm_context_ref_t ctx);
+// Clone function with its body into the same module.
+LLVMValueRef llvm_clone_function(LLVMValueRef Fn, const str_t Name);
+// Attach branch weights profile metadata to the conditional branch instruction.
+void llvm_set_branch_weights(LLVMValueRef Br, u32 then_weight, u32 else_weight);
+
+// Run the optimization pass pipeline on the module with profile guided optimization. In generate
+// mode the module is instrumented and the raw profile is written into the profile file at exit
+// of the program; in use mode the indexed profile file is used to drive the optimizations.
+enum llvm_pgo_action {
+	LLVM_PGO_GENERATE,
+	LLVM_PGO_USE,
+};
+LLVMErrorRef llvm_run_passes_with_pgo(LLVMModuleRef M, const char *passes, LLVMTargetMachineRef TM, enum llvm_pgo_action action, const char *profile);
+
+// Split the module into partitions, the callback takes ownership of each partition module. Local
+// symbols are externalized, so partitions can be compiled into separate object files.
+typedef void (*llvm_module_partition_fn_t)(void *ctx, LLVMModuleRef partition);
+void llvm_split_module(LLVMModuleRef M, u32 partition_count, llvm_module_partition_fn_t fn, void *ctx);
+// Write MD5 hash (as hex string) of module bitcode combined with the salt into the out buffer.
+void llvm_module_hash(LLVMModuleRef M, const str_t salt, char out[33]);
+
+#if BL_THIN_LTO_ENABLE
+// ThinLTO optimization and code generation of module partitions (available only when the compiler
+// is built with BL_THIN_LTO_ENABLE). Partitions are summarized when added, optimized with
+// cross-partition importing and compiled into object files in parallel. Results are reused from
+// the cache directory (optional) in case nothing relevant changed.
+typedef struct llvm_thin_lto *llvm_thin_lto_ref_t;
+typedef void (*llvm_object_file_fn_t)(void *ctx, const char *filepath);
+
+llvm_thin_lto_ref_t llvm_thin_lto_create(LLVMTargetMachineRef TM, const char *cache_dir, const char *objects_dir);
+void                llvm_thin_lto_dispose(llvm_thin_lto_ref_t lto);
+// Keep all non-local symbols defined in the module visible from the outside.
+void llvm_thin_lto_preserve_symbols(llvm_thin_lto_ref_t lto, LLVMModuleRef M);
+void llvm_thin_lto_add_module(llvm_thin_lto_ref_t lto, LLVMModuleRef M);
+// Produced object files are written into the objects directory and reported by the callback.
+void llvm_thin_lto_run(llvm_thin_lto_ref_t lto, llvm_object_file_fn_t fn, void *ctx);
+#endif
+
+// In-process LLD linking (available only when the compiler is built with BL_LLD_ENABLE). The
+// llvm_lld_link returns the linker exit code or -1 in case the linker cannot be invoked in-process
+// (not available or previous run crashed and left the linker in inconsistent state).
+bool llvm_lld_is_available(void);
+s32  llvm_lld_link(const char **argv, s32 argc);
 
 #ifdef __cplusplus
 }
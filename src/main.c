@@ -530,6 +530,11 @@ int main(s32 argc, char *argv[]) {
 	        .property.b = &opt.target->emit_mir,
 	        .help       = "Write MIR to file.",
 	    },
+	    {
+	        .name       = "--emit-obj",
+	        .property.b = &opt.target->emit_obj,
+	        .help       = "Keep object file on disk.",
+	    },
 	    {
 	        .name       = "--di",
 	        .kind       = ENUM,
@@ -537,6 +542,14 @@ int main(s32 argc, char *argv[]) {
 	        .variants   = "dwarf|codeview",
 	        .help       = "Set debug info format.",
 	    },
+	    {
+	        .name       = "--di-level",
+	        .kind       = ENUM,
+	        .property.n = (s32 *)&opt.target->di_level,
+	        .variants   = "full|line-tables",
+	        .help       = "Set debug info level; 'line-tables' emits only functions and source locations (enough for "
+	                      "symbolized stack traces) without variables and types.",
+	    },
 	    {
 	        .name       = "-opt",
 	        .kind       = ENUM,
@@ -582,6 +595,43 @@ int main(s32 argc, char *argv[]) {
 	        .property.b = &opt.target->tests_minimal_output,
 	        .help       = "Disable test results section.",
 	    },
+	    {
+	        .name       = "--tests-parallel",
+	        .property.b = &opt.target->tests_parallel,
+	        .help       = "Execute tests concurrently on all worker threads (tests marked as '#serial' are "
+	                      "executed one by one).",
+	    },
+	    {
+	        .name       = "--tests-filter",
+	        .kind       = STRING,
+	        .property.s = &opt.target->tests_filter,
+	        .help       = "Execute only tests containing <STRING> in the name.",
+	    },
+	    {
+	        .name       = "--tests-shard-index",
+	        .kind       = NUMBER,
+	        .property.n = &opt.target->tests_shard_index,
+	        .help       = "Execute only tests belonging to the shard with zero based index <N>.",
+	    },
+	    {
+	        .name       = "--tests-shard-count",
+	        .kind       = NUMBER,
+	        .property.n = &opt.target->tests_shard_count,
+	        .help       = "Split tests into <N> shards (use '--tests-shard-index' to select one).",
+	    },
+	    {
+	        .name       = "--tests-report",
+	        .kind       = STRING,
+	        .property.s = &opt.target->tests_report,
+	        .help       = "Write test results including per-test durations into the file.",
+	    },
+	    {
+	        .name       = "--tests-report-format",
+	        .kind       = ENUM,
+	        .property.n = (s32 *)&opt.target->tests_report_format,
+	        .variants   = "json|junit",
+	        .help       = "Set format of the test report file (use 'json' by default).",
+	    },
 	    {
 	        .name       = "--no-api",
 	        .property.b = &opt.target->no_api,
@@ -592,6 +642,56 @@ int main(s32 argc, char *argv[]) {
 	        .property.b = &opt.target->no_bin,
 	        .help       = "Don't write binary to disk.",
 	    },
+	    {
+	        .name       = "--fast-link",
+	        .property.b = &opt.target->fast_link,
+	        .help       = "Link debug executables using built-in linker (x86_64 Linux only).",
+	    },
+	    {
+	        .name       = "--obj-cache-dir",
+	        .kind       = STRING,
+	        .property.s = &opt.target->obj_cache_dir,
+	        .help       = "Split generated code into partitions and cache their object files in the directory; only "
+	                      "changed partitions are compiled again. The directory is never cleaned up by the compiler.",
+	    },
+	    {
+	        .name       = "--thin-lto",
+	        .property.b = &opt.target->thin_lto,
+	        .help       = "Use ThinLTO for release builds; generated code is optimized and compiled in parallel.",
+	    },
+	    {
+	        .name       = "--lto-cache-dir",
+	        .kind       = STRING,
+	        .property.s = &opt.target->lto_cache_dir,
+	        .help       = "Reuse ThinLTO results from the directory between builds (used with --thin-lto).",
+	    },
+	    {
+	        .name       = "--cpu",
+	        .kind       = STRING,
+	        .property.s = &opt.target->cpu,
+	        .help       = "Set target CPU name used for native code generation, 'native' selects CPU of the host machine.",
+	    },
+	    {
+	        .name       = "--cpu-features",
+	        .kind       = STRING,
+	        .property.s = &opt.target->cpu_features,
+	        .help       = "Set comma separated list of additional target CPU features (e.g. '+avx2,+fma').",
+	    },
+	    {
+	        .name       = "--pgo",
+	        .kind       = ENUM,
+	        .property.n = (s32 *)&opt.target->pgo,
+	        .variants   = "off|generate|use",
+	        .help       = "Set profile guided optimization mode of release builds; 'generate' instruments the binary to "
+	                      "write execution profile at exit, 'use' optimizes using profile from '--pgo-profile'.",
+	    },
+	    {
+	        .name       = "--pgo-profile",
+	        .kind       = STRING,
+	        .property.s = &opt.target->pgo_profile,
+	        .help       = "Set raw profile output file of instrumented binary (--pgo=generate) or indexed profile file "
+	                      "(.profdata) used for optimization (--pgo=use).",
+	    },
 	    {
 	        .name       = "--no-llvm",
 	        .property.b = &opt.target->no_llvm,
@@ -627,6 +727,13 @@ int main(s32 argc, char *argv[]) {
 	                      "instruction with <N> id.",
 	        .id         = ID_VMDBG_BREAK_ON,
 	    },
+	    {
+	        .name       = "--vm-profile",
+	        .kind       = STRING,
+	        .property.s = &opt.target->vm_profile,
+	        .help       = "Count instructions executed in compile-time per call stack and write them into the file "
+	                      "in folded stacks format (usable to generate flame graphs).",
+	    },
 	    {
 	        .name       = "--error-limit",
 	        .kind       = NUMBER,
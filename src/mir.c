@@ -215,6 +215,8 @@ static struct mir_type *create_type_fn(struct context *ctx, create_type_fn_args_
 
 static struct mir_type *create_type_fn_group(struct context *ctx, struct id *user_id, mir_types_t *variants);
 static struct mir_type *create_type_array(struct context *ctx, struct id *user_id, struct mir_type *elem_type, s64 len);
+static struct mir_type *create_type_vector(struct context *ctx, struct id *user_id, struct mir_type *elem_type, s64 len);
+static struct mir_type *create_type_vector_mask(struct context *ctx, struct mir_type *vector_type);
 
 typedef struct
 {
@@ -448,7 +450,7 @@ static struct mir_instr *_append_instr_type_struct(struct context *ctx, append_i
 static struct mir_instr *append_instr_type_enum(struct context *ctx, struct ast *node, struct id *id, struct scope *scope, mir_instrs_t *variants, struct mir_instr *base_type, bool is_flags);
 static struct mir_instr *append_instr_type_ptr(struct context *ctx, struct ast *node, struct mir_instr *type);
 static struct mir_instr *append_instr_type_poly(struct context *ctx, struct ast *node, struct id *T_id);
-static struct mir_instr *append_instr_type_array(struct context *ctx, struct ast *node, struct id *id, struct mir_instr *elem_type, struct mir_instr *len);
+static struct mir_instr *append_instr_type_array(struct context *ctx, struct ast *node, struct id *id, struct mir_instr *elem_type, struct mir_instr *len, bool is_vector);
 static struct mir_instr *append_instr_type_slice(struct context *ctx, struct ast *node, struct mir_instr *elem_type);
 static struct mir_instr *append_instr_type_dynarr(struct context *ctx, struct ast *node, struct mir_instr *elem_type);
 static struct mir_instr *append_instr_type_vargs(struct context *ctx, struct ast *node, struct mir_instr *elem_type);
@@ -1290,8 +1292,13 @@ static inline void erase_block(struct mir_instr *instr) {
 					sarrput(&queue, &c->block->base);
 				}
 			}
+			if (unref_instr(&sw->default_block->base)->ref_count == 0) {
+				sarrput(&queue, &sw->default_block->base);
+			}
 			break;
 		}
+		case MIR_INSTR_RET:
+			break;
 		default:
 			bassert(false && "Unhandled terminal instruction!");
 			break;
@@ -2170,7 +2177,7 @@ struct mir_type *create_type_fn_group(struct context *ctx, struct id *user_id, m
 	return tmp;
 }
 
-struct mir_type *create_type_array(struct context *ctx, struct id *user_id, struct mir_type *elem_type, s64 len) {
+static struct mir_type *_create_type_array(struct context *ctx, struct id *user_id, struct mir_type *elem_type, s64 len, bool is_vector) {
 	bassert(elem_type);
 
 	struct mir_type *result;
@@ -2180,7 +2187,12 @@ struct mir_type *create_type_array(struct context *ctx, struct id *user_id, stru
 	str_buf_t name = get_tmp_str();
 
 	const str_t elem_type_name = elem_type->id.str;
-	str_buf_append_fmt(&name, "{u64}.{str}", (unsigned long long)len, elem_type_name);
+	if (is_vector) {
+		// Vectors must not share the cache entry with arrays of the same shape.
+		str_buf_append_fmt(&name, "v{u64}.{str}", (unsigned long long)len, elem_type_name);
+	} else {
+		str_buf_append_fmt(&name, "{u64}.{str}", (unsigned long long)len, elem_type_name);
+	}
 
 	const hash_t hash = strhash(name);
 
@@ -2199,6 +2211,7 @@ struct mir_type *create_type_array(struct context *ctx, struct id *user_id, stru
 	result->id.str               = scdup2(ctx->string_cache, name);
 	result->data.array.elem_type = elem_type;
 	result->data.array.len       = len;
+	result->data.array.is_vector = is_vector;
 
 	type_init_llvm_array(ctx, result);
 
@@ -2213,6 +2226,39 @@ DONE:
 	return result;
 }
 
+struct mir_type *create_type_array(struct context *ctx, struct id *user_id, struct mir_type *elem_type, s64 len) {
+	return _create_type_array(ctx, user_id, elem_type, len, false);
+}
+
+struct mir_type *create_type_vector(struct context *ctx, struct id *user_id, struct mir_type *elem_type, s64 len) {
+	bassert(elem_type->kind == MIR_TYPE_INT || elem_type->kind == MIR_TYPE_REAL);
+	return _create_type_array(ctx, user_id, elem_type, len, true);
+}
+
+// Create signed integer vector type with the same lane count and lane size as `vector_type`. This type
+// is used as the result of vector comparison.
+struct mir_type *create_type_vector_mask(struct context *ctx, struct mir_type *vector_type) {
+	bassert(mir_is_vector_type(vector_type));
+	struct mir_type *lane_type = NULL;
+	switch (vector_type->data.array.elem_type->store_size_bytes) {
+	case 1:
+		lane_type = ctx->builtin_types->t_s8;
+		break;
+	case 2:
+		lane_type = ctx->builtin_types->t_s16;
+		break;
+	case 4:
+		lane_type = ctx->builtin_types->t_s32;
+		break;
+	case 8:
+		lane_type = ctx->builtin_types->t_s64;
+		break;
+	default:
+		BL_UNREACHABLE;
+	}
+	return create_type_vector(ctx, NULL, lane_type, vector_type->data.array.len);
+}
+
 static void generate_struct_signature(str_buf_t *name, create_type_struct_args_t *args) {
 	static batomic_s64 serial = 0;
 	if (args->user_id) {
@@ -2768,7 +2814,7 @@ void type_init_llvm_array(struct context *ctx, struct mir_type *type) {
 	bassert(llvm_elem_type);
 	const unsigned int len = (const unsigned int)type->data.array.len;
 
-	type->llvm_type        = LLVMArrayType(llvm_elem_type, len);
+	type->llvm_type        = type->data.array.is_vector ? LLVMVectorType(llvm_elem_type, len) : LLVMArrayType(llvm_elem_type, len);
 	type->size_bits        = LLVMSizeOfTypeInBits(ctx->assembly->llvm.TD, type->llvm_type);
 	type->store_size_bytes = LLVMStoreSizeOfType(ctx->assembly->llvm.TD, type->llvm_type);
 	type->alignment        = (s8)LLVMABIAlignmentOfType(ctx->assembly->llvm.TD, type->llvm_type);
@@ -3499,7 +3545,7 @@ struct mir_instr *append_instr_type_poly(struct context *ctx, struct ast *node,
 	return &tmp->base;
 }
 
-struct mir_instr *append_instr_type_array(struct context *ctx, struct ast *node, struct id *id, struct mir_instr *elem_type, struct mir_instr *len) {
+struct mir_instr *append_instr_type_array(struct context *ctx, struct ast *node, struct id *id, struct mir_instr *elem_type, struct mir_instr *len, bool is_vector) {
 	struct mir_instr_type_array *tmp = create_instr(ctx, MIR_INSTR_TYPE_ARRAY, node);
 	tmp->base.value.type             = ctx->builtin_types->t_type;
 	tmp->base.value.addr_mode        = MIR_VAM_LVALUE_CONST;
@@ -3507,6 +3553,7 @@ struct mir_instr *append_instr_type_array(struct context *ctx, struct ast *node,
 	tmp->elem_type                   = ref_instr(elem_type);
 	tmp->len                         = ref_instr(len);
 	tmp->id                          = id;
+	tmp->is_vector                   = is_vector;
 	append_current_block(ctx, &tmp->base);
 	return &tmp->base;
 }
@@ -4484,6 +4531,171 @@ void erase_instr_tree(struct mir_instr *instr, bool keep_root, bool force) {
 #undef erase
 }
 
+// Compile-time call results can be reused only for values not pointing to any memory which might
+// change between calls.
+static bool is_comptime_call_cacheable_type(struct mir_type *type) {
+	switch (type->kind) {
+	case MIR_TYPE_TYPE:
+	case MIR_TYPE_INT:
+	case MIR_TYPE_REAL:
+	case MIR_TYPE_BOOL:
+	case MIR_TYPE_ENUM:
+		return true;
+	case MIR_TYPE_ARRAY:
+		return is_comptime_call_cacheable_type(type->data.array.elem_type);
+	case MIR_TYPE_STRUCT: {
+		if (type->data.strct.is_string_literal) return false;
+		mir_members_t *members = type->data.strct.members;
+		for (usize i = 0; i < sarrlenu(members); ++i) {
+			if (!is_comptime_call_cacheable_type(sarrpeek(members, i)->type)) return false;
+		}
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+static inline bool is_mutable_global_var(struct mir_var *var) {
+	return isflag(var->iflags, MIR_VAR_GLOBAL) && !var->value.is_comptime;
+}
+
+// Compiler-provided compile-time externals known to have no side effects. Any other external
+// function is considered to be impure (e.g. '__create_enum_type' creates a new type on each call).
+static bool is_pure_comptime_extern(const str_t linkage_name) {
+	static const char *names[] = {
+	    "__get_struct_member_type",
+	};
+	for (usize i = 0; i < static_arrlenu(names); ++i) {
+		if (str_match(linkage_name, make_str_from_c((char *)names[i]))) return true;
+	}
+	return false;
+}
+
+// Function is considered to be pure when its result depends only on its arguments: it does not
+// touch any mutable global variable and calls only other pure functions, known pure compile-time
+// compiler API or intrinsics. This is conservative, function calls via pointer are considered to
+// be impure.
+static bool is_fn_pure(struct mir_fn *fn) {
+	bmagic_assert(fn);
+	switch (fn->purity) {
+	case MIR_FN_PURE:
+	case MIR_FN_PURITY_CHECKING: // Recursive call.
+		return true;
+	case MIR_FN_IMPURE:
+		return false;
+	case MIR_FN_PURITY_UNKNOWN:
+		break;
+	}
+	if (isflag(fn->flags, FLAG_EXTERN)) {
+		const bool pure = isflag(fn->flags, FLAG_COMPTIME) && is_pure_comptime_extern(fn->linkage_name);
+		fn->purity      = pure ? MIR_FN_PURE : MIR_FN_IMPURE;
+		return pure;
+	}
+	if (isflag(fn->flags, FLAG_INTRINSIC)) {
+		// Atomic intrinsics access shared memory.
+		fn->purity = is_atomic_intrinsic(fn->linkage_name) ? MIR_FN_IMPURE : MIR_FN_PURE;
+		return fn->purity == MIR_FN_PURE;
+	}
+	if (!fn->is_fully_analyzed || !fn->entry_block) {
+		// Might change later.
+		return false;
+	}
+
+	fn->purity                    = MIR_FN_PURITY_CHECKING;
+	bool                    pure  = true;
+	bool                    known = true;
+	struct mir_instr_block *block = fn->entry_block;
+	for (; block && pure; block = (struct mir_instr_block *)block->base.next) {
+		struct mir_instr *instr = block->entry_instr;
+		for (; instr && pure; instr = instr->next) {
+			switch (instr->kind) {
+			case MIR_INSTR_DECL_REF: {
+				struct scope_entry *entry = ((struct mir_instr_decl_ref *)instr)->scope_entry;
+				if (entry && entry->kind == SCOPE_ENTRY_VAR) pure = !is_mutable_global_var(entry->as.var);
+				break;
+			}
+			case MIR_INSTR_DECL_DIRECT_REF: {
+				struct mir_instr *ref = ((struct mir_instr_decl_direct_ref *)instr)->ref;
+				if (ref->kind == MIR_INSTR_DECL_VAR) pure = !is_mutable_global_var(((struct mir_instr_decl_var *)ref)->var);
+				break;
+			}
+			case MIR_INSTR_CALL: {
+				struct mir_instr_call *call = (struct mir_instr_call *)instr;
+				if (!mir_is_comptime(call->callee)) {
+					pure = false;
+					break;
+				}
+				struct mir_fn *callee = mir_get_callee(call);
+				pure                  = is_fn_pure(callee);
+				// Result depending on not yet analyzed function or on recursion cannot be cached.
+				if (callee->purity == MIR_FN_PURITY_UNKNOWN || (callee->purity == MIR_FN_PURITY_CHECKING && callee != fn)) known = false;
+				break;
+			}
+			case MIR_INSTR_TEST_CASES:
+			case MIR_INSTR_DEBUGBREAK:
+				pure = false;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+	if (known) {
+		fn->purity = pure ? MIR_FN_PURE : MIR_FN_IMPURE;
+	} else {
+		fn->purity = MIR_FN_PURITY_UNKNOWN;
+	}
+	return pure;
+}
+
+// Produce unique key for compile-time call based on callee and argument values. Returns false in
+// case the call cannot be cached.
+static bool comptime_call_cache_key(struct mir_instr_call *call, struct mir_fn *fn, str_buf_t *key) {
+	if (!fn->type->data.fn.ret_type || !is_comptime_call_cacheable_type(fn->type->data.fn.ret_type)) return false;
+	mir_instrs_t *args = call->args;
+	for (usize i = 0; i < sarrlenu(args); ++i) {
+		struct mir_const_expr_value *value = &sarrpeek(args, i)->value;
+		if (!value->data || !is_comptime_call_cacheable_type(value->type)) return false;
+	}
+	if (!is_fn_pure(fn)) return false;
+
+	_str_buf_append(key, (char *)&fn, sizeof(fn));
+	for (usize i = 0; i < sarrlenu(args); ++i) {
+		struct mir_const_expr_value *value = &sarrpeek(args, i)->value;
+		_str_buf_append(key, (char *)value->data, (s32)value->type->store_size_bytes);
+	}
+	return true;
+}
+
+static bool comptime_call_cache_lookup(struct context *ctx, struct mir_instr_call *call, const str_t key) {
+	const s32 index = tbl_lookup_index_with_key(ctx->analyze->comptime_call_cache, strhash(key), key);
+	if (index == -1) return false;
+
+	struct mir_type *ret_type = call->base.value.type;
+	vm_stack_ptr_t   dest     = (vm_stack_ptr_t)&call->base.value._tmp;
+	if (ret_type->store_size_bytes > sizeof(call->base.value._tmp)) {
+		dest = vm_alloc_raw(ctx->vm, ctx->assembly, ret_type);
+	}
+	memcpy(dest, ctx->analyze->comptime_call_cache[index].data, ret_type->store_size_bytes);
+	call->base.value.data = dest;
+	batomic_fetch_add_s32(&ctx->assembly->stats.comptime_call_cache_hits, 1);
+	return true;
+}
+
+static void comptime_call_cache_insert(struct context *ctx, struct mir_instr_call *call, const str_t key) {
+	struct mir_type *ret_type = call->base.value.type;
+	vm_stack_ptr_t   data     = vm_alloc_raw(ctx->vm, ctx->assembly, ret_type);
+	memcpy(data, call->base.value.data, ret_type->store_size_bytes);
+
+	struct comptime_call_cache_entry entry = {
+	    .hash = strhash(key),
+	    .key  = scdup2(ctx->string_cache, key),
+	    .data = data,
+	};
+	tbl_insert(ctx->analyze->comptime_call_cache, entry);
+}
+
 enum vm_interp_state evaluate(struct context *ctx, struct mir_instr *instr) {
 	if (!instr) return VM_INTERP_PASSED;
 	bassert(instr->state == MIR_IS_ANALYZED && "Non-analyzed instruction cannot be evaluated!");
@@ -4502,11 +4714,19 @@ enum vm_interp_state evaluate(struct context *ctx, struct mir_instr *instr) {
 		if (!call->is_inside_recipe) {
 			struct mir_fn *fn = mir_get_callee(call);
 			if (!fn->is_fully_analyzed) return VM_INTERP_POSTPONE;
-			const enum vm_interp_state state = vm_execute_comptime_call(ctx->vm, ctx->assembly, call);
 
-			if (state != VM_INTERP_PASSED) {
-				return state;
+			// Calls to pure functions with the same arguments are evaluated only once.
+			str_buf_t  key       = get_tmp_str();
+			const bool cacheable = comptime_call_cache_key(call, fn, &key);
+			if (!cacheable || !comptime_call_cache_lookup(ctx, call, str_buf_view(key))) {
+				const enum vm_interp_state state = vm_execute_comptime_call(ctx->vm, ctx->assembly, call);
+				if (state != VM_INTERP_PASSED) {
+					put_tmp_str(key);
+					return state;
+				}
+				if (cacheable) comptime_call_cache_insert(ctx, call, str_buf_view(key));
 			}
+			put_tmp_str(key);
 		} else if (call->base.value.type->kind != MIR_TYPE_VOID) {
 			// Replace call type inside recipe by placeholder since the function cannot be called.
 			call->base.value.type = ctx->builtin_types->t_placeholer;
@@ -7452,6 +7672,28 @@ struct result analyze_instr_type_array(struct context *ctx, struct mir_instr_typ
 		return_zone(FAIL);
 	}
 
+	if (type_arr->is_vector) {
+		if (elem_type->kind != MIR_TYPE_INT && elem_type->kind != MIR_TYPE_REAL) {
+			str_buf_t type_name = mir_type2str(elem_type, /* prefer_name */ true);
+			report_error(INVALID_TYPE,
+			             type_arr->elem_type->node,
+			             "Invalid SIMD vector element type '" STR_FMT "'. Only integer or real types can be used.",
+			             STR_ARG(type_name));
+			put_tmp_str(type_name);
+			return_zone(FAIL);
+		}
+		const bool is_pow2 = len > 1 && (len & (len - 1)) == 0;
+		if (!mir_is_placeholder(type_arr->len) && (!is_pow2 || len * (s64)elem_type->store_size_bytes > MIR_VECTOR_MAX_SIZE)) {
+			report_error(INVALID_ARR_SIZE,
+			             type_arr->len->node,
+			             "SIMD vector lane count must be power of two greater than 1 and the vector size cannot exceed %d bytes.",
+			             MIR_VECTOR_MAX_SIZE);
+			return_zone(FAIL);
+		}
+		MIR_CEV_WRITE_AS(struct mir_type *, &type_arr->base.value, create_type_vector(ctx, type_arr->id, elem_type, len));
+		return_zone(PASS);
+	}
+
 	MIR_CEV_WRITE_AS(struct mir_type *, &type_arr->base.value, create_type_array(ctx, type_arr->id, elem_type, len));
 	return_zone(PASS);
 }
@@ -7555,6 +7797,14 @@ static inline bool is_type_valid_for_binop(const struct mir_type *type, const en
 		return true;
 	case MIR_TYPE_BOOL:
 		return ast_binop_is_logic(op);
+	case MIR_TYPE_ARRAY: {
+		// SIMD vectors support element-wise arithmetic and comparison; logical operators have no
+		// meaning for them.
+		if (!type->data.array.is_vector) return false;
+		if (op == BINOP_LOGIC_AND || op == BINOP_LOGIC_OR) return false;
+		if (type->data.array.elem_type->kind == MIR_TYPE_INT) return true;
+		return op <= BINOP_LESS_EQ && op != BINOP_MOD;
+	}
 	case MIR_TYPE_TYPE:
 	case MIR_TYPE_ENUM: {
 		if (type->data.enm.is_flags) {
@@ -7627,7 +7877,11 @@ struct result analyze_instr_binop(struct context *ctx, struct mir_instr_binop *b
 		return_zone(FAIL);
 	}
 
-	struct mir_type *type = ast_binop_is_logic(binop->op) ? ctx->builtin_types->t_bool : lhs->value.type;
+	struct mir_type *type = lhs->value.type;
+	if (ast_binop_is_logic(binop->op)) {
+		// Comparison of SIMD vectors produce lane mask (all bits set for true lanes).
+		type = mir_is_vector_type(type) ? create_type_vector_mask(ctx, type) : ctx->builtin_types->t_bool;
+	}
 	bassert(type);
 
 	binop->base.value.type = type;
@@ -7824,6 +8078,9 @@ struct result analyze_instr_unop(struct context *ctx, struct mir_instr_unop *uno
 	struct mir_type *expr_type = unop->expr->value.type;
 	bassert(expr_type);
 
+	// SIMD vector operations are applied on each lane.
+	struct mir_type *lane_type = mir_is_vector_type(expr_type) ? expr_type->data.array.elem_type : expr_type;
+
 	switch (unop->op) {
 	case UNOP_NOT: {
 		if (expr_type->kind != MIR_TYPE_BOOL) return_zone(FAIL);
@@ -7831,7 +8088,7 @@ struct result analyze_instr_unop(struct context *ctx, struct mir_instr_unop *uno
 	}
 
 	case UNOP_BIT_NOT: {
-		if (expr_type->kind != MIR_TYPE_INT && (expr_type->kind != MIR_TYPE_ENUM && expr_type->data.enm.is_flags)) {
+		if (lane_type->kind != MIR_TYPE_INT && (lane_type->kind != MIR_TYPE_ENUM && lane_type->data.enm.is_flags)) {
 			str_buf_t type_name = mir_type2str(expr_type, /* prefer_name */ true);
 			report_error_after(INVALID_TYPE,
 			                   unop->base.node,
@@ -7846,7 +8103,7 @@ struct result analyze_instr_unop(struct context *ctx, struct mir_instr_unop *uno
 
 	case UNOP_POS:
 	case UNOP_NEG: {
-		if (expr_type->kind != MIR_TYPE_INT && expr_type->kind != MIR_TYPE_REAL) {
+		if (lane_type->kind != MIR_TYPE_INT && lane_type->kind != MIR_TYPE_REAL) {
 			str_buf_t type_name = mir_type2str(expr_type, /* prefer_name */ true);
 			report_error_after(INVALID_TYPE,
 			                   unop->base.node,
@@ -8483,10 +8740,21 @@ struct result analyze_call_stage_validate_called_object(struct context *ctx, str
 
 				for (usize index = 0; index < sarrlenu(call->args); ++index) {
 					struct mir_instr *call_arg_instr = sarrpeek(call->args, index);
-					if (call_arg_instr->value.type && call_arg_instr->value.type->kind == MIR_TYPE_PLACEHOLDER) {
+					struct mir_type  *arg_type       = call_arg_instr->value.type;
+					if (!arg_type) continue;
+					if (arg_type->kind == MIR_TYPE_PLACEHOLDER) {
 						is_called_with_placeholder = true;
 						break;
 					}
+					// Unresolved polymorph type passed as compile-time type argument (e.g. 'simd_len(TVector)' used
+					// as array length in the signature) cannot be used to generate the function either.
+					if (arg_type->kind == MIR_TYPE_TYPE && mir_is_comptime(call_arg_instr)) {
+						struct mir_type *arg_value = MIR_CEV_READ_AS(struct mir_type *, &call_arg_instr->value);
+						if (arg_value && (arg_value->kind == MIR_TYPE_POLY || arg_value->kind == MIR_TYPE_PLACEHOLDER)) {
+							is_called_with_placeholder = true;
+							break;
+						}
+					}
 				}
 
 				if (is_called_with_placeholder) {
@@ -9851,7 +10119,7 @@ struct result analyze_instr(struct context *ctx, struct mir_instr *instr) {
 	return_zone(state);
 }
 
-static inline struct mir_instr *analyze_try_get_next(struct mir_instr *instr) {
+static inline struct mir_instr *analyze_try_get_next(struct context *ctx, struct mir_instr *instr) {
 	if (!instr) return NULL;
 	if (instr->kind == MIR_INSTR_BLOCK) {
 		struct mir_instr_block *block = (struct mir_instr_block *)instr;
@@ -9866,7 +10134,9 @@ static inline struct mir_instr *analyze_try_get_next(struct mir_instr *instr) {
 			// Instruction is last instruction of the function body, so the
 			// function can be executed in compile time if needed, we need to
 			// set flag with this information here.
-			owner_block->owner_fn->is_fully_analyzed = true;
+			struct mir_fn *fn = owner_block->owner_fn;
+			if (!fn->is_fully_analyzed) arrput(ctx->analyze->analyzed_fns, fn);
+			fn->is_fully_analyzed = true;
 		}
 
 		// Return following block.
@@ -9878,7 +10148,7 @@ static inline struct mir_instr *analyze_try_get_next(struct mir_instr *instr) {
 
 static inline struct mir_instr *analyze_get_next_instr(struct context *ctx, struct mir_instr *curr_instr, usize *index, usize *stack_index, bool skip) {
 	if (!skip) {
-		struct mir_instr *next = analyze_try_get_next(curr_instr);
+		struct mir_instr *next = analyze_try_get_next(ctx, curr_instr);
 		if (next) return next;
 	}
 
@@ -10398,6 +10668,12 @@ struct mir_var *rtti_gen_array(struct context *ctx, struct mir_type *type) {
 
 	vm_write_int(dest_len_type, dest_len, (u64)type->data.array.len);
 
+	// is_vector
+	struct mir_type *dest_is_vector_type = mir_get_struct_elem_type(rtti_type, 4);
+	vm_stack_ptr_t   dest_is_vector      = vm_get_struct_elem_ptr(ctx->assembly, rtti_type, dest, 4);
+
+	vm_write_int(dest_is_vector_type, dest_is_vector, (u64)type->data.array.is_vector);
+
 	return rtti_var;
 }
 
@@ -10783,6 +11059,7 @@ struct mir_instr *ast_stmt_if(struct context *ctx, struct ast *stmt_if) {
 	set_current_block(ctx, root_block);
 	struct mir_instr *br = append_instr_cond_br(ctx, stmt_if, cond, then_block, else_block ? else_block : continue_block, is_static);
 	if (ternary_phi) ternary_phi->origin_br = br;
+	((struct mir_instr_cond_br *)br)->hint = stmt_if->data.stmt_if.hint;
 
 	// Terminate all previous blocks
 	if (!is_block_terminated(last_then_block)) {
@@ -11259,6 +11536,13 @@ struct mir_instr *ast_expr_call(struct context *ctx, struct ast *call) {
 			return append_instr_msg(ctx, call, args, MIR_USER_MSG_ERROR);
 		} else if (is_builtin(ident, BUILTIN_ID_COMPILER_WARNING)) {
 			return append_instr_msg(ctx, call, args, MIR_USER_MSG_WARNING);
+		} else if (is_builtin(ident, BUILTIN_ID_SIMD)) {
+			// SIMD vector type 'simd(T, N)' is represented as an array type marked as vector.
+			if (sarrlenu(args) != 2) {
+				report_invalid_call_argument_count(ctx, call, 2, sarrlenu(args));
+				return append_instr_const_void(ctx, call);
+			}
+			return append_instr_type_array(ctx, call, NULL, sarrpeek(args, 0), sarrpeek(args, 1), true);
 		}
 	}
 
@@ -11297,6 +11581,7 @@ struct mir_instr *ast_expr_catch(struct context *ctx, struct ast *catch) {
 
 	struct mir_instr_cond_br *br = (struct mir_instr_cond_br *)append_instr_cond_br(ctx, catch, cond, catch_block, continue_block, false);
 	br->is_catch                 = true;
+	br->hint                     = BRANCH_HINT_UNLIKELY; // Errors are not expected.
 
 	// catch block
 	set_current_block(ctx, catch_block);
@@ -11405,6 +11690,16 @@ struct mir_instr *_ast_expr_lit_fn(struct context *ctx, ast_expr_lit_fn_args_t *
 		}
 	}
 
+	struct ast *ast_target_clones = args->lit_fn->data.expr_fn.target_clones;
+	if (ast_target_clones) {
+		bassert(ast_target_clones->kind == AST_EXPR_LIT_STRING);
+		if (isflag(args->flags, FLAG_EXTERN) || isflag(args->flags, FLAG_INTRINSIC)) {
+			report_error(UNEXPECTED_DIRECTIVE, ast_target_clones, "Target clones cannot be generated for external or intrinsic functions.");
+		} else {
+			fn->target_clones = ast_target_clones->data.expr_string.val;
+		}
+	}
+
 	MIR_CEV_WRITE_AS(struct mir_fn *, &fn_proto->base.value, fn);
 
 	if ((isflag(fn->flags, FLAG_EXTERN) || isflag(fn->flags, FLAG_INTRINSIC) || isflag(fn->flags, FLAG_EXPORT)) && fn->generated_flavor) {
@@ -12112,7 +12407,7 @@ struct mir_instr *ast_type_arr(struct context *ctx, struct ast *type_arr, s64 ov
 
 	struct mir_instr *elem_type = ast(ctx, ast_elem_type);
 	struct id        *id        = type_arr->data.type_arr.user_id;
-	return append_instr_type_array(ctx, type_arr, id, elem_type, len);
+	return append_instr_type_array(ctx, type_arr, id, elem_type, len, false);
 }
 
 struct mir_instr *ast_type_slice(struct context *ctx, struct ast *type_slice) {
@@ -12738,6 +13033,12 @@ static void _type2str(str_buf_t *buf, const struct mir_type *type, bool prefer_n
 	}
 
 	case MIR_TYPE_ARRAY: {
+		if (type->data.array.is_vector) {
+			str_buf_append(buf, cstr("simd("));
+			_type2str(buf, type->data.array.elem_type, true);
+			str_buf_append_fmt(buf, ", {u64})", (u64)type->data.array.len);
+			break;
+		}
 		str_buf_append_fmt(buf, "[{u64}]", (u64)type->data.array.len);
 		_type2str(buf, type->data.array.elem_type, true);
 		break;
@@ -12895,6 +13196,25 @@ str_t get_intrinsic(const str_t name) {
 	    cstr("__intrinsic_trunc_f32"),
 	    cstr("trunc.f64"),
 	    cstr("__intrinsic_trunc_f64"),
+
+#define ATOMIC_INTRINSIC(op, bits) cstr("atomic." #op ".i" #bits), cstr("__intrinsic_atomic_" #op "_i" #bits)
+#define ATOMIC_INTRINSICS(op) ATOMIC_INTRINSIC(op, 8), ATOMIC_INTRINSIC(op, 16), ATOMIC_INTRINSIC(op, 32), ATOMIC_INTRINSIC(op, 64)
+	    ATOMIC_INTRINSICS(load),
+	    ATOMIC_INTRINSICS(store),
+	    ATOMIC_INTRINSICS(xchg),
+	    ATOMIC_INTRINSICS(cmpxchg),
+	    ATOMIC_INTRINSICS(add),
+	    ATOMIC_INTRINSICS(sub),
+	    ATOMIC_INTRINSICS(and),
+	    ATOMIC_INTRINSICS(or),
+	    ATOMIC_INTRINSICS(xor),
+#undef ATOMIC_INTRINSICS
+#undef ATOMIC_INTRINSIC
+	    cstr("atomic.fence"),
+	    cstr("__intrinsic_atomic_fence"),
+
+	    cstr("prefetch"),
+	    cstr("__intrinsic_prefetch"),
 	};
 
 	for (usize i = 0; i < static_arrlenu(map); i += 2) {
@@ -12940,7 +13260,7 @@ static void init_context(struct context *ctx, struct assembly *assembly) {
 	ctx->assembly      = assembly;
 	ctx->debug_mode    = assembly->target->opt == ASSEMBLY_OPT_DEBUG;
 	ctx->builtin_types = &assembly->builtin_types;
-	ctx->vm            = &assembly->vm;
+	ctx->vm            = assembly_get_vm(assembly);
 	ctx->mir           = &assembly->mir;
 	ctx->analyze       = &assembly->mir.analyze;
 
@@ -13021,6 +13341,11 @@ static void initialize_builtins(struct assembly *assembly) {
 	// of comptime functions.
 	assembly->is_comptime = add_builtin_global_bool(&ctx, &builtin_ids[BUILTIN_ID_IS_COMPTIME], true, false);
 
+	// Add IS_PGO_GENERATE immutable into the global scope, the runtime must write the execution
+	// profile at exit when the binary is instrumented.
+	const bool is_pgo_generate = use_pgo(assembly->target) && assembly->target->pgo == ASSEMBLY_PGO_GENERATE;
+	add_builtin_global_bool(&ctx, &builtin_ids[BUILTIN_ID_IS_PGO_GENERATE], false, is_pgo_generate);
+
 	// Compiler version.
 	add_builtin_global_int(&ctx, &builtin_ids[BUILTIN_ID_BLC_VER_MAJOR], false, bt->t_s32, BL_VERSION_MAJOR);
 	add_builtin_global_int(&ctx, &builtin_ids[BUILTIN_ID_BLC_VER_MINOR], false, bt->t_s32, BL_VERSION_MINOR);
@@ -13042,6 +13367,7 @@ void mir_init(struct assembly *assembly) {
 	tbl_init(mir->type_cache, 2048);
 	tbl_init(mir->rtti_table, 2048);
 	tbl_init(mir->analyze.skipped_instructions, 1024);
+	tbl_init(mir->analyze.comptime_call_cache, 256);
 	arrsetcap(mir->global_instrs, 4096);
 	arrsetcap(mir->exported_instrs, 256);
 	arrsetcap(mir->analyze.usage_check_arr, 256);
@@ -13079,6 +13405,8 @@ void mir_terminate(struct assembly *assembly) {
 	arrfree(mir->analyze.stack[0]);
 	arrfree(mir->analyze.stack[1]);
 	tbl_free(mir->analyze.skipped_instructions);
+	tbl_free(mir->analyze.comptime_call_cache);
+	arrfree(mir->analyze.analyzed_fns);
 	tbl_free(mir->analyze.waiting);
 	arrfree(mir->analyze.usage_check_arr);
 	sarrfree(&mir->analyze.incomplete_rtti);
@@ -13153,6 +13481,277 @@ DONE:
 	return_zone();
 }
 
+//
+// MIR optimizer
+//
+
+// Runs on all fully analyzed functions after the analyze pass, so the VM, the x64 backend and the
+// LLVM backend (even without any LLVM passes in debug mode) get the same simplified code.
+// Constant folding and removal of unused instructions are already done during analyze; here we
+// fold remaining compile-time known switches, propagate sources of temporary no-op casts into
+// their users and clean up the block graph. Instruction order is never changed, the VM is stack
+// based and backends rely on values being defined before use in block order.
+//
+// @Incomplete: Inlining of #inline leaf functions is not done here. The VM allocates locals per
+// function frame and arguments are accessed through the call frame, so inlined callee would need
+// its own variable relocation and argument remapping.
+
+static inline bool is_phi_block(struct mir_instr_block *block) {
+	return block->entry_instr && block->entry_instr->kind == MIR_INSTR_PHI;
+}
+
+static bool has_phi_successor(struct mir_instr_block *block) {
+	struct mir_instr *terminal = block->terminal;
+	bassert(terminal);
+	switch (terminal->kind) {
+	case MIR_INSTR_BR:
+		return is_phi_block(((struct mir_instr_br *)terminal)->then_block);
+	case MIR_INSTR_COND_BR: {
+		struct mir_instr_cond_br *br = (struct mir_instr_cond_br *)terminal;
+		return is_phi_block(br->then_block) || is_phi_block(br->else_block);
+	}
+	case MIR_INSTR_SWITCH: {
+		struct mir_instr_switch *sw = (struct mir_instr_switch *)terminal;
+		if (is_phi_block(sw->default_block)) return true;
+		for (usize i = 0; i < sarrlenu(sw->cases); ++i) {
+			if (is_phi_block(sarrpeek(sw->cases, i).block)) return true;
+		}
+		return false;
+	}
+	default:
+		return false;
+	}
+}
+
+static bool fold_comptime_switch(struct mir_instr_switch *sw) {
+	if (!mir_is_comptime(sw->value)) return false;
+	const u64 v = vm_read_int(sw->value->value.type, sw->value->value.data);
+
+	struct mir_instr_block *continue_block = sw->default_block;
+	for (usize i = 0; i < sarrlenu(sw->cases); ++i) {
+		struct mir_switch_case *c = &sarrpeek(sw->cases, i);
+		if (vm_read_int(c->on_value->value.type, c->on_value->value.data) == v) {
+			continue_block = c->block;
+			break;
+		}
+	}
+
+	// All dropped blocks are unreferenced here, in case they are not used anymore, they are
+	// erased later.
+	for (usize i = 0; i < sarrlenu(sw->cases); ++i) {
+		struct mir_switch_case *c = &sarrpeek(sw->cases, i);
+		unref_instr(&c->block->base);
+		unref_instr(c->on_value);
+	}
+	unref_instr(&sw->default_block->base);
+	ref_instr(&continue_block->base);
+
+	unref_instr(sw->value);
+	if (sw->value->ref_count == 0) erase_instr_tree(sw->value, false, false);
+
+	struct mir_instr_br *br = mutate_instr(&sw->base, MIR_INSTR_BR);
+	br->then_block          = continue_block;
+	return true;
+}
+
+// Returns the final destination of a jump into the block; blocks containing only unconditional
+// break are skipped unless the destination starts with phi (its incoming blocks would change).
+static struct mir_instr_block *thread_jump(struct mir_fn *fn, struct mir_instr_block *block) {
+	s32 depth = 0;
+	while (depth++ < 16) {
+		if (block == fn->entry_block || block->is_unreachable) break;
+		struct mir_instr *terminal = block->terminal;
+		if (!terminal || terminal->kind != MIR_INSTR_BR || block->entry_instr != terminal) break;
+		struct mir_instr_block *dest = ((struct mir_instr_br *)terminal)->then_block;
+		if (dest == block || is_phi_block(dest)) break;
+
+		unref_instr(&block->base);
+		ref_instr(&dest->base);
+		block = dest;
+	}
+	return block;
+}
+
+// Merge the following block into the block in case the block is its only predecessor.
+static bool merge_next_block(struct mir_fn *fn, struct mir_instr_block *block) {
+	struct mir_instr *terminal = block->terminal;
+	if (!terminal || terminal->kind != MIR_INSTR_BR || block->is_unreachable) return false;
+
+	struct mir_instr_block *next = ((struct mir_instr_br *)terminal)->then_block;
+	if (&next->base != block->base.next) return false;
+	if (next == fn->exit_block || next->is_unreachable || next->base.ref_count != 1) return false;
+	if (is_phi_block(next) || has_phi_successor(next)) return false;
+	bassert(next->entry_instr && next->terminal);
+
+	erase_instr(terminal);
+	unref_instr(&next->base);
+
+	for (struct mir_instr *instr = next->entry_instr; instr; instr = instr->next) {
+		instr->owner_block = block;
+	}
+
+	next->entry_instr->prev = block->last_instr;
+	if (block->last_instr) {
+		block->last_instr->next = next->entry_instr;
+	} else {
+		block->entry_instr = next->entry_instr;
+	}
+	block->last_instr = next->last_instr;
+	block->terminal   = next->terminal;
+
+	next->entry_instr = NULL;
+	next->last_instr  = NULL;
+	next->terminal    = NULL;
+	erase_instr(&next->base);
+	return true;
+}
+
+static inline bool is_noop_cast(struct mir_instr *instr) {
+	if (!instr || instr->kind != MIR_INSTR_CAST || instr->state == MIR_IS_ERASED) return false;
+	struct mir_instr_cast *cast = (struct mir_instr_cast *)instr;
+	if (cast->op != MIR_CAST_NONE || cast->base.ref_count != 1) return false;
+	if (mir_is_comptime(&cast->base) || mir_is_comptime(cast->expr)) return false;
+	return mir_type_cmp(cast->base.value.type, cast->expr->value.type);
+}
+
+// Replace the operand by the source value in case it's a temporary no-op cast; the cast does not
+// produce any code or VM stack value, so it's just erased. Returns count of erased instructions.
+static s32 propagate_operand(struct mir_instr **operand) {
+	s32 count = 0;
+	while (is_noop_cast(*operand)) {
+		struct mir_instr_cast *cast = (struct mir_instr_cast *)*operand;
+		*operand                    = cast->expr;
+		unref_instr(cast->type);
+		unref_instr(&cast->base);
+		erase_instr(&cast->base);
+		++count;
+	}
+	return count;
+}
+
+static s32 propagate_operands(mir_instrs_t *operands) {
+	s32 count = 0;
+	for (usize i = 0; i < sarrlenu(operands); ++i) {
+		count += propagate_operand(&sarrpeek(operands, i));
+	}
+	return count;
+}
+
+// Copy propagation; returns count of erased instructions. Only operands of the instructions
+// listed here are considered, anything else keeps its casts.
+static s32 propagate_copies(struct mir_instr *instr) {
+	switch (instr->kind) {
+	case MIR_INSTR_LOAD:
+		return propagate_operand(&((struct mir_instr_load *)instr)->src);
+	case MIR_INSTR_STORE: {
+		struct mir_instr_store *store = (struct mir_instr_store *)instr;
+		return propagate_operand(&store->src) + propagate_operand(&store->dest);
+	}
+	case MIR_INSTR_DECL_VAR:
+		return propagate_operand(&((struct mir_instr_decl_var *)instr)->init);
+	case MIR_INSTR_BINOP: {
+		struct mir_instr_binop *binop = (struct mir_instr_binop *)instr;
+		return propagate_operand(&binop->lhs) + propagate_operand(&binop->rhs);
+	}
+	case MIR_INSTR_UNOP:
+		return propagate_operand(&((struct mir_instr_unop *)instr)->expr);
+	case MIR_INSTR_CAST:
+		return propagate_operand(&((struct mir_instr_cast *)instr)->expr);
+	case MIR_INSTR_ELEM_PTR: {
+		struct mir_instr_elem_ptr *ep = (struct mir_instr_elem_ptr *)instr;
+		return propagate_operand(&ep->arr_ptr) + propagate_operand(&ep->index);
+	}
+	case MIR_INSTR_MEMBER_PTR:
+		return propagate_operand(&((struct mir_instr_member_ptr *)instr)->target_ptr);
+	case MIR_INSTR_CALL: {
+		struct mir_instr_call *call = (struct mir_instr_call *)instr;
+		return propagate_operand(&call->callee) + propagate_operands(call->args);
+	}
+	case MIR_INSTR_RET:
+		return propagate_operand(&((struct mir_instr_ret *)instr)->value);
+	case MIR_INSTR_COND_BR:
+		return propagate_operand(&((struct mir_instr_cond_br *)instr)->cond);
+	case MIR_INSTR_SWITCH:
+		return propagate_operand(&((struct mir_instr_switch *)instr)->value);
+	default:
+		return 0;
+	}
+}
+
+static s32 count_blocks(struct mir_fn *fn) {
+	s32 count = 0;
+	for (struct mir_instr *block = &fn->entry_block->base; block; block = block->next) ++count;
+	return count;
+}
+
+// Returns count of removed blocks, count of removed instructions is added to 'removed_instrs'.
+static s32 optimize_fn(struct mir_fn *fn, s32 *removed_instrs) {
+	zone();
+	bassert(fn->entry_block);
+	const s32 block_count = count_blocks(fn);
+
+	struct mir_instr_block *block;
+	for (block = fn->entry_block; block; block = (struct mir_instr_block *)block->base.next) {
+		for (struct mir_instr *instr = block->entry_instr; instr; instr = instr->next) {
+			(*removed_instrs) += propagate_copies(instr);
+		}
+
+		struct mir_instr *terminal = block->terminal;
+		if (!terminal) continue;
+		if (terminal->kind == MIR_INSTR_SWITCH && !fold_comptime_switch((struct mir_instr_switch *)terminal)) continue;
+
+		switch (terminal->kind) {
+		case MIR_INSTR_BR: {
+			struct mir_instr_br *br = (struct mir_instr_br *)terminal;
+			br->then_block          = thread_jump(fn, br->then_block);
+			break;
+		}
+		case MIR_INSTR_COND_BR: {
+			struct mir_instr_cond_br *br = (struct mir_instr_cond_br *)terminal;
+			br->then_block               = thread_jump(fn, br->then_block);
+			br->else_block               = thread_jump(fn, br->else_block);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	// Erase all unreferenced blocks, this may cascade into their successors.
+	array(struct mir_instr_block *) dead_blocks = NULL;
+	for (block = fn->entry_block; block; block = (struct mir_instr_block *)block->base.next) {
+		if (block != fn->entry_block && block->base.ref_count == 0) arrput(dead_blocks, block);
+	}
+	for (usize i = 0; i < arrlenu(dead_blocks); ++i) {
+		if (dead_blocks[i]->base.state != MIR_IS_ERASED) erase_block(&dead_blocks[i]->base);
+	}
+	arrfree(dead_blocks);
+
+	for (block = fn->entry_block; block; block = (struct mir_instr_block *)block->base.next) {
+		while (merge_next_block(fn, block)) {
+		}
+	}
+
+	return_zone(block_count - count_blocks(fn));
+}
+
+void mir_opt_run(struct assembly *assembly) {
+	runtime_measure_begin(mir_opt);
+	zone();
+	struct mir_analyze *analyze        = &assembly->mir.analyze;
+	s32                 removed_blocks = 0;
+	s32                 removed_instrs = 0;
+	for (usize i = 0; i < arrlenu(analyze->analyzed_fns); ++i) {
+		struct mir_fn *fn = analyze->analyzed_fns[i];
+		if (!fn->entry_block) continue;
+		removed_blocks += optimize_fn(fn, &removed_instrs);
+	}
+	batomic_fetch_add_s32(&assembly->stats.mir_opt_removed_blocks, removed_blocks);
+	batomic_fetch_add_s32(&assembly->stats.mir_opt_removed_instrs, removed_instrs);
+	batomic_fetch_add_s32(&assembly->stats.mir_analyze_ms, runtime_measure_end(mir_opt));
+	return_zone();
+}
+
 //
 // Comptime API
 //
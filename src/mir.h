@@ -16,6 +16,9 @@
 
 #define MIR_NO_REF_COUNTING (-1)
 
+// Maximum size of SIMD vector type in bytes (512-bit registers).
+#define MIR_VECTOR_MAX_SIZE 64
+
 #if BL_ASSERT_ENABLE
 vm_stack_ptr_t _mir_cev_read(struct mir_const_expr_value *value);
 #else
@@ -91,6 +94,12 @@ struct mir_rtti_incomplete {
 };
 typedef sarr_t(struct mir_rtti_incomplete, 64) mir_rttis_t;
 
+struct comptime_call_cache_entry {
+	hash_t         hash;
+	str_t          key; // Callee and argument values.
+	vm_stack_ptr_t data;
+};
+
 struct rtti_table_entry {
 	hash_t          hash;
 	struct mir_var *value;
@@ -133,6 +142,12 @@ struct mir_analyze {
 	// Table of instruction being skipped in analyze pass, this should be empty at the end
 	// of analyze!
 	hash_table(struct skipped_instr_entry) skipped_instructions;
+
+	// Results of already evaluated compile-time calls of pure functions.
+	hash_table(struct comptime_call_cache_entry) comptime_call_cache;
+
+	// All functions with fully analyzed body; used by MIR optimizer.
+	array(struct mir_fn *) analyzed_fns;
 };
 
 struct mir {
@@ -231,8 +246,8 @@ enum builtin_id_kind {
 extern struct id builtin_ids[_BUILTIN_ID_COUNT];
 
 struct dyncall_cb_context {
-	struct virtual_machine *vm;
-	struct mir_fn          *fn;
+	struct assembly *assembly;
+	struct mir_fn   *fn;
 };
 
 struct recipe_entry {
@@ -256,6 +271,13 @@ enum mir_fn_generated_flavor_flags {
 	MIR_FN_GENERATED_MIXED = 1 << 2,
 };
 
+enum mir_fn_purity {
+	MIR_FN_PURITY_UNKNOWN = 0,
+	MIR_FN_PURITY_CHECKING,
+	MIR_FN_PURE,
+	MIR_FN_IMPURE,
+};
+
 typedef sarr_t(struct ast *, 8) defer_stack_t;
 
 // FN
@@ -304,6 +326,7 @@ struct mir_fn {
 	bool                 is_fully_analyzed;
 	bool                 is_global;
 	bool                 is_disabled; // Set based on optional enable_if expression in function prototype.
+	enum mir_fn_purity   purity;      // Resolved lazily for compile-time call caching.
 	s32                  ref_count;
 	enum ast_flags       flags;
 	enum builtin_id_kind builtin_id;
@@ -323,6 +346,9 @@ struct mir_fn {
 		struct dyncall_cb_context context;
 	} dyncall;              // dyncall external context
 	str_t obsolete_message; // Optional, check len!
+	// Optional list of CPU feature sets additional function variants are generated for, the best
+	// variant is selected at load time (check len!).
+	str_t target_clones;
 
 	hash_table(struct block_entry) phi_block_mapping;
 	defer_stack_t defer_stack;
@@ -461,6 +487,8 @@ struct mir_type_null {
 struct mir_type_array {
 	struct mir_type *elem_type;
 	s64              len;
+	// SIMD vector type created by 'simd(T, N)', mapped to the LLVM vector type.
+	bool is_vector;
 };
 
 struct mir_type {
@@ -792,6 +820,7 @@ struct mir_instr_type_array {
 	struct mir_instr *elem_type;
 	struct mir_instr *len;
 	struct id        *id;
+	bool              is_vector;
 };
 
 struct mir_instr_type_slice {
@@ -890,6 +919,8 @@ struct mir_instr_cond_br {
 	bool keep_stack_value;
 	// Set in case this instruction is used implicitly in catch for error handling.
 	bool is_catch;
+	// Expected branch to be taken.
+	enum branch_hint hint;
 };
 
 struct mir_instr_br {
@@ -1053,6 +1084,17 @@ static inline struct mir_type *mir_deref_type(const struct mir_type *ptr) {
 	return ptr->data.ptr.expr;
 }
 
+static inline bool mir_is_vector_type(const struct mir_type *type) {
+	bassert(type);
+	return type->kind == MIR_TYPE_ARRAY && type->data.array.is_vector;
+}
+
+// Atomic intrinsics are named 'atomic.<operation>.i<bits>' or 'atomic.fence'.
+static inline bool is_atomic_intrinsic(const str_t name) {
+	const str_t prefix = cstr("atomic.");
+	return name.len > prefix.len && strncmp(name.ptr, prefix.ptr, prefix.len) == 0;
+}
+
 static inline bool mir_is_composite_type(const struct mir_type *type) {
 	bassert(type);
 	switch (type->kind) {
@@ -1166,6 +1208,7 @@ str_buf_t       mir_type2str(const struct mir_type *type, bool prefer_name);
 const char     *mir_instr_name(const struct mir_instr *instr);
 void            mir_unit_run(struct assembly *assembly, struct unit *unit);
 void            mir_analyze_run(struct assembly *assembly);
+void            mir_opt_run(struct assembly *assembly);
 struct mir_fn  *mir_get_callee(const struct mir_instr_call *call);
 str_t           mir_get_fn_readable_name(struct mir_fn *fn);
 
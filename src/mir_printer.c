@@ -57,8 +57,11 @@ static inline void print_flags(struct context *ctx, u32 flags) {
 	if (isflag(flags, FLAG_EXTERN)) fprintf(ctx->stream, "#extern");
 	if (isflag(flags, FLAG_COMPILER)) fprintf(ctx->stream, " #compiler");
 	if (isflag(flags, FLAG_TEST_FN)) fprintf(ctx->stream, " #test");
+	if (isflag(flags, FLAG_SERIAL)) fprintf(ctx->stream, " #serial");
 	if (isflag(flags, FLAG_INLINE)) fprintf(ctx->stream, " #inline");
 	if (isflag(flags, FLAG_NO_INLINE)) fprintf(ctx->stream, " #noinline");
+	if (isflag(flags, FLAG_HOT)) fprintf(ctx->stream, " #hot");
+	if (isflag(flags, FLAG_COLD)) fprintf(ctx->stream, " #cold");
 
 	fprintf(ctx->stream, " ");
 }
@@ -449,6 +452,13 @@ void print_instr_type_poly(struct context *ctx, struct mir_instr_type_poly *type
 
 void print_instr_type_array(struct context *ctx, struct mir_instr_type_array *type_array) {
 	print_instr_head(ctx, &type_array->base, "const");
+	if (type_array->is_vector) {
+		fprintf(ctx->stream,
+		        "simd(%%%llu, %%%llu)",
+		        (unsigned long long)type_array->elem_type->id,
+		        (unsigned long long)type_array->len->id);
+		return;
+	}
 	fprintf(ctx->stream,
 	        "[%%%llu]%%%llu",
 	        (unsigned long long)type_array->len->id,
@@ -654,6 +664,8 @@ void print_instr_cond_br(struct context *ctx, struct mir_instr_cond_br *cond_br)
 	        (unsigned long long)cond_br->then_block->base.id,
 	        STR_ARG(else_block),
 	        (unsigned long long)cond_br->else_block->base.id);
+	if (cond_br->hint == BRANCH_HINT_LIKELY) fprintf(ctx->stream, " #likely");
+	if (cond_br->hint == BRANCH_HINT_UNLIKELY) fprintf(ctx->stream, " #unlikely");
 }
 
 void print_instr_cond_insert(struct context *ctx, struct mir_instr_cond_insert *cond_insert) {
@@ -11,6 +11,7 @@ typedef s32 (*LinkerFn)(struct assembly *);
 
 s32 lld_link(struct assembly *assembly);
 s32 lld_ld(struct assembly *assembly);
+s32 elf_ld(struct assembly *assembly);
 
 static void copy_user_libs(struct assembly *assembly) {
 	str_buf_t            dest_path = get_tmp_str();
@@ -68,7 +69,9 @@ void native_bin_run(struct assembly *assembly) {
 
 	const str_t out_dir = str_buf_view(assembly->target->out_dir);
 	zone();
-	if (linker(assembly) != 0) {
+	// Try the built-in linker first; -1 means it's not usable for this assembly.
+	const s32 state = elf_ld(assembly);
+	if (state == -1 && linker(assembly) != 0) {
 		builder_msg(MSG_ERR, ERR_LIB_NOT_FOUND, NULL, CARET_WORD, "Native link execution failed.");
 		goto DONE;
 	}
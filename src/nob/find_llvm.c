@@ -2,6 +2,8 @@ const char *LLVM_VERSION     = "UNKNOWN";
 const char *LLVM_INCLUDE_DIR = "";
 const char *LLVM_LIB_DIR     = "";
 const char *LLVM_LIBS        = "";
+const char *LLD_LIBS         = ""; // Optional, used for in-process linking when available.
+bool        THIN_LTO_ENABLE  = false; // Optional, LLVM LTO library is not part of the bundled Windows package.
 
 void find_llvm(void) {
 	nob_log(NOB_INFO, "Looking for LLVM " STR(LLVM_REQUIRED) "...");
@@ -109,13 +111,6 @@ void find_llvm(void) {
 	sb.count         = 0;
 	nob_log(NOB_INFO, "LLVM " STR(LLVM_REQUIRED) " include directory found: %s", LLVM_INCLUDE_DIR);
 
-	// libraries
-	cmd_append(&cmd, llvm_config, "--link-static", "--libnames", "core", "support", "X86", "AArch64", "passes");
-	if (!cmd_run_sync_read_and_reset(&cmd, &sb)) exit(1);
-	if (sb.count == 0) exit(1);
-	LLVM_LIBS = trim_and_dup(sb);
-	sb.count  = 0;
-
 	// libdir
 	cmd_append(&cmd, llvm_config, "--libdir");
 	if (!cmd_run_sync_read_and_reset(&cmd, &sb)) exit(1);
@@ -124,5 +119,39 @@ void find_llvm(void) {
 	sb.count     = 0;
 	nob_log(NOB_INFO, "LLVM " STR(LLVM_REQUIRED) " lib directory found: %s", LLVM_LIB_DIR);
 
+	// ThinLTO (optional)
+	THIN_LTO_ENABLE = file_exists(temp_sprintf("%s/libLLVMLTO.a", LLVM_LIB_DIR)) > 0;
+	if (THIN_LTO_ENABLE) {
+		nob_log(NOB_INFO, "LLVM " STR(LLVM_REQUIRED) " LTO library found, ThinLTO is enabled.");
+	} else {
+		nob_log(NOB_INFO, "LLVM " STR(LLVM_REQUIRED) " LTO library not found, ThinLTO is disabled.");
+	}
+
+	// libraries
+	cmd_append(&cmd, llvm_config, "--link-static", "--libnames", "core", "support", "X86", "AArch64", "passes");
+	if (THIN_LTO_ENABLE) cmd_append(&cmd, "lto");
+	if (!cmd_run_sync_read_and_reset(&cmd, &sb)) exit(1);
+	if (sb.count == 0) exit(1);
+	LLVM_LIBS = trim_and_dup(sb);
+	sb.count  = 0;
+
+#ifdef __linux__
+	// LLD (optional)
+	if (file_exists(temp_sprintf("%s/lld/Common/Driver.h", LLVM_INCLUDE_DIR)) > 0 &&
+	    file_exists(temp_sprintf("%s/liblldELF.a", LLVM_LIB_DIR)) > 0 &&
+	    file_exists(temp_sprintf("%s/liblldCommon.a", LLVM_LIB_DIR)) > 0) {
+		LLD_LIBS = "liblldELF.a liblldCommon.a";
+		// LLD depends on additional LLVM components.
+		cmd_append(&cmd, llvm_config, "--link-static", "--libnames", "core", "support", "X86", "AArch64", "passes", "lto", "option");
+		if (!cmd_run_sync_read_and_reset(&cmd, &sb)) exit(1);
+		if (sb.count == 0) exit(1);
+		LLVM_LIBS = trim_and_dup(sb);
+		sb.count  = 0;
+		nob_log(NOB_INFO, "LLD " STR(LLVM_REQUIRED) " libraries found, using in-process linker.");
+	} else {
+		nob_log(NOB_INFO, "LLD " STR(LLVM_REQUIRED) " libraries not found, using external linker.");
+	}
+#endif
+
 #endif
 }
@@ -60,6 +60,7 @@ void blc(void) {
 	    "./src/common.c",
 	    "./src/conf.c",
 	    "./src/docs.c",
+	    "./src/elf_ld.c",
 	    "./src/file_loader.c",
 	    "./src/intrinsic.c",
 	    "./src/ir_opt.c",
@@ -153,6 +154,7 @@ void blc(void) {
 		cmd_append(&cmd, temp_sprintf("-DBL_DEBUG_ENABLE=%d", IS_DEBUG ? 1 : 0));
 		if (BL_SIMD_ENABLE) cmd_append(&cmd, "-DBL_USE_SIMD", "-arch:AVX");
 		if (BL_RPMALLOC_ENABLE) cmd_append(&cmd, "-DBL_RPMALLOC_ENABLE=1");
+		if (THIN_LTO_ENABLE) cmd_append(&cmd, "-DBL_THIN_LTO_ENABLE=1");
 		cmd_append(&cmd, is_cxx ? "-std:c++17" : "-std:c11");
 		db_add_entry(src[i], cmd);
 
@@ -239,6 +241,8 @@ void blc(void) {
 		cmd_append(&cmd, temp_sprintf("-DBL_DEBUG_ENABLE=%d", IS_DEBUG ? 1 : 0));
 		if (BL_SIMD_ENABLE) nob_log(NOB_WARNING, "BL_SIMD_ENABLE not supported on this platform.");
 		if (BL_RPMALLOC_ENABLE) cmd_append(&cmd, "-DBL_RPMALLOC_ENABLE=1");
+		if (strlen(LLD_LIBS)) cmd_append(&cmd, "-DBL_LLD_ENABLE=1");
+		if (THIN_LTO_ENABLE) cmd_append(&cmd, "-DBL_THIN_LTO_ENABLE=1");
 		cmd_append(&cmd, is_cxx ? "-std=c++17" : "-std=gnu11");
 		db_add_entry(src[i], cmd);
 
@@ -262,7 +266,8 @@ void blc(void) {
 		}
 
 		cmd_append(&cmd, BUILD_DIR "/libyaml/libyaml.a", BUILD_DIR "/dyncall/dyncall.a");
-		String_View libs = nob_sv_from_cstr(LLVM_LIBS);
+		// LLD libraries must go before LLVM libraries they depend on.
+		String_View libs = nob_sv_from_cstr(temp_sprintf("%s %s", LLD_LIBS, LLVM_LIBS));
 		while (libs.count) {
 			String_View lib = nob_sv_chop_by_delim(&libs, ' ');
 			if (lib.count)
@@ -309,6 +314,17 @@ void blc_runtime(void) {
 	nob_cmd_run_sync_and_reset(&cmd);
 }
 
+// Profile runtime of instrumented binaries depends on the raw profile format of the LLVM version
+// the compiler is built with, so it's compiled using LLVM headers found by setup.
+void blc_profile_runtime(void) {
+#ifdef __linux__
+	nob_log(NOB_INFO, "Compiling profile runtime.");
+	Cmd cmd = {0};
+	cmd_append(&cmd, "cc", "-c", "./src/rt/blprof.c", temp_sprintf("-I%s", LLVM_INCLUDE_DIR), "-fPIC", "-O2", "-DNDEBUG", "-o", "./lib/bl/rt/blprof_x86_64_linux.o");
+	if (!cmd_run_sync_and_reset(&cmd)) exit(1);
+#endif
+}
+
 void finalize(void) {
 #ifdef _WIN32
 	if (!file_exists(BIN_DIR "/bl-lld.exe")) {
@@ -1,6 +1,162 @@
 #include "builder.h"
+#include "llvm_api.h"
 #include "stb_ds.h"
 
+// Count of partitions the module is split into when the object cache or ThinLTO is used. Fixed
+// count keeps the function-to-partition assignment stable between compilations, so only partitions
+// containing changed functions must be compiled again.
+#define PARTITION_COUNT 32
+
+// Counter making names of temporary cache files unique within the process.
+static batomic_s32 tmp_file_counter;
+
+struct obj_cache_ctx {
+	struct assembly *assembly;
+	str_t            dir;
+	str_t            salt;
+};
+
+static void emit_cached_partition(void *ctx, LLVMModuleRef partition) {
+	struct obj_cache_ctx *cache    = ctx;
+	struct assembly      *assembly = cache->assembly;
+
+	char hash[33];
+	llvm_module_hash(partition, cache->salt, hash);
+
+	str_buf_t filepath = get_tmp_str();
+	str_buf_append_fmt(&filepath, "{str}/{s}.{s}", cache->dir, hash, OBJ_EXT);
+	batomic_fetch_add_s32(&assembly->stats.obj_cache_partitions, 1);
+	if (file_exists(filepath)) {
+		batomic_fetch_add_s32(&assembly->stats.obj_cache_hits, 1);
+	} else {
+		// Emit into temporary file first, so interrupted compilation does not leave incomplete
+		// object in the cache. The name is unique, the cache directory might be shared by multiple
+		// compilations running at the same time.
+		str_buf_t tmp_filepath = get_tmp_str();
+		str_buf_append_fmt(&tmp_filepath,
+		                   "{str}.{u32}-{s32}.tmp",
+		                   str_buf_view(filepath),
+		                   get_process_id(),
+		                   batomic_fetch_add_s32(&tmp_file_counter, 1));
+		char *error_msg = NULL;
+		if (LLVMTargetMachineEmitToFile(assembly->llvm.TM,
+		                                partition,
+		                                str_buf_to_c(tmp_filepath),
+		                                LLVMObjectFile,
+		                                &error_msg)) {
+			builder_error(
+			    "Cannot emit object file: " STR_FMT " with error: %s", STR_ARG(tmp_filepath), error_msg);
+		} else if (rename(str_buf_to_c(tmp_filepath), str_buf_to_c(filepath)) != 0) {
+			// Rename does not replace existing file on Windows; in case the same object was
+			// written by other compilation in the meantime, we just use it.
+			remove(str_buf_to_c(tmp_filepath));
+			if (!file_exists(filepath)) {
+				builder_error("Cannot move object file to cache: " STR_FMT, STR_ARG(filepath));
+			}
+		}
+		LLVMDisposeMessage(error_msg);
+		put_tmp_str(tmp_filepath);
+	}
+	arrput(assembly->llvm.obj_files, strdup(str_buf_to_c(filepath)));
+	put_tmp_str(filepath);
+	LLVMDisposeModule(partition);
+}
+
+// Split the module into partitions and reuse object files of unchanged partitions from the cache
+// directory.
+//
+// @Incomplete: Unique linkage names of symbols are numbered in order of the analysis, which
+// differs between multi-threaded compilations, so the cache is effective only in single-thread
+// mode for now.
+static void emit_cached(struct assembly *assembly) {
+	const struct target *target = assembly->target;
+	const str_t          dir    = make_str_from_c(target->obj_cache_dir);
+	if (!dir_exists(dir) && !create_dir_tree(dir)) {
+		builder_error("Cannot create object cache directory: " STR_FMT, STR_ARG(dir));
+		return;
+	}
+
+	// Everything affecting the generated code except the module itself.
+	str_buf_t salt     = get_tmp_str();
+	char     *triple   = LLVMGetTargetMachineTriple(assembly->llvm.TM);
+	char     *cpu      = LLVMGetTargetMachineCPU(assembly->llvm.TM);
+	char     *features = LLVMGetTargetMachineFeatureString(assembly->llvm.TM);
+	str_buf_append_fmt(&salt,
+	                   "{s};{s};{s};{s};{s32};{s32};{s32}",
+	                   BL_VERSION,
+	                   triple,
+	                   cpu,
+	                   features,
+	                   target->kind,
+	                   target->opt,
+	                   target->di);
+	LLVMDisposeMessage(triple);
+	LLVMDisposeMessage(cpu);
+	LLVMDisposeMessage(features);
+
+	struct obj_cache_ctx ctx = {
+	    .assembly = assembly,
+	    .dir      = dir,
+	    .salt     = str_buf_view(salt),
+	};
+	llvm_split_module(assembly->llvm.module, PARTITION_COUNT, &emit_cached_partition, &ctx);
+	put_tmp_str(salt);
+}
+
+#if BL_THIN_LTO_ENABLE
+struct thin_lto_ctx {
+	struct assembly    *assembly;
+	llvm_thin_lto_ref_t lto;
+	s32                 partition_index;
+};
+
+static void add_thin_lto_partition(void *ctx, LLVMModuleRef partition) {
+	struct thin_lto_ctx *lto = ctx;
+	// Each partition must have unique identifier.
+	str_buf_t id = get_tmp_str();
+	str_buf_append_fmt(&id, "{s}.{s32}", lto->assembly->target->name, lto->partition_index++);
+	LLVMSetModuleIdentifier(partition, id.ptr, id.len);
+	llvm_thin_lto_add_module(lto->lto, partition);
+	put_tmp_str(id);
+	LLVMDisposeModule(partition);
+}
+
+static void add_thin_lto_obj_file(void *ctx, const char *filepath) {
+	struct assembly *assembly = ctx;
+	arrput(assembly->llvm.obj_files, strdup(filepath));
+}
+
+// Optimize and compile module partitions in parallel using ThinLTO.
+static void emit_thin_lto(struct assembly *assembly) {
+	const struct target *target = assembly->target;
+
+	str_buf_t objects_dir = get_tmp_str();
+	str_buf_append_fmt(&objects_dir, "{str}/{s}-thinlto", str_buf_view(target->out_dir), target->name);
+	if (!dir_exists(objects_dir) && !create_dir(objects_dir)) {
+		builder_error("Cannot create directory: " STR_FMT, STR_ARG(objects_dir));
+		put_tmp_str(objects_dir);
+		return;
+	}
+	const char *cache_dir = target->lto_cache_dir;
+	if (cache_dir && !dir_exists(make_str_from_c(cache_dir)) && !create_dir_tree(make_str_from_c(cache_dir))) {
+		builder_warning("Cannot create ThinLTO cache directory '%s', cache is not used.", cache_dir);
+		cache_dir = NULL;
+	}
+
+	struct thin_lto_ctx ctx = {
+	    .assembly = assembly,
+	    .lto      = llvm_thin_lto_create(assembly->llvm.TM, cache_dir, str_buf_to_c(objects_dir)),
+	};
+	// Symbols defined with non-local linkage before the split must keep it; locals externalized
+	// by the split can be internalized again.
+	llvm_thin_lto_preserve_symbols(ctx.lto, assembly->llvm.module);
+	llvm_split_module(assembly->llvm.module, PARTITION_COUNT, &add_thin_lto_partition, &ctx);
+	llvm_thin_lto_run(ctx.lto, &add_thin_lto_obj_file, assembly);
+	llvm_thin_lto_dispose(ctx.lto);
+	put_tmp_str(objects_dir);
+}
+#endif
+
 // Emit assembly object file.
 void obj_writer_run(struct assembly *assembly) {
 	zone();
@@ -13,6 +169,41 @@ void obj_writer_run(struct assembly *assembly) {
 	blog("out_dir = " STR_FMT, STR_ARG(target->out_dir));
 	blog("name = %s", name);
 
+#if BL_THIN_LTO_ENABLE
+	if (use_thin_lto(target)) {
+		emit_thin_lto(assembly);
+		put_tmp_str(buf);
+		batomic_fetch_add_s32(&assembly->stats.llvm_obj_ms, runtime_measure_end(llvm_obj_generation));
+		return_zone();
+	}
+#endif
+
+	if (target->obj_cache_dir) {
+		emit_cached(assembly);
+		put_tmp_str(buf);
+		batomic_fetch_add_s32(&assembly->stats.llvm_obj_ms, runtime_measure_end(llvm_obj_generation));
+		return_zone();
+	}
+
+#if BL_PLATFORM_LINUX
+	// Object file is passed to the linker directly from memory unless we're explicitly asked to
+	// keep it on disk.
+	if (!target->emit_obj) {
+		char *error_msg = NULL;
+		if (LLVMTargetMachineEmitToMemoryBuffer(assembly->llvm.TM,
+		                                        assembly->llvm.module,
+		                                        LLVMObjectFile,
+		                                        &error_msg,
+		                                        &assembly->llvm.obj)) {
+			builder_error("Cannot emit object file into memory with error: %s", error_msg);
+		}
+		LLVMDisposeMessage(error_msg);
+		put_tmp_str(buf);
+		batomic_fetch_add_s32(&assembly->stats.llvm_obj_ms, runtime_measure_end(llvm_obj_generation));
+		return_zone();
+	}
+#endif
+
 	str_buf_append_fmt(&buf, "{str}/{s}.{s}", target->out_dir, name, OBJ_EXT);
 	char *error_msg = NULL;
 	if (LLVMTargetMachineEmitToFile(assembly->llvm.TM,
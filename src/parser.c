@@ -28,15 +28,18 @@
 	} \
 	(void)0
 
-enum hash_directive_flags {
-#define HD_GEN(kind, name, flag) kind = flag,
+// Hash directive kinds, the value is also index of the directive bit in directive masks.
+enum hash_directive_kind {
+#define HD_GEN(kind, name, bit) kind = bit,
 #include "parser.def"
 #undef HD_GEN
 };
 
+#define HD_MASK(kind) (1ull << (kind))
+
 struct hash_directive_entry {
-	hash_t                    hash;
-	enum hash_directive_flags value;
+	hash_t                   hash;
+	enum hash_directive_kind value;
 };
 
 struct context {
@@ -71,7 +74,7 @@ static enum assign_kind sym_to_assing_kind(enum sym sm);
 static bool             parse_docs(struct context *ctx);
 static bool             parse_unit_docs(struct context *ctx);
 static void             parse_ublock_content(struct context *ctx, struct ast *ublock);
-static struct ast      *parse_hash_directive(struct context *ctx, s32 expected_mask, enum hash_directive_flags *satisfied, const bool is_in_expression);
+static struct ast      *parse_hash_directive(struct context *ctx, u64 expected_mask, enum hash_directive_kind *satisfied, const bool is_in_expression);
 static struct ast      *parse_unrecheable(struct context *ctx);
 static struct ast      *parse_debugbreak(struct context *ctx);
 static struct ast      *parse_ident_group(struct context *ctx);
@@ -98,6 +101,7 @@ static struct ast      *parse_type_vargs(struct context *ctx);
 static struct ast      *parse_stmt_return(struct context *ctx);
 static struct ast      *parse_stmt_using(struct context *ctx);
 static struct ast      *parse_stmt_if(struct context *ctx, bool is_static);
+static enum branch_hint parse_branch_hint(struct context *ctx, bool is_static);
 static struct ast      *parse_stmt_loop(struct context *ctx);
 static struct ast      *parse_stmt_break(struct context *ctx);
 static struct ast      *parse_stmt_continue(struct context *ctx);
@@ -128,7 +132,7 @@ static struct ast *parse_expr_test_cases(struct context *ctx);
 static struct ast *parse_expr_capture_last(struct context *ctx);
 static inline bool parse_semicolon(struct context *ctx);
 static inline bool parse_semicolon_rq(struct context *ctx);
-static inline bool hash_directive_to_flags(enum hash_directive_flags hd, u32 *out_flags);
+static inline bool hash_directive_to_flags(enum hash_directive_kind hd, u32 *out_flags);
 static struct ast *parse_expr_call(struct context *ctx, struct ast *prev);
 static struct ast *parse_expr_elem(struct context *ctx, struct ast *prev);
 static struct ast *parse_expr_compound(struct context *ctx, struct ast *prev);
@@ -339,7 +343,7 @@ bool parse_unit_docs(struct context *ctx) {
 
 // Try to parse hash directive. List of enabled directives can be set by 'expected_mask',
 // 'satisfied' is optional output set to parsed directive id if there is one.
-struct ast *parse_hash_directive(struct context *ctx, s32 expected_mask, enum hash_directive_flags *satisfied, const bool is_in_expression) {
+struct ast *parse_hash_directive(struct context *ctx, u64 expected_mask, enum hash_directive_kind *satisfied, const bool is_in_expression) {
 	zone();
 #define set_satisfied(_hd) \
 	{ \
@@ -355,7 +359,7 @@ struct ast *parse_hash_directive(struct context *ctx, s32 expected_mask, enum ha
 		struct ast *if_stmt = parse_stmt_if(ctx, true);
 		if (if_stmt) {
 			set_satisfied(HD_STATIC_IF);
-			if (isnotflag(expected_mask, HD_STATIC_IF)) {
+			if (isnotflag(expected_mask, HD_MASK(HD_STATIC_IF))) {
 				builder_msg(MSG_ERR,
 				            0,
 				            if_stmt->location,
@@ -374,26 +378,29 @@ struct ast *parse_hash_directive(struct context *ctx, s32 expected_mask, enum ha
 	const hash_t hash      = strhash(directive);
 	const s64    index     = tbl_lookup_index(ctx->hash_directive_table, hash);
 	if (index == -1) goto INVALID;
-	const enum hash_directive_flags hd_flag = ctx->hash_directive_table[index].value;
+	const enum hash_directive_kind hd = ctx->hash_directive_table[index].value;
 	bassert(directive.len);
 
-	if (isnotflag(expected_mask, hd_flag)) {
+	if (isnotflag(expected_mask, HD_MASK(hd))) {
 		report_error(UNEXPECTED_DIRECTIVE, tok_directive, CARET_WORD, "Unexpected directive.");
 		return_zone(ast_create_node(ctx->ast_arena, AST_BAD, tok_directive, scope_get(ctx)));
 	}
-	set_satisfied(hd_flag);
+	set_satisfied(hd);
 
-	switch (hd_flag) {
+	switch (hd) {
 	case HD_NONE:
 	case HD_STATIC_IF:
 		babort("Invalid directive!");
 	case HD_BUILD_ENTRY:
 		report_warning(tok_directive, CARET_WORD, "Directive is obsolete. Use regular main function as a build entry.");
 	case HD_TEST_FN:
+	case HD_SERIAL:
 	case HD_NO_INIT:
 	case HD_FLAGS:
 	case HD_INLINE:
 	case HD_NO_INLINE:
+	case HD_HOT:
+	case HD_COLD:
 	case HD_THREAD_LOCAL:
 	case HD_ENTRY:
 	case HD_MAYBE_UNUSED:
@@ -528,6 +535,22 @@ struct ast *parse_hash_directive(struct context *ctx, s32 expected_mask, enum ha
 		return_zone(message);
 	}
 
+	case HD_TARGET_CLONES: {
+		// Comma separated list of CPU feature sets function variants are generated for.
+		struct token *tok_clones = tokens_consume_if(ctx->tokens, SYM_STRING);
+		if (!tok_clones) {
+			struct token *tok_err = tokens_peek(ctx->tokens);
+			report_error(INVALID_DIRECTIVE,
+			             tok_err,
+			             CARET_WORD,
+			             "Expected list of CPU features after 'target_clones' directive (e.g. \"avx2+fma,arch=x86-64-v4\").");
+			return_zone(ast_create_node(ctx->ast_arena, AST_BAD, tok_directive, scope_get(ctx)));
+		}
+		struct ast *clones           = ast_create_node(ctx->ast_arena, AST_EXPR_LIT_STRING, tok_clones, scope_get(ctx));
+		clones->data.expr_string.val = get_token_value(ctx, tok_clones).str;
+		return_zone(clones);
+	}
+
 	case HD_INTRINSIC: {
 		// Intrinsic flag extension could be linkage name as string
 		struct token *tok_ext = tokens_consume_if(ctx->tokens, SYM_STRING);
@@ -751,8 +774,8 @@ struct ast *parse_decl_member(struct context *ctx, s32 UNUSED(index)) {
 		id_init(&name->data.ident.id, ident);
 	}
 
-	enum hash_directive_flags found_hd = HD_NONE;
-	struct ast               *tag      = parse_hash_directive(ctx, HD_TAG, &found_hd, false);
+	enum hash_directive_kind found_hd = HD_NONE;
+	struct ast              *tag      = parse_hash_directive(ctx, HD_MASK(HD_TAG), &found_hd, false);
 	struct ast               *mem      = ast_create_node(ctx->ast_arena, AST_DECL_MEMBER, tok_begin, scope_get(ctx));
 
 	consume_docs(ctx, mem);
@@ -788,7 +811,7 @@ struct ast *parse_decl_arg(struct context *ctx, bool named) {
 	//
 	// @Note 2025-03-29: We currently support both :: and := and we should remove := in future since function arguments are immutable.
 	if (tokens_consume_if(ctx->tokens, SYM_ASSIGN) || tokens_consume_if(ctx->tokens, SYM_COLON)) {
-		value = parse_hash_directive(ctx, HD_CALL_LOC, NULL, false);
+		value = parse_hash_directive(ctx, HD_MASK(HD_CALL_LOC), NULL, false);
 		if (!value) value = parse_expr(ctx);
 		if (!value) {
 			struct token *tok_err = tokens_peek(ctx->tokens);
@@ -804,12 +827,12 @@ struct ast *parse_decl_arg(struct context *ctx, bool named) {
 
 	// Parse hash directives.
 	u32 flags    = 0;
-	u32 accepted = HD_COMPTIME | HD_MAYBE_UNUSED;
+	u64 accepted = HD_MASK(HD_COMPTIME) | HD_MASK(HD_MAYBE_UNUSED);
 	while (true) {
-		enum hash_directive_flags found = HD_NONE;
+		enum hash_directive_kind found = HD_NONE;
 		parse_hash_directive(ctx, accepted, &found, false);
 		if (!hash_directive_to_flags(found, &flags)) break;
-		accepted &= ~found;
+		accepted &= ~HD_MASK(found);
 	}
 
 	if (isflag(flags, FLAG_COMPTIME)) {
@@ -871,7 +894,7 @@ bool parse_semicolon_rq(struct context *ctx) {
 	return true;
 }
 
-bool hash_directive_to_flags(enum hash_directive_flags hd, u32 *out_flags) {
+bool hash_directive_to_flags(enum hash_directive_kind hd, u32 *out_flags) {
 #define FLAG_CASE(_c, _f) \
 	case (_c): \
 		(*out_flags) |= (_f); \
@@ -888,12 +911,15 @@ bool hash_directive_to_flags(enum hash_directive_flags hd, u32 *out_flags) {
 		FLAG_CASE(HD_NO_INLINE, FLAG_NO_INLINE);
 		FLAG_CASE(HD_NO_INIT, FLAG_NO_INIT);
 		FLAG_CASE(HD_TEST_FN, FLAG_TEST_FN);
+		FLAG_CASE(HD_SERIAL, FLAG_SERIAL);
 		FLAG_CASE(HD_EXPORT, FLAG_EXPORT);
 		FLAG_CASE(HD_THREAD_LOCAL, FLAG_THREAD_LOCAL);
 		FLAG_CASE(HD_FLAGS, FLAG_FLAGS);
 		FLAG_CASE(HD_COMPTIME, FLAG_COMPTIME);
 		FLAG_CASE(HD_MAYBE_UNUSED, FLAG_MAYBE_UNUSED);
 		FLAG_CASE(HD_OBSOLETE, FLAG_OBSOLETE);
+		FLAG_CASE(HD_HOT, FLAG_HOT);
+		FLAG_CASE(HD_COLD, FLAG_COLD);
 	default:
 		break;
 	}
@@ -978,6 +1004,30 @@ static void check_valid_inline_branch_node(struct ast *node) {
 	            what);
 }
 
+// Optional '#likely' or '#unlikely' hint following the if statement condition. It's valid only in this
+// context, so it's not handled as regular hash directive.
+enum branch_hint parse_branch_hint(struct context *ctx, bool is_static) {
+	if (!tokens_is_seq(ctx->tokens, 2, SYM_HASH, SYM_IDENT)) return BRANCH_HINT_NONE;
+	struct token *tok_hint = tokens_peek_2nd(ctx->tokens);
+	const str_t   name     = get_token_value(ctx, tok_hint).str;
+
+	enum branch_hint hint = BRANCH_HINT_NONE;
+	if (str_match(name, cstr("likely"))) {
+		hint = BRANCH_HINT_LIKELY;
+	} else if (str_match(name, cstr("unlikely"))) {
+		hint = BRANCH_HINT_UNLIKELY;
+	} else {
+		return BRANCH_HINT_NONE;
+	}
+	tokens_consume(ctx->tokens);
+	tokens_consume(ctx->tokens);
+	if (is_static) {
+		report_error(UNEXPECTED_DIRECTIVE, tok_hint, CARET_WORD, "Branch hint cannot be used on static if.");
+		return BRANCH_HINT_NONE;
+	}
+	return hint;
+}
+
 struct ast *parse_stmt_if(struct context *ctx, bool is_static) {
 	zone();
 
@@ -993,6 +1043,7 @@ struct ast *parse_stmt_if(struct context *ctx, bool is_static) {
 	if (!stmt_if->data.stmt_if.test) {
 		report_error(EXPECTED_EXPR, tok_begin, CARET_AFTER, "Expected expression after if statement in format 'if <expr> {...}'.");
 	}
+	stmt_if->data.stmt_if.hint = parse_branch_hint(ctx, is_static);
 
 	struct token *tok_then = tokens_consume_if(ctx->tokens, SYM_THEN);
 	if (!tok_then && is_expression) {
@@ -1407,7 +1458,7 @@ struct ast *parse_expr_primary(struct context *ctx) {
 	if ((expr = parse_expr_nested(ctx))) return expr;
 	if ((expr = parse_expr_ref(ctx))) return expr;
 	if ((expr = parse_expr_null(ctx))) return expr;
-	if ((expr = parse_hash_directive(ctx, HD_FILE | HD_LINE | HD_IMPORT, NULL, true))) return expr;
+	if ((expr = parse_hash_directive(ctx, HD_MASK(HD_FILE) | HD_MASK(HD_LINE) | HD_MASK(HD_IMPORT), NULL, true))) return expr;
 	if ((expr = parse_expr_lit_fn(ctx))) return expr;
 	if ((expr = parse_expr_lit_fn_group(ctx))) return expr;
 	if ((expr = parse_stmt_if(ctx, false))) return expr;
@@ -1589,16 +1640,22 @@ struct ast *parse_expr_lit_fn(struct context *ctx) {
 	// parse flags
 	struct ast *curr_decl = decl_get(ctx);
 	if (curr_decl && curr_decl->kind == AST_DECL_ENTITY) {
-		u32 accepted = HD_EXTERN | HD_NO_INLINE | HD_INLINE | HD_COMPILER | HD_ENTRY |
-		               HD_BUILD_ENTRY | HD_INTRINSIC | HD_TEST_FN | HD_EXPORT | HD_COMPTIME |
-		               HD_MAYBE_UNUSED | HD_OBSOLETE | HD_ENABLE_IF;
-		u32 flags = 0;
+		u64 accepted = HD_MASK(HD_EXTERN) | HD_MASK(HD_NO_INLINE) | HD_MASK(HD_INLINE) | HD_MASK(HD_COMPILER) |
+		               HD_MASK(HD_ENTRY) | HD_MASK(HD_BUILD_ENTRY) | HD_MASK(HD_INTRINSIC) | HD_MASK(HD_TEST_FN) |
+		               HD_MASK(HD_SERIAL) | HD_MASK(HD_EXPORT) | HD_MASK(HD_COMPTIME) | HD_MASK(HD_MAYBE_UNUSED) |
+		               HD_MASK(HD_OBSOLETE) | HD_MASK(HD_ENABLE_IF) | HD_MASK(HD_TARGET_CLONES) | HD_MASK(HD_HOT) |
+		               HD_MASK(HD_COLD);
+		u32           flags      = 0;
+		struct token *tok_serial = NULL;
 		while (true) {
-			enum hash_directive_flags found        = HD_NONE;
-			struct ast               *hd_extension = parse_hash_directive(ctx, accepted, &found, false);
+			enum hash_directive_kind found        = HD_NONE;
+			struct ast              *hd_extension = parse_hash_directive(ctx, accepted, &found, false);
 			if (found == HD_ENABLE_IF) {
 				bassert(hd_extension);
 				fn->data.expr_fn.enable_if = hd_extension;
+			} else if (found == HD_TARGET_CLONES) {
+				bassert(hd_extension);
+				if (hd_extension->kind == AST_EXPR_LIT_STRING) fn->data.expr_fn.target_clones = hd_extension;
 			} else if (hash_directive_to_flags(found, &flags)) {
 				if ((found == HD_EXTERN || found == HD_INTRINSIC || found == HD_EXPORT) && hd_extension) {
 					// Use extern flag extension on function declaration.
@@ -1613,7 +1670,13 @@ struct ast *parse_expr_lit_fn(struct context *ctx) {
 				break;
 			}
 
-			accepted &= ~found;
+			if (found == HD_SERIAL) tok_serial = tokens_peek_prev(ctx->tokens);
+			accepted &= ~HD_MASK(found);
+			// Function cannot be hot and cold at the same time.
+			if (found == HD_HOT || found == HD_COLD) accepted &= ~(HD_MASK(HD_HOT) | HD_MASK(HD_COLD));
+		}
+		if (tok_serial && isnotflag(flags, FLAG_TEST_FN)) {
+			report_error(UNEXPECTED_DIRECTIVE, tok_serial, CARET_WORD, "Directive '#serial' can be used only on test cases marked as '#test'.");
 		}
 		curr_decl->data.decl.flags |= flags;
 	}
@@ -1764,13 +1827,13 @@ struct ast *parse_type_enum(struct context *ctx) {
 
 	// parse flags
 	{
-		u32 accepted = HD_COMPILER | HD_FLAGS | HD_MAYBE_UNUSED;
+		u64 accepted = HD_MASK(HD_COMPILER) | HD_MASK(HD_FLAGS) | HD_MASK(HD_MAYBE_UNUSED);
 		u32 flags    = 0;
 		while (true) {
-			enum hash_directive_flags found = HD_NONE;
+			enum hash_directive_kind found = HD_NONE;
 			parse_hash_directive(ctx, accepted, &found, false);
 			if (!hash_directive_to_flags(found, &flags)) break;
-			accepted &= ~found;
+			accepted &= ~HD_MASK(found);
 		}
 		struct ast *curr_decl = decl_get(ctx);
 		if (curr_decl && curr_decl->kind == AST_DECL_ENTITY) {
@@ -2180,20 +2243,20 @@ struct ast *parse_type_struct(struct context *ctx) {
 	const bool is_union = tok_struct->sym == SYM_UNION;
 
 	// parse flags
-	u32         accepted       = is_union ? HD_BASE | HD_MAYBE_UNUSED : HD_COMPILER | HD_BASE | HD_MAYBE_UNUSED;
+	u64         accepted       = HD_MASK(HD_BASE) | HD_MASK(HD_MAYBE_UNUSED) | (is_union ? 0 : HD_MASK(HD_COMPILER));
 	u32         flags          = 0;
 	struct ast *base_type_expr = NULL;
 	while (true) {
-		struct ast               *hd_extension;
-		enum hash_directive_flags found = HD_NONE;
-		hd_extension                    = parse_hash_directive(ctx, accepted, &found, false);
+		struct ast              *hd_extension;
+		enum hash_directive_kind found = HD_NONE;
+		hd_extension                   = parse_hash_directive(ctx, accepted, &found, false);
 		if (found == HD_BASE) {
 			bassert(hd_extension);
 			base_type_expr = hd_extension;
 		} else if (!hash_directive_to_flags(found, &flags)) {
 			break;
 		}
-		accepted &= ~found;
+		accepted &= ~HD_MASK(found);
 	}
 
 	struct ast *curr_decl = decl_get(ctx);
@@ -2285,7 +2348,7 @@ struct ast *parse_decl(struct context *ctx) {
 	if (!tok_assign) tok_assign = tokens_consume_if(ctx->tokens, SYM_COLON);
 
 	// Parse hash directives.
-	s32 hd_accepted = HD_COMPILER | HD_THREAD_LOCAL | HD_MAYBE_UNUSED;
+	u64 hd_accepted = HD_MASK(HD_COMPILER) | HD_MASK(HD_THREAD_LOCAL) | HD_MASK(HD_MAYBE_UNUSED);
 
 	if (tok_assign) {
 		decl->data.decl_entity.mut = token_is(tok_assign, SYM_ASSIGN);
@@ -2325,7 +2388,7 @@ struct ast *parse_decl(struct context *ctx) {
 		}
 
 	} else {
-		hd_accepted |= HD_NO_INIT;
+		hd_accepted |= HD_MASK(HD_NO_INIT);
 	}
 
 	struct ast *init_value = decl->data.decl_entity.value;
@@ -2333,10 +2396,10 @@ struct ast *parse_decl(struct context *ctx) {
 	if (!init_value || rq_semicolon_after_decl_entity(init_value)) {
 		u32 flags = 0;
 		while (true) {
-			enum hash_directive_flags found = HD_NONE;
+			enum hash_directive_kind found = HD_NONE;
 			parse_hash_directive(ctx, hd_accepted, &found, false);
 			if (!hash_directive_to_flags(found, &flags)) break;
-			hd_accepted &= ~found;
+			hd_accepted &= ~HD_MASK(found);
 		}
 
 		if (isflag(flags, FLAG_NO_INIT) && !scope_is_local(scope_get(ctx))) {
@@ -2509,7 +2572,7 @@ NEXT:
 		goto NEXT;
 	}
 
-	if ((tmp = parse_hash_directive(ctx, HD_STATIC_IF, NULL, false))) {
+	if ((tmp = parse_hash_directive(ctx, HD_MASK(HD_STATIC_IF), NULL, false))) {
 		REQUIRE_SEMICOLON(false);
 		return tmp;
 	}
@@ -2658,7 +2721,8 @@ NEXT:
 	}
 
 	// load, import, link, test, private - enabled in global scope
-	const int enabled_hd = HD_LOAD | HD_PRIVATE | HD_IMPORT | HD_SCOPE_PRIVATE | HD_SCOPE_PUBLIC | HD_SCOPE_MODULE;
+	const u64 enabled_hd = HD_MASK(HD_LOAD) | HD_MASK(HD_PRIVATE) | HD_MASK(HD_IMPORT) | HD_MASK(HD_SCOPE_PRIVATE) |
+	                       HD_MASK(HD_SCOPE_PUBLIC) | HD_MASK(HD_SCOPE_MODULE);
 	if ((tmp = parse_hash_directive(ctx, enabled_hd, NULL, false))) {
 		arrput(ublock->data.ublock.nodes, tmp);
 		goto NEXT;
@@ -2679,13 +2743,13 @@ NEXT:
 
 void init_hash_directives(struct context *ctx) {
 	static const char *hash_directive_names[] = {
-#define HD_GEN(kind, name, flag) name,
+#define HD_GEN(kind, name, bit) name,
 #include "parser.def"
 #undef HD_GEN
 	};
 
-	static s32 hash_directive_flags[static_arrlenu(hash_directive_names)] = {
-#define HD_GEN(kind, name, flag) flag,
+	static enum hash_directive_kind hash_directive_kinds[static_arrlenu(hash_directive_names)] = {
+#define HD_GEN(kind, name, bit) kind,
 #include "parser.def"
 #undef HD_GEN
 	};
@@ -2694,7 +2758,7 @@ void init_hash_directives(struct context *ctx) {
 		const hash_t                hash  = strhash(make_str_from_c(hash_directive_names[i]));
 		struct hash_directive_entry entry = (struct hash_directive_entry){
 		    .hash  = hash,
-		    .value = hash_directive_flags[i],
+		    .value = hash_directive_kinds[i],
 		};
 		tbl_insert(ctx->hash_directive_table, entry);
 	}
@@ -0,0 +1,216 @@
+// =================================================================================================
+// Minimal profile runtime linked into binaries instrumented by '--pgo=generate' on Linux.
+//
+// Counters emitted by the LLVM IR instrumentation are written as a raw profile readable by
+// 'llvm-profdata' when '__llvm_profile_write_file' is called by the BL runtime at exit (see
+// '__os_start'); the same function is provided by 'clang_rt.profile' on other platforms. Layout of all records is taken from the 'InstrProfData.inc' of the LLVM the
+// compiler is built with (see nob), so the raw profile version always matches the instrumentation.
+//
+// Only edge counters are collected; value profiling hooks are no-ops and value sites are written
+// empty.
+// =================================================================================================
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef void *IntPtrT;
+
+// Constants (magic, version, section names) and common types.
+#include "llvm/ProfileData/InstrProfData.inc"
+
+enum value_kind {
+#define VALUE_PROF_KIND(Enumerator, Value, Descr) Enumerator = Value,
+#include "llvm/ProfileData/InstrProfData.inc"
+};
+
+#define INSTR_PROF_VALUE_PROF_DATA
+#define INSTR_PROF_COMMON_API_IMPL
+#undef INSTR_PROF_VISIBILITY
+#define INSTR_PROF_VISIBILITY static
+#include "llvm/ProfileData/InstrProfData.inc"
+
+struct blprof_data {
+#define INSTR_PROF_DATA(Type, LLVMType, Name, Initializer) Type Name;
+#include "llvm/ProfileData/InstrProfData.inc"
+};
+
+struct blprof_header {
+#define INSTR_PROF_RAW_HEADER(Type, Name, Initializer) Type Name;
+#include "llvm/ProfileData/InstrProfData.inc"
+};
+
+#define SECTION_START(name) __start_##name
+#define SECTION_STOP(name)  __stop_##name
+#define SECTION_BOUNDS(name, type)                                                    \
+	extern type SECTION_START(name)[] __attribute__((visibility("hidden"), weak)); \
+	extern type SECTION_STOP(name)[] __attribute__((visibility("hidden"), weak))
+
+// Section bounds are provided by the linker for all sections with C identifier names.
+SECTION_BOUNDS(__llvm_prf_data, struct blprof_data);
+SECTION_BOUNDS(__llvm_prf_cnts, char);
+SECTION_BOUNDS(__llvm_prf_names, char);
+#ifdef INSTR_PROF_BITS_COMMON
+SECTION_BOUNDS(__llvm_prf_bits, char);
+#endif
+
+// Emitted into the instrumented module.
+extern const uint64_t INSTR_PROF_RAW_VERSION_VAR __attribute__((weak));
+extern const char     INSTR_PROF_PROFILE_NAME_VAR[] __attribute__((weak));
+
+// Referenced by the instrumentation to pull the runtime in.
+int INSTR_PROF_PROFILE_RUNTIME_VAR;
+
+void __llvm_profile_instrument_target(uint64_t value, void *data, uint32_t index) {
+	(void)value, (void)data, (void)index;
+}
+
+void __llvm_profile_instrument_memop(uint64_t value, void *data, uint32_t index) {
+	(void)value, (void)data, (void)index;
+}
+
+// Used by initializers of the raw header fields.
+static uint64_t __llvm_profile_get_magic(void) {
+	return sizeof(void *) == sizeof(uint64_t) ? (INSTR_PROF_RAW_MAGIC_64) : (INSTR_PROF_RAW_MAGIC_32);
+}
+
+static uint64_t __llvm_profile_get_version(void) {
+	return &INSTR_PROF_RAW_VERSION_VAR ? INSTR_PROF_RAW_VERSION_VAR : INSTR_PROF_RAW_VERSION;
+}
+
+static uint64_t __llvm_write_binary_ids(void *writer) {
+	(void)writer;
+	return 0;
+}
+
+static uint64_t padding8(uint64_t size) {
+	return (8 - (size % 8)) % 8;
+}
+
+static void write_padding(FILE *stream, uint64_t size) {
+	static const char zeros[8] = {0};
+	fwrite(zeros, 1, size, stream);
+}
+
+// Closure used to write value profile records with all sites empty.
+static uint32_t vp_num_value_kinds(const void *record) {
+	const struct blprof_data *data = record;
+	uint32_t                  n    = 0;
+	for (uint32_t kind = IPVK_First; kind <= IPVK_Last; ++kind) n += data->NumValueSites[kind] != 0;
+	return n;
+}
+
+static uint32_t vp_num_value_sites(const void *record, uint32_t kind) {
+	return ((const struct blprof_data *)record)->NumValueSites[kind];
+}
+
+static uint32_t vp_num_value_data(const void *record, uint32_t kind) {
+	(void)record, (void)kind;
+	return 0;
+}
+
+static uint32_t vp_num_value_data_for_site(const void *record, uint32_t kind, uint32_t site) {
+	(void)record, (void)kind, (void)site;
+	return 0;
+}
+
+static void vp_value_for_site(const void *record, InstrProfValueData *dest, uint32_t kind, uint32_t site) {
+	(void)record, (void)dest, (void)kind, (void)site;
+}
+
+static ValueProfData *vp_alloc(size_t size) {
+	return calloc(1, size);
+}
+
+static void get_filepath(char *buf, size_t buf_size) {
+	const char *filepath = getenv("LLVM_PROFILE_FILE");
+	if (!filepath || !filepath[0]) filepath = INSTR_PROF_PROFILE_NAME_VAR ? INSTR_PROF_PROFILE_NAME_VAR : "";
+	if (!filepath[0]) filepath = "default.profraw";
+
+	// Only '%p' (process id) pattern is supported.
+	size_t len = 0;
+	for (const char *c = filepath; *c && len + 1 < buf_size; ++c) {
+		if (c[0] == '%' && c[1] == 'p') {
+			len += snprintf(buf + len, buf_size - len, "%d", (int)getpid());
+			if (len >= buf_size) len = buf_size - 1;
+			++c;
+			continue;
+		}
+		buf[len++] = *c;
+	}
+	buf[len] = '\0';
+}
+
+int __llvm_profile_write_file(void) {
+	const struct blprof_data *DataBegin     = SECTION_START(__llvm_prf_data);
+	const struct blprof_data *DataEnd       = SECTION_STOP(__llvm_prf_data);
+	const char               *CountersBegin = SECTION_START(__llvm_prf_cnts);
+	const char               *CountersEnd   = SECTION_STOP(__llvm_prf_cnts);
+	const char               *NamesBegin    = SECTION_START(__llvm_prf_names);
+	const char               *NamesEnd      = SECTION_STOP(__llvm_prf_names);
+#ifdef INSTR_PROF_BITS_COMMON
+	const char *BitmapBegin = SECTION_START(__llvm_prf_bits);
+	const char *BitmapEnd   = SECTION_STOP(__llvm_prf_bits);
+#else
+	const char *BitmapBegin = NULL;
+	const char *BitmapEnd   = NULL;
+#endif
+	if (!DataBegin || DataBegin == DataEnd) return 0;
+
+	// Names of the header fields initializers differ between LLVM versions.
+	const uint64_t NumData                      = DataEnd - DataBegin;
+	const uint64_t NumCounters                  = (CountersEnd - CountersBegin) / sizeof(uint64_t);
+	const uint64_t NumBitmapBytes               = BitmapEnd - BitmapBegin;
+	const uint64_t NamesSize                    = NamesEnd - NamesBegin;
+	const uint64_t DataSize                     = NumData;
+	const uint64_t CountersSize                 = NumCounters;
+	const uint64_t PaddingBytesBeforeCounters   = padding8(NumData * sizeof(struct blprof_data));
+	const uint64_t PaddingBytesAfterCounters    = padding8(CountersEnd - CountersBegin);
+	const uint64_t PaddingBytesAfterBitmapBytes = padding8(NumBitmapBytes);
+	(void)DataSize, (void)CountersSize, (void)NumBitmapBytes, (void)PaddingBytesAfterBitmapBytes;
+
+	struct blprof_header header;
+#define INSTR_PROF_RAW_HEADER(Type, Name, Initializer) header.Name = (Type)(Initializer);
+#include "llvm/ProfileData/InstrProfData.inc"
+
+	char filepath[4096];
+	get_filepath(filepath, sizeof(filepath));
+	FILE *stream = fopen(filepath, "wb");
+	if (!stream) {
+		fprintf(stderr, "Cannot write profile file '%s'.\n", filepath);
+		return -1;
+	}
+
+	fwrite(&header, sizeof(header), 1, stream);
+	fwrite(DataBegin, sizeof(struct blprof_data), NumData, stream);
+	write_padding(stream, PaddingBytesBeforeCounters);
+	fwrite(CountersBegin, 1, CountersEnd - CountersBegin, stream);
+	write_padding(stream, PaddingBytesAfterCounters);
+	if (NumBitmapBytes) {
+		fwrite(BitmapBegin, 1, NumBitmapBytes, stream);
+		write_padding(stream, PaddingBytesAfterBitmapBytes);
+	}
+	fwrite(NamesBegin, 1, NamesSize, stream);
+	write_padding(stream, padding8(NamesSize));
+
+	// Value profile data are expected for every function having some value sites.
+	for (const struct blprof_data *data = DataBegin; data != DataEnd; ++data) {
+		if (!vp_num_value_kinds(data)) continue;
+		ValueProfRecordClosure closure = {
+		    .Record                 = data,
+		    .GetNumValueKinds       = vp_num_value_kinds,
+		    .GetNumValueSites       = vp_num_value_sites,
+		    .GetNumValueData        = vp_num_value_data,
+		    .GetNumValueDataForSite = vp_num_value_data_for_site,
+		    .GetValueForSite        = vp_value_for_site,
+		    .AllocValueProfData     = vp_alloc,
+		};
+		ValueProfData *vp = serializeValueProfDataFrom(&closure, NULL);
+		fwrite(vp, 1, vp->TotalSize, stream);
+		free(vp);
+	}
+	fclose(stream);
+	return 0;
+}
@@ -199,12 +199,17 @@ bool x86_64_pc_linux_gnu(struct context *ctx) {
 
 	ctx->preload_file = cstr("os/_linux.bl");
 
+#if BL_LLD_ENABLE
+	// LLD is linked into the compiler, keep the linker executable empty to link in-process.
+	ctx->linker_executable = str_empty;
+#else
 	str_buf_t ldpath = execute("which ld");
 	if (ldpath.len == 0) {
 		builder_error("The 'ld' linker not found on the system!");
 	}
 	ctx->linker_executable = scdup2(&ctx->cache, ldpath);
 	put_tmp_str(ldpath);
+#endif
 
 	str_buf_t runtime = get_tmp_str();
 	str_buf_append_fmt(&runtime, "{str}/../{str}", builder_get_exec_dir(), RUNTIME_PATH);
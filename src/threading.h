@@ -9,6 +9,7 @@ extern thrd_t MAIN_THREAD;
 
 struct context;
 struct mir_instr;
+struct vm_test_case;
 
 struct job_context {
 	union {
@@ -21,6 +22,17 @@ struct job_context {
 			struct context   *ctx;
 			struct mir_instr *top_instr;
 		} x64;
+
+		struct {
+			struct context *ctx;
+			usize           first_unit;
+			usize           unit_num;
+		} x64_merge;
+
+		struct {
+			struct assembly     *assembly;
+			struct vm_test_case *test_case;
+		} test;
 	};
 };
 
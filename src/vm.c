@@ -175,6 +175,7 @@ static inline void push_ra(struct virtual_machine *vm, struct mir_instr_call *ca
 	struct vm_frame *tmp = (struct vm_frame *)stack_alloc(vm, sizeof(struct vm_frame));
 	tmp->caller          = caller;
 	tmp->prev            = vm->stack->ra;
+	tmp->profile_vm      = NULL;
 	vm->stack->ra        = tmp;
 	vmdbg_notify_stack_op(VMDBG_PUSH_RA, NULL, tmp);
 }
@@ -190,6 +191,46 @@ static inline struct mir_instr_call *pop_ra(struct virtual_machine *vm) {
 	return caller;
 }
 
+// Find or create child node of the parent node for the function call.
+static s32 profile_get_node(array(struct vm_profile_node) * profile, s32 parent, struct mir_fn *fn) {
+	if (!arrlen(*profile)) {
+		// Root node.
+		arrput(*profile, ((struct vm_profile_node){.parent = -1, .first_child = -1, .next_sibling = -1}));
+	}
+	bassert(parent >= 0 && parent < arrlen(*profile));
+
+	s32 *link = &(*profile)[parent].first_child;
+	while (*link != -1) {
+		if ((*profile)[*link].fn == fn) return *link;
+		link = &(*profile)[*link].next_sibling;
+	}
+
+	// Link must be set before push, the pointer may become invalid after reallocation.
+	const s32 index = (s32)arrlen(*profile);
+	*link           = index;
+	arrput(*profile, ((struct vm_profile_node){.fn = fn, .parent = parent, .first_child = -1, .next_sibling = -1}));
+	return index;
+}
+
+// Resolve profile node of the frame in the profile of current VM. The caller frame (if any) has
+// already executed the call instruction, so it has the function resolved.
+static s32 profile_resolve_node(struct virtual_machine *vm, struct vm_frame *frame) {
+	if (frame->profile_vm == vm) return frame->profile_node;
+	const s32 parent    = frame->prev && frame->prev->profile_vm ? profile_resolve_node(vm, frame->prev) : 0;
+	frame->profile_node = profile_get_node(&vm->profile, parent, frame->profile_fn);
+	frame->profile_vm   = vm;
+	return frame->profile_node;
+}
+
+static void profile_instr(struct virtual_machine *vm, struct mir_instr *instr) {
+	struct vm_frame *frame = vm->stack->ra;
+	if (!frame) return;
+	if (!frame->profile_vm) frame->profile_fn = instr->owner_block->owner_fn;
+	const s32 node = profile_resolve_node(vm, frame);
+	bassert(node < arrlen(vm->profile));
+	++vm->profile[node].count;
+}
+
 static inline vm_stack_ptr_t stack_push_empty(struct virtual_machine *vm, struct mir_type *type) {
 	bassert(type);
 	const usize size = type->store_size_bytes;
@@ -251,11 +292,13 @@ static struct vm_bufpage *data_page_alloc(struct vm_bufpage *prev, usize size_ne
 static vm_stack_ptr_t data_alloc(struct virtual_machine *vm, struct mir_type *type) {
 	zone();
 	bassert(type->store_size_bytes > 0);
-	const usize size_needed = type->store_size_bytes + (usize)type->alignment;
-	const usize alignment   = (usize)type->alignment;
-	if (!vm->data) vm->data = data_page_alloc(NULL, size_needed);
+	const usize        size_needed = type->store_size_bytes + (usize)type->alignment;
+	const usize        alignment   = (usize)type->alignment;
+	struct vm_globals *globals     = vm->globals;
+	mtx_lock(&globals->lock);
+	if (!globals->data) globals->data = data_page_alloc(NULL, size_needed);
 	// lookup free space, if no suitable was found, allocate new block!
-	struct vm_bufpage *found = vm->data;
+	struct vm_bufpage *found = globals->data;
 	while (found) {
 		if (found->len + size_needed <= found->cap) {
 			break;
@@ -263,24 +306,48 @@ static vm_stack_ptr_t data_alloc(struct virtual_machine *vm, struct mir_type *ty
 		found = found->prev;
 	}
 	if (!found) {
-		vm->data = data_page_alloc(vm->data, size_needed);
-		found    = vm->data;
+		globals->data = data_page_alloc(globals->data, size_needed);
+		found         = globals->data;
 	}
 	bassert(found);
 	vm_stack_ptr_t ptr = next_aligned(found->top + found->len, alignment);
 	bassert(is_aligned(ptr, alignment) && "Invalid allocation alignment!");
 	found->len += size_needed;
+	mtx_unlock(&globals->lock);
 	return_zone(ptr);
 }
 
-static void data_free(struct virtual_machine *vm) {
-	struct vm_bufpage *current = vm->data;
+static void data_free(struct vm_globals *globals) {
+	struct vm_bufpage *current = globals->data;
 	while (current) {
 		struct vm_bufpage *tmp = current;
 		current                = current->prev;
 		bfree(tmp);
 	}
-	vm->data = NULL;
+	globals->data = NULL;
+}
+
+// Main execution stack is used only by some workers (i.e. the one executing tests or entry
+// function), so we allocate it on demand.
+static inline void ensure_main_stack(struct virtual_machine *vm) {
+	if (vm->main_stack) return;
+	vm->main_stack = create_stack(VM_STACK_SIZE);
+	swap_current_stack(vm, vm->main_stack);
+}
+
+// Builtin variables 'is_comptime_run' and 'is_comptime' are shared by all workers; the variable
+// is set on the first nested entry and cleared when the last running execution leaves.
+static inline void comptime_flag_enter(struct virtual_machine *vm, struct mir_var *var, s32 *depth) {
+	mtx_lock(&vm->globals->lock);
+	if ((*depth)++ == 0) vm_override_var(vm, var, true);
+	mtx_unlock(&vm->globals->lock);
+}
+
+static inline void comptime_flag_leave(struct virtual_machine *vm, struct mir_var *var, s32 *depth) {
+	mtx_lock(&vm->globals->lock);
+	bassert(*depth > 0);
+	if (--(*depth) == 0) vm_override_var(vm, var, false);
+	mtx_unlock(&vm->globals->lock);
 }
 
 // Fetch value; use internal ConstExprValue storage if value is compile time known, otherwise use
@@ -329,6 +396,18 @@ static inline void stack_alloc_local_vars(struct virtual_machine *vm, struct mir
 	}
 }
 
+// Checks whether the integer divisor (or any lane of integer SIMD vector) is zero.
+static bool is_zero_divisor(struct mir_type *type, vm_stack_ptr_t v) {
+	if (mir_is_vector_type(type)) {
+		for (u32 i = 0; i < (u32)type->data.array.len; ++i) {
+			if (is_zero_divisor(type->data.array.elem_type, v + vm_get_array_elem_offset(type, i))) return true;
+		}
+		return false;
+	}
+	if (type->kind == MIR_TYPE_REAL) return false;
+	return vm_read_int(type, v) == 0;
+}
+
 //********/
 //* impl */
 //********/
@@ -401,7 +480,26 @@ void calculate_binop(struct mir_type *src_type,
 		vm_write_as(T, dest, vm_read_as(T, lhs) << vm_read_as(T, rhs)); \
 		break;
 
-	// Valid types: integers, floats, doubles, enums (as ints), bool, pointers.
+	// Valid types: integers, floats, doubles, enums (as ints), bool, pointers and SIMD vectors of
+	// integers or reals.
+
+	if (mir_is_vector_type(src_type)) {
+		struct mir_type *lane_type     = src_type->data.array.elem_type;
+		const usize      lane_size     = lane_type->store_size_bytes;
+		const bool       is_comparison = ast_binop_is_logic(op);
+		for (u32 i = 0; i < (u32)src_type->data.array.len; ++i) {
+			const ptrdiff_t offset = vm_get_array_elem_offset(src_type, i);
+			if (is_comparison) {
+				// Result lane has the same size as the source lane and all bits set for true.
+				bool lane_result = false;
+				calculate_binop(lane_type, (vm_stack_ptr_t)&lane_result, lhs + offset, rhs + offset, op);
+				memset(dest + offset, lane_result ? 0xFF : 0, lane_size);
+			} else {
+				calculate_binop(lane_type, dest + offset, lhs + offset, rhs + offset, op);
+			}
+		}
+		return;
+	}
 
 	const usize size    = src_type->store_size_bytes;
 	const bool  is_real = src_type->kind == MIR_TYPE_REAL;
@@ -565,6 +663,15 @@ void calculate_unop(vm_stack_ptr_t dest, vm_stack_ptr_t v, enum unop_kind op, st
 		} \
 	} break
 
+	if (mir_is_vector_type(type)) {
+		struct mir_type *lane_type = type->data.array.elem_type;
+		for (u32 i = 0; i < (u32)type->data.array.len; ++i) {
+			const ptrdiff_t offset = vm_get_array_elem_offset(type, i);
+			calculate_unop(dest + offset, v + offset, op, lane_type);
+		}
+		return;
+	}
+
 	const usize s = type->store_size_bytes;
 
 	switch (type->kind) {
@@ -728,13 +835,14 @@ void dyncall_cb_read_arg(struct virtual_machine       UNUSED(*vm),
 }
 
 char dyncall_cb_handler(DCCallback UNUSED(*cb), DCArgs *dc_args, DCValue *result, void *userdata) {
-	// TODO: External callback can be invoked from different thread. This can cause problems for
-	//  now since interpreter is strictly single-threaded, but we must handle such situation in
-	//  future.
+	// Callback is executed by the virtual machine of the current worker thread, so the same
+	// callback can be invoked from multiple workers at once.
+	// TODO: External callback invoked from thread not owned by the compiler shares the virtual
+	//  machine of the main thread; we must handle such situation in future.
 	struct dyncall_cb_context *ctx = (struct dyncall_cb_context *)userdata;
 	struct mir_fn             *fn  = ctx->fn;
-	struct virtual_machine    *vm  = ctx->vm;
-	bassert(fn && vm);
+	bassert(fn && ctx->assembly);
+	struct virtual_machine *vm = assembly_get_vm(ctx->assembly);
 
 	struct mir_type *ret_type = fn->type->data.fn.ret_type;
 	const bool       is_extern =
@@ -867,17 +975,21 @@ const char *dyncall_generate_signature(struct virtual_machine *vm, struct mir_ty
 
 DCCallback *dyncall_fetch_callback(struct virtual_machine *vm, struct mir_fn *fn) {
 	if (fn->dyncall.extern_callback_handle) return fn->dyncall.extern_callback_handle;
-	const char *sig     = dyncall_generate_signature(vm, fn->type);
-	fn->dyncall.context = (struct dyncall_cb_context){.fn = fn, .vm = vm};
-	fn->dyncall.extern_callback_handle =
-	    dcbNewCallback(sig, &dyncall_cb_handler, &fn->dyncall.context);
+	mtx_lock(&vm->globals->lock);
+	if (!fn->dyncall.extern_callback_handle) {
+		const char *sig     = dyncall_generate_signature(vm, fn->type);
+		fn->dyncall.context = (struct dyncall_cb_context){.fn = fn, .assembly = vm->assembly};
+		fn->dyncall.extern_callback_handle =
+		    dcbNewCallback(sig, &dyncall_cb_handler, &fn->dyncall.context);
+	}
+	mtx_unlock(&vm->globals->lock);
 	return fn->dyncall.extern_callback_handle;
 }
 
 void dyncall_push_arg(struct virtual_machine *vm, vm_stack_ptr_t val_ptr, struct mir_type *type) {
 	bassert(type);
 
-	DCCallVM *dvm = vm->assembly->dc_vm;
+	DCCallVM *dvm = vm->dc_vm;
 	bassert(dvm);
 
 	if (type->kind == MIR_TYPE_ENUM) {
@@ -972,7 +1084,7 @@ void interp_extern_call(struct virtual_machine *vm, struct mir_instr_call *call,
 	struct mir_type *ret_type = fn_type->data.fn.ret_type;
 	bassert(ret_type);
 
-	DCCallVM *dvm = vm->assembly->dc_vm;
+	DCCallVM *dvm = vm->dc_vm;
 	bassert(vm);
 
 	// call setup and clenup
@@ -1085,7 +1197,7 @@ enum vm_interp_state execute_function(struct virtual_machine *vm,
 	// Reset eventual previous failed state.
 	vm->aborted = false;
 
-	const u64 prev_is_comptime_run = vm_override_var(vm, vm->assembly->is_comptime_run, true);
+	comptime_flag_enter(vm, vm->assembly->is_comptime_run, &vm->globals->comptime_run_depth);
 	if (!resume) {
 		struct mir_instr *fn_entry_instr = fn->entry_block->entry_instr;
 		// push terminal frame on stack
@@ -1126,7 +1238,7 @@ enum vm_interp_state execute_function(struct virtual_machine *vm,
 		break;
 	}
 
-	vm_override_var(vm, vm->assembly->is_comptime_run, prev_is_comptime_run);
+	comptime_flag_leave(vm, vm->assembly->is_comptime_run, &vm->globals->comptime_run_depth);
 	return state;
 }
 
@@ -1140,6 +1252,7 @@ enum vm_interp_state interp_instr(struct virtual_machine *vm, struct mir_instr *
 	// Skip all comptimes.
 	enum vm_interp_state state = VM_INTERP_PASSED;
 	if (mir_is_comptime(instr)) return state;
+	if (vm->assembly->target->vm_profile) profile_instr(vm, instr);
 
 	const enum mir_instr_kind kind = instr->kind;
 
@@ -1905,20 +2018,19 @@ void interp_instr_binop(struct virtual_machine *vm, struct mir_instr_binop *bino
 	struct mir_type *dest_type = binop->base.value.type;
 	struct mir_type *src_type  = binop->lhs->value.type;
 
-	if (binop->op == BINOP_DIV && src_type->kind != MIR_TYPE_REAL) {
-		const u64 n = vm_read_int(src_type, rhs_ptr);
-		if (n == 0) {
-			builder_msg(MSG_ERR,
-			            ERR_DIV_BY_ZERO,
-			            binop->rhs->node->location,
-			            CARET_WORD,
-			            "Division by zero.");
-			eval_abort(vm);
-			return;
-		}
+	if (binop->op == BINOP_DIV && is_zero_divisor(src_type, rhs_ptr)) {
+		builder_msg(MSG_ERR,
+		            ERR_DIV_BY_ZERO,
+		            binop->rhs->node->location,
+		            CARET_WORD,
+		            "Division by zero.");
+		eval_abort(vm);
+		return;
 	}
 
-	vm_value_t tmp = {0};
+	// Big enough to hold also SIMD vector values; typed values are written into it directly.
+	_Alignas(max_align_t) u8 tmp[MIR_VECTOR_MAX_SIZE] = {0};
+	bassert(dest_type->store_size_bytes <= sizeof(tmp));
 	calculate_binop(src_type, (vm_stack_ptr_t)&tmp, lhs_ptr, rhs_ptr, binop->op);
 
 	stack_push(vm, &tmp, dest_type);
@@ -1928,7 +2040,9 @@ void interp_instr_unop(struct virtual_machine *vm, struct mir_instr_unop *unop)
 	struct mir_type *type  = unop->base.value.type;
 	vm_stack_ptr_t   v_ptr = fetch_value(vm, &unop->expr->value);
 
-	vm_value_t tmp = {0};
+	// Big enough to hold also SIMD vector values; typed values are written into it directly.
+	_Alignas(max_align_t) u8 tmp[MIR_VECTOR_MAX_SIZE] = {0};
+	bassert(type->store_size_bytes <= sizeof(tmp));
 	calculate_unop((vm_stack_ptr_t)&tmp, v_ptr, unop->op, type);
 
 	stack_push(vm, &tmp, type);
@@ -2361,17 +2475,14 @@ void eval_instr_binop(struct virtual_machine UNUSED(*vm), struct mir_instr_binop
 
 	struct mir_type *src_type = binop->lhs->value.type;
 
-	if (binop->op == BINOP_DIV && src_type->kind != MIR_TYPE_REAL) {
-		const u64 n = vm_read_int(src_type, rhs_ptr);
-		if (n == 0) {
-			builder_msg(MSG_ERR,
-			            ERR_DIV_BY_ZERO,
-			            binop->rhs->node->location,
-			            CARET_WORD,
-			            "Division by zero.");
-			eval_abort(vm);
-			return;
-		}
+	if (binop->op == BINOP_DIV && is_zero_divisor(src_type, rhs_ptr)) {
+		builder_msg(MSG_ERR,
+		            ERR_DIV_BY_ZERO,
+		            binop->rhs->node->location,
+		            CARET_WORD,
+		            "Division by zero.");
+		eval_abort(vm);
+		return;
 	}
 
 	calculate_binop(src_type, dest_ptr, lhs_ptr, rhs_ptr, binop->op);
@@ -2427,38 +2538,48 @@ void eval_instr_decl_direct_ref(struct virtual_machine            UNUSED(*vm),
 // =================================================================================================
 // Public
 // =================================================================================================
-void vm_init(struct virtual_machine *vm, usize stack_size) {
-	vm->main_stack = create_stack(stack_size);
-	swap_current_stack(vm, vm->main_stack);
-	mtx_init(&vm->lock, mtx_recursive); // recursive here, we might nest some locking calls...
+void vm_globals_init(struct vm_globals *globals) {
+	mtx_init(&globals->lock, mtx_recursive); // recursive here, we might nest some locking calls...
 }
 
-void vm_terminate(struct virtual_machine *vm) {
-	data_free(vm);
-	mtx_destroy(&vm->lock);
-	arrfree(vm->dcsigtmp);
-	for (u64 i = 0; i < arrlenu(vm->available_comptime_call_stacks); ++i) {
-		terminate_stack(vm->available_comptime_call_stacks[i]);
+void vm_globals_terminate(struct vm_globals *globals) {
+	data_free(globals);
+	for (u64 i = 0; i < arrlenu(globals->available_comptime_call_stacks); ++i) {
+		terminate_stack(globals->available_comptime_call_stacks[i]);
 	}
-	arrfree(vm->available_comptime_call_stacks);
-	for (u32 i = 0; i < tbl_len(vm->comptime_call_stacks); ++i) {
-		terminate_stack(vm->comptime_call_stacks[i].stack);
+	arrfree(globals->available_comptime_call_stacks);
+	for (u32 i = 0; i < tbl_len(globals->comptime_call_stacks); ++i) {
+		terminate_stack(globals->comptime_call_stacks[i].stack);
 	}
-	tbl_free(vm->comptime_call_stacks);
-	terminate_stack(vm->main_stack);
+	tbl_free(globals->comptime_call_stacks);
+	mtx_destroy(&globals->lock);
 }
 
-void vm_print_backtrace(struct virtual_machine *vm) {
-	mtx_lock(&vm->lock);
+void vm_init(struct virtual_machine *vm, struct assembly *assembly, struct vm_globals *globals) {
+	bassert(assembly && globals);
+	vm->assembly = assembly;
+	vm->globals  = globals;
+	vm->dc_vm    = dcNewCallVM(4096);
+	dcMode(vm->dc_vm, DC_CALL_C_DEFAULT);
+}
 
+void vm_terminate(struct virtual_machine *vm) {
+	arrfree(vm->dcsigtmp);
+	arrfree(vm->profile);
+	if (vm->dc_vm) dcFree(vm->dc_vm);
+	if (vm->main_stack) terminate_stack(vm->main_stack);
+	vm->dc_vm      = NULL;
+	vm->main_stack = NULL;
+	vm->stack      = NULL;
+}
+
+void vm_print_backtrace(struct virtual_machine *vm) {
 	builder_note("\nBacktrace:");
+	if (!vm->stack) return;
 	struct mir_instr *instr = vm->stack->pc;
 	struct vm_frame  *fr    = vm->stack->ra;
 	usize             n     = 0;
-	if (!instr) {
-		mtx_unlock(&vm->lock);
-		return;
-	}
+	if (!instr) return;
 
 	// Print the last instruction
 	builder_msg(MSG_ERR_NOTE, 0, instr->node->location, CARET_NONE, "Last called:");
@@ -2484,30 +2605,73 @@ void vm_print_backtrace(struct virtual_machine *vm) {
 		}
 		++n;
 	}
-	mtx_unlock(&vm->lock);
+}
+
+static void profile_merge(array(struct vm_profile_node) * dest, s32 dest_parent, struct vm_profile_node *src, s32 src_parent) {
+	for (s32 i = src[src_parent].first_child; i != -1; i = src[i].next_sibling) {
+		const s32 dest_index = profile_get_node(dest, dest_parent, src[i].fn);
+		(*dest)[dest_index].count += src[i].count;
+		profile_merge(dest, dest_index, src, i);
+	}
+}
+
+static void profile_write_node(str_buf_t *out, struct vm_profile_node *profile, s32 index, str_buf_t *path) {
+	struct vm_profile_node *node     = &profile[index];
+	const s32               path_len = path->len;
+	if (index) {
+		const str_t name = node->fn ? (node->fn->full_name.len ? node->fn->full_name : mir_get_fn_readable_name(node->fn)) : cstr("<global>");
+		str_buf_append(path, cstr(";"));
+		for (s32 i = 0; i < name.len; ++i) {
+			// Spaces and semicolons are used as separators in folded stacks format.
+			char c = name.ptr[i];
+			if (c == ';' || c == ' ' || c == '\n') c = '_';
+			str_buf_append_char(path, c);
+		}
+	}
+	if (node->count) str_buf_append_fmt(out, "{str} {u64}\n", *path, node->count);
+	for (s32 i = node->first_child; i != -1; i = profile[i].next_sibling) {
+		profile_write_node(out, profile, i, path);
+	}
+	path->len = path_len;
+}
+
+void vm_get_profile(struct assembly *assembly, str_buf_t *out) {
+	zone();
+	array(struct vm_profile_node) profile = NULL;
+	profile_get_node(&profile, 0, NULL); // Root is the first node.
+	for (usize i = 0; i < arrlenu(assembly->thread_local_contexts); ++i) {
+		struct virtual_machine *vm = &assembly->thread_local_contexts[i].vm;
+		if (arrlen(vm->profile)) profile_merge(&profile, 0, vm->profile, 0);
+	}
+
+	// Target name is used as the root frame.
+	str_buf_t path = get_tmp_str();
+	str_buf_append(&path, make_str_from_c(assembly->target->name));
+	profile_write_node(out, profile, 0, &path);
+	put_tmp_str(path);
+
+	arrfree(profile);
+	return_zone();
 }
 
 void vm_abort(struct virtual_machine *vm) {
-	mtx_lock(&vm->lock);
 	vm_print_backtrace(vm);
 	vm->aborted = true;
-	mtx_unlock(&vm->lock);
 }
 
 bool vm_eval_instr(struct virtual_machine *vm, struct assembly *assembly, struct mir_instr *instr) {
 	zone();
-	mtx_lock(&vm->lock);
-	vm->aborted  = false;
-	vm->assembly = assembly;
+	bassert(vm->assembly == assembly && "Virtual machine belongs to different assembly!");
+	ensure_main_stack(vm);
+	vm->aborted = false;
 	eval_instr(vm, instr);
-	mtx_unlock(&vm->lock);
 	return_zone(!vm->aborted);
 }
 
 void vm_provide_command_line_arguments(struct virtual_machine *vm, const s32 argc, char *argv[]) {
 	bassert(argc > 0 && "At least one command line argument must be provided!");
 	bassert(argv && "Invalid arguments value pointer!");
-	mtx_lock(&vm->lock);
+	ensure_main_stack(vm);
 
 	struct mir_type *slice_type;
 	vm_stack_ptr_t   slice_dest;
@@ -2532,7 +2696,6 @@ void vm_provide_command_line_arguments(struct virtual_machine *vm, const s32 arg
 	}
 
 	vm_write_slice(vm, slice_type, slice_dest, args_dest, argc);
-	mtx_unlock(&vm->lock);
 }
 
 u64 vm_override_var(struct virtual_machine *vm, struct mir_var *var, const u64 value) {
@@ -2551,9 +2714,9 @@ enum vm_interp_state vm_execute_fn(struct virtual_machine *vm,
                                    mir_const_values_t     *optional_args,
                                    vm_stack_ptr_t         *optional_return) {
 	bmagic_assert(fn);
-	mtx_lock(&vm->lock);
+	bassert(vm->assembly == assembly && "Virtual machine belongs to different assembly!");
+	ensure_main_stack(vm);
 
-	vm->assembly = assembly;
 	if (optional_args && optional_args->len) {
 		bassert(fn->type->data.fn.args);
 		bassert(sarrlenu(fn->type->data.fn.args) == sarrlenu(optional_args) && "Invalid count of explicitly passed arguments");
@@ -2579,20 +2742,25 @@ enum vm_interp_state vm_execute_fn(struct virtual_machine *vm,
 			}
 		}
 	}
-	mtx_unlock(&vm->lock);
 
 	return state;
 }
 
 static inline void release_snapshot(struct virtual_machine *vm, struct vm_stack *stack) {
 	bassert(stack);
-	arrput(vm->available_comptime_call_stacks, reset_stack(stack));
+	struct vm_globals *globals = vm->globals;
+	mtx_lock(&globals->lock);
+	arrput(globals->available_comptime_call_stacks, reset_stack(stack));
+	mtx_unlock(&globals->lock);
 }
 
 static inline void store_snapshot(struct virtual_machine *vm, struct vm_stack *stack, struct mir_instr_call *call) {
-	bassert(tbl_lookup_index(vm->comptime_call_stacks, call) == -1);
+	struct vm_globals *globals = vm->globals;
+	mtx_lock(&globals->lock);
+	bassert(tbl_lookup_index(globals->comptime_call_stacks, call) == -1);
 	struct vm_snapshot entry = (struct vm_snapshot){.hash = call, .stack = stack};
-	tbl_insert(vm->comptime_call_stacks, entry);
+	tbl_insert(globals->comptime_call_stacks, entry);
+	mtx_unlock(&globals->lock);
 }
 
 struct get_snapshot_result {
@@ -2604,32 +2772,32 @@ struct get_snapshot_result {
 // no such stack, new one is created or reused from cache.
 static struct get_snapshot_result get_snapshot(struct virtual_machine *vm, struct mir_instr_call *call) {
 	bassert(call);
-	struct get_snapshot_result result = {0};
+	struct get_snapshot_result result  = {0};
+	struct vm_globals         *globals = vm->globals;
+	mtx_lock(&globals->lock);
 
-	const s32 index = tbl_lookup_index(vm->comptime_call_stacks, call);
+	const s32 index = tbl_lookup_index(globals->comptime_call_stacks, call);
 	if (index != -1) {
-		bassert(vm->comptime_call_stacks[index].hash == call);
-		result.stack = vm->comptime_call_stacks[index].stack;
-		bcheck_true(tbl_erase(vm->comptime_call_stacks, call));
+		bassert(globals->comptime_call_stacks[index].hash == call);
+		result.stack = globals->comptime_call_stacks[index].stack;
+		bcheck_true(tbl_erase(globals->comptime_call_stacks, call));
 		result.resume = true;
-		return result;
+	} else if (arrlenu(globals->available_comptime_call_stacks)) {
+		result.stack = arrpop(globals->available_comptime_call_stacks);
+		bassert(result.stack && result.stack->allocated_bytes == VM_COMPTIME_CALL_STACK_SIZE);
 	}
+	mtx_unlock(&globals->lock);
 
-	if (arrlenu(vm->available_comptime_call_stacks)) {
-		result.stack = arrpop(vm->available_comptime_call_stacks);
-		bassert(result.stack && result.stack->allocated_bytes == VM_COMPTIME_CALL_STACK_SIZE);
-	} else {
+	if (!result.stack) {
 		result.stack = create_stack(VM_COMPTIME_CALL_STACK_SIZE);
 		batomic_fetch_add_s32(&vm->assembly->stats.comptime_call_stacks_count, 1);
 	}
-	bassert(result.stack);
 	return result;
 }
 
 enum vm_interp_state vm_execute_comptime_call(struct virtual_machine *vm, struct assembly *assembly, struct mir_instr_call *call) {
 	zone();
-	mtx_lock(&vm->lock);
-	vm->assembly = assembly;
+	bassert(vm->assembly == assembly && "Virtual machine belongs to different assembly!");
 	bassert(call && isflag(call->base.state, MIR_IS_ANALYZED));
 	bassert(mir_is_comptime(&call->base) && "Top level call is expected to be comptime.");
 	struct mir_fn *fn = mir_get_callee(call);
@@ -2650,7 +2818,7 @@ enum vm_interp_state vm_execute_comptime_call(struct virtual_machine *vm, struct
 		}
 	}
 
-	const u64 prev_is_comptime = vm_override_var(vm, assembly->is_comptime, true);
+	comptime_flag_enter(vm, assembly->is_comptime, &vm->globals->comptime_depth);
 
 	enum vm_interp_state state;
 	if (isflag(fn->flags, FLAG_EXTERN) || isflag(fn->flags, FLAG_INTRINSIC)) {
@@ -2659,7 +2827,7 @@ enum vm_interp_state vm_execute_comptime_call(struct virtual_machine *vm, struct
 		state = execute_function(vm, fn, call, snapshot.resume);
 	}
 
-	vm_override_var(vm, assembly->is_comptime, prev_is_comptime);
+	comptime_flag_leave(vm, assembly->is_comptime, &vm->globals->comptime_depth);
 
 	switch (state) {
 	case VM_INTERP_PASSED:
@@ -2694,15 +2862,11 @@ enum vm_interp_state vm_execute_comptime_call(struct virtual_machine *vm, struct
 	}
 
 	swap_current_stack(vm, previous_stack);
-	mtx_unlock(&vm->lock);
-
 	return_zone(state);
 }
 
 void vm_alloc_global(struct virtual_machine *vm, struct assembly *assembly, struct mir_var *var) {
-	mtx_lock(&vm->lock);
-
-	vm->assembly = assembly;
+	bassert(vm->assembly == assembly && "Virtual machine belongs to different assembly!");
 	bassert(var);
 	bassert(isflag(var->iflags, MIR_VAR_GLOBAL) &&
 	        "Allocated variable is supposed to be a global variable.");
@@ -2717,21 +2881,14 @@ void vm_alloc_global(struct virtual_machine *vm, struct assembly *assembly, stru
 	} else {
 		var->vm_ptr.global = data_alloc(vm, type);
 	}
-
-	mtx_unlock(&vm->lock);
 }
 
 vm_stack_ptr_t vm_alloc_raw(struct virtual_machine *vm, struct assembly UNUSED(*assembly), struct mir_type *type) {
-	mtx_lock(&vm->lock);
-	vm_stack_ptr_t result = data_alloc(vm, type);
-	mtx_unlock(&vm->lock);
-	return result;
+	return data_alloc(vm, type);
 }
 
 // Try to fetch variable allocation pointer.
 vm_stack_ptr_t vm_read_var(struct virtual_machine *vm, const struct mir_var *var) {
-	mtx_lock(&vm->lock);
-
 	vm_stack_ptr_t ptr = NULL;
 	if (var->value.is_comptime) {
 		ptr = var->value.data;
@@ -2742,8 +2899,6 @@ vm_stack_ptr_t vm_read_var(struct virtual_machine *vm, const struct mir_var *var
 		ptr = stack_rel_to_abs_ptr(vm, var->vm_ptr.local);
 	}
 	bassert(ptr && "Attempt to get allocation pointer of unallocated variable!");
-	mtx_unlock(&vm->lock);
-
 	return ptr;
 }
 
@@ -4,6 +4,8 @@
 #include "common.h"
 #include "threading.h"
 
+#include <dyncall.h>
+
 // Values:
 // * compile time constant
 //     - allocated in data buffer
@@ -40,6 +42,13 @@ enum vm_interp_state {
 struct vm_frame {
 	struct vm_frame       *prev;
 	struct mir_instr_call *caller; // Optional
+
+	// Profile call tree node of this frame resolved lazily when profiling is enabled. The node index
+	// is valid only in the profile of 'profile_vm'; postponed compile-time calls may be resumed by
+	// other VM, in such a case the node is resolved again from 'profile_fn' chain of the frames.
+	struct virtual_machine *profile_vm;
+	struct mir_fn          *profile_fn;
+	s32                     profile_node;
 };
 
 struct vm_stack {
@@ -56,18 +65,25 @@ struct vm_bufpage {
 	vm_stack_ptr_t     top;
 };
 
+// Node of compile-time execution call tree collected by '--vm-profile'; the first node is the root
+// (without function).
+struct vm_profile_node {
+	struct mir_fn *fn;
+	s32            parent;
+	s32            first_child;
+	s32            next_sibling;
+	u64            count; // Count of instructions executed directly in this function.
+};
+
 struct vm_snapshot {
 	struct mir_instr_call *hash;
 	struct vm_stack       *stack;
 };
 
-struct virtual_machine {
-	struct vm_stack   *stack;
-	struct vm_stack   *main_stack; // Owner pointer of the main execution stack.
-	struct vm_bufpage *data;       // Compile time values + global variables.
-	struct assembly   *assembly;
-	array(char) dcsigtmp;
-	bool aborted;
+// Compile-time data shared by all virtual machines of a single assembly. All mutable parts are
+// guarded by the lock.
+struct vm_globals {
+	struct vm_bufpage *data; // Compile time values + global variables.
 
 	// Cache of unused compile-time call executed stacks available for reuse.
 	array(struct vm_stack *) available_comptime_call_stacks;
@@ -77,12 +93,33 @@ struct virtual_machine {
 	// the function is analyzed. This cache is used to restore previous execution.
 	//
 	// When the call is successfully completed the cached entry must be removed from the table and
-	// returned back to 'available_comptime_call_stacks' array.
+	// returned back to 'available_comptime_call_stacks' array. Postponed call can be resumed by
+	// any worker, so the table is shared.
 	hash_table(struct vm_snapshot) comptime_call_stacks;
 
+	// Count of currently running executions requiring 'is_comptime_run' and 'is_comptime' builtin
+	// variables to be set. These are global variables visible to all workers, so we keep them set
+	// as long as there is at least one such execution in progress.
+	s32 comptime_run_depth;
+	s32 comptime_depth;
+
 	mtx_t lock;
 };
 
+// Execution context of the interpreter. Each worker thread has its own instance (see
+// 'assembly_get_vm'), so independent compile-time executions does not block each other; only
+// global data allocations and snapshot cache lookups are synchronized.
+struct virtual_machine {
+	struct vm_stack   *stack;
+	struct vm_stack   *main_stack; // Owner pointer of the main execution stack (allocated on demand).
+	struct vm_globals *globals;
+	struct assembly   *assembly;
+	DCCallVM          *dc_vm; // DynCall VM used for external method execution in compile time.
+	array(char) dcsigtmp;
+	array(struct vm_profile_node) profile;
+	bool aborted;
+};
+
 enum mir_value_address_mode {
 	MIR_VAM_UNKNOWN,
 
@@ -108,7 +145,9 @@ struct mir_const_expr_value {
 
 typedef sarr_t(struct mir_const_expr_value, 32) mir_const_values_t;
 
-void vm_init(struct virtual_machine *vm, usize stack_size);
+void vm_globals_init(struct vm_globals *globals);
+void vm_globals_terminate(struct vm_globals *globals);
+void vm_init(struct virtual_machine *vm, struct assembly *assembly, struct vm_globals *globals);
 void vm_terminate(struct virtual_machine *vm);
 bool vm_eval_instr(struct virtual_machine *vm, struct assembly *assembly, struct mir_instr *instr);
 
@@ -136,6 +175,9 @@ void vm_alloc_global(struct virtual_machine *vm, struct assembly *assembly, stru
 // Allocate raw memory on the stack to hold sizeof(type) value.
 vm_stack_ptr_t vm_alloc_raw(struct virtual_machine *vm, struct assembly *assembly, struct mir_type *type);
 void           vm_print_backtrace(struct virtual_machine *vm);
+// Merge profiles collected by all virtual machines of the assembly and write them into the file
+// set by '--vm-profile' in folded stacks format.
+void           vm_get_profile(struct assembly *assembly, str_buf_t *out);
 void           vm_abort(struct virtual_machine *vm);
 
 // Return pointer to constant or stack allocated variable.
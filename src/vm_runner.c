@@ -32,54 +32,215 @@
 
 #define TEXT_LINE "--------------------------------------------------------------------------------"
 
+struct vm_test_case {
+	struct mir_fn       *fn;
+	f64                  runtime_ms;
+	enum vm_interp_state state;
+};
+
+static bool str_contains(const str_t str, const str_t sub) {
+	if (sub.len == 0) return true;
+	for (s32 i = 0; i + sub.len <= str.len; ++i) {
+		if (memcmp(str.ptr + i, sub.ptr, sub.len) == 0) return true;
+	}
+	return false;
+}
+
+static bool is_test_case_selected(const struct target *target, struct mir_fn *fn) {
+	const str_t name = fn->id->str;
+	if (target->tests_filter && !str_contains(name, make_str_from_c(target->tests_filter))) {
+		return false;
+	}
+	if (target->tests_shard_count > 1) {
+		// Shards must be stable across compiler processes, the order of test cases depends on the
+		// order of analysis, so we use the name hash instead.
+		return (s32)(strhash(name) % (hash_t)target->tests_shard_count) == target->tests_shard_index;
+	}
+	return true;
+}
+
+static void test_case_run(struct assembly *assembly, struct vm_test_case *test_case) {
+	struct mir_fn *test_fn = test_case->fn;
+	bassert(isflag(test_fn->flags, FLAG_TEST_FN));
+	const f64 start       = get_tick_ms();
+	test_case->state      = vm_execute_fn(assembly_get_vm(assembly), assembly, test_fn, NULL, NULL);
+	test_case->runtime_ms = get_tick_ms() - start;
+}
+
+static void test_case_job(struct job_context *ctx) {
+	struct vm_test_case *test_case = ctx->test.test_case;
+	test_case_run(ctx->test.assembly, test_case);
+	// Same as in serial mode; failed test must not prevent others from reporting errors.
+	if (test_case->state != VM_INTERP_PASSED) batomic_store_s32(&builder.errorc, 0);
+}
+
+static void print_test_case_result(struct vm_test_case *test_case) {
+	const str_t name = test_case->fn->id->str;
+	if (test_case->state == VM_INTERP_PASSED) {
+		printf("[ ");
+		color_print(stdout, BL_GREEN, "PASS");
+		printf(" |      ] " STR_FMT " (%f ms)\n", STR_ARG(name), test_case->runtime_ms);
+	} else {
+		printf("[      | ");
+		color_print(stdout, BL_RED, "FAIL");
+		printf(" ] " STR_FMT " (%f ms)\n", STR_ARG(name), test_case->runtime_ms);
+	}
+}
+
+static void write_escaped(FILE *stream, const str_t str, const bool xml) {
+	for (s32 i = 0; i < str.len; ++i) {
+		const char c = str.ptr[i];
+		if (xml) {
+			switch (c) {
+			case '&':
+				fputs("&amp;", stream);
+				continue;
+			case '<':
+				fputs("&lt;", stream);
+				continue;
+			case '>':
+				fputs("&gt;", stream);
+				continue;
+			case '"':
+				fputs("&quot;", stream);
+				continue;
+			}
+		} else if (c == '"' || c == '\\') {
+			fputc('\\', stream);
+		}
+		fputc(c, stream);
+	}
+}
+
+static void write_report(struct assembly *assembly, struct vm_test_case *test_cases, const s32 failed_count, const f64 total_ms) {
+	const struct target *target = assembly->target;
+	FILE                *stream = fopen(target->tests_report, "w");
+	if (!stream) {
+		builder_error("Cannot open test report file '%s'.", target->tests_report);
+		return;
+	}
+	const str_t target_name = make_str_from_c(target->name);
+	const s64   count       = arrlen(test_cases);
+
+	switch (target->tests_report_format) {
+	case TEST_REPORT_JSON:
+		fprintf(stream, "{\n\t\"target\": \"");
+		write_escaped(stream, target_name, false);
+		fprintf(stream, "\",\n\t\"executed\": %lld,\n\t\"failed\": %d,\n\t\"duration_ms\": %f,\n\t\"tests\": [", (long long)count, failed_count, total_ms);
+		for (s64 i = 0; i < count; ++i) {
+			struct vm_test_case *test_case = &test_cases[i];
+			struct location     *loc       = test_case->fn->decl_node->location;
+			fprintf(stream, "%s\n\t\t{\"name\": \"", i ? "," : "");
+			write_escaped(stream, test_case->fn->id->str, false);
+			fprintf(stream, "\", \"file\": \"");
+			write_escaped(stream, loc->unit->filepath, false);
+			fprintf(stream,
+			        "\", \"line\": %d, \"passed\": %s, \"duration_ms\": %f}",
+			        loc->line,
+			        test_case->state == VM_INTERP_PASSED ? "true" : "false",
+			        test_case->runtime_ms);
+		}
+		fprintf(stream, "\n\t]\n}\n");
+		break;
+
+	case TEST_REPORT_JUNIT:
+		fprintf(stream, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+		fprintf(stream, "<testsuites tests=\"%lld\" failures=\"%d\" time=\"%f\">\n", (long long)count, failed_count, total_ms * 0.001);
+		fprintf(stream, "\t<testsuite name=\"");
+		write_escaped(stream, target_name, true);
+		fprintf(stream, "\" tests=\"%lld\" failures=\"%d\" time=\"%f\">\n", (long long)count, failed_count, total_ms * 0.001);
+		for (s64 i = 0; i < count; ++i) {
+			struct vm_test_case *test_case = &test_cases[i];
+			struct location     *loc       = test_case->fn->decl_node->location;
+			fprintf(stream, "\t\t<testcase name=\"");
+			write_escaped(stream, test_case->fn->id->str, true);
+			fprintf(stream, "\" classname=\"");
+			write_escaped(stream, loc->unit->filename, true);
+			fprintf(stream, "\" file=\"");
+			write_escaped(stream, loc->unit->filepath, true);
+			fprintf(stream, "\" line=\"%d\" time=\"%f\"", loc->line, test_case->runtime_ms * 0.001);
+			if (test_case->state == VM_INTERP_PASSED) {
+				fprintf(stream, "/>\n");
+			} else {
+				fprintf(stream, ">\n\t\t\t<failure message=\"Test failed.\"/>\n\t\t</testcase>\n");
+			}
+		}
+		fprintf(stream, "\t</testsuite>\n</testsuites>\n");
+		break;
+	}
+	fclose(stream);
+}
+
 void vm_tests_run(struct assembly *assembly) {
-	struct virtual_machine *vm             = &assembly->vm;
-	struct mir_fn         **cases          = assembly->testing.cases;
-	const bool              minimal_output = assembly->target->tests_minimal_output;
+	struct mir_fn      **cases          = assembly->testing.cases;
+	const struct target *target         = assembly->target;
+	const bool           minimal_output = target->tests_minimal_output;
 
-	const s64 test_count = arrlen(cases);
+	if (target->tests_shard_count > 1 && (target->tests_shard_index < 0 || target->tests_shard_index >= target->tests_shard_count)) {
+		builder_error("Invalid test shard index %d, expected is value in range <0, %d).", target->tests_shard_index, target->tests_shard_count);
+		assembly->vm_run.last_execution_status = 0;
+		return;
+	}
+
+	array(struct vm_test_case) test_cases = NULL;
+	for (s64 i = 0; i < arrlen(cases); ++i) {
+		if (!is_test_case_selected(target, cases[i])) continue;
+		arrput(test_cases, ((struct vm_test_case){.fn = cases[i]}));
+	}
+
+	const s64 test_count = arrlen(test_cases);
 	if (test_count == 0) {
+		assembly->vm_run.last_execution_status = 0;
 		return;
 	}
 
+	// The debugger can be attached only to a single virtual machine.
+	const bool is_parallel = target->tests_parallel && !target->vmdbg_enabled && !is_in_single_thread_mode() && test_count > 1;
+
 	if (!minimal_output) {
-		printf("\nTesting started in compile time for target: %s\n", assembly->target->name);
+		printf("\nTesting started in compile time for target: %s\n", target->name);
 		printf(TEXT_LINE "\n");
 	}
 
-	s32 failed_count = 0;
+	builder.current_executed_assembly = assembly;
+	const f64 start                   = get_tick_ms();
 
-	struct case_meta {
-		str_t name;
-		f64   runtime_ms;
-	};
+	if (is_parallel) {
+		// Each worker has its own virtual machine with separate stack; all tests not marked as
+		// serial are executed at once, the rest is executed one by one afterwards.
+		for (s64 i = 0; i < test_count; ++i) {
+			struct vm_test_case *test_case = &test_cases[i];
+			if (isflag(test_case->fn->flags, FLAG_SERIAL)) continue;
+			submit_job(&test_case_job, &(struct job_context){.test = {.assembly = assembly, .test_case = test_case}});
+		}
+		wait_threads();
+		batomic_store_s32(&builder.errorc, 0);
+		for (s64 i = 0; i < test_count; ++i) {
+			struct vm_test_case *test_case = &test_cases[i];
+			if (isnotflag(test_case->fn->flags, FLAG_SERIAL)) continue;
+			test_case_run(assembly, test_case);
+			if (test_case->state != VM_INTERP_PASSED) batomic_store_s32(&builder.errorc, 0);
+		}
+		for (s64 i = 0; i < test_count; ++i) {
+			print_test_case_result(&test_cases[i]);
+		}
+	} else {
+		for (s64 i = 0; i < test_count; ++i) {
+			struct vm_test_case *test_case = &test_cases[i];
+			test_case_run(assembly, test_case);
+			print_test_case_result(test_case);
+			if (test_case->state != VM_INTERP_PASSED) builder.errorc = 0;
+		}
+	}
 
-	array(struct case_meta) failed = NULL;
+	const f64 total_ms                = get_tick_ms() - start;
+	builder.current_executed_assembly = NULL;
 
+	s32 failed_count = 0;
 	for (s64 i = 0; i < test_count; ++i) {
-		struct mir_fn *test_fn = cases[i];
-		bassert(isflag(test_fn->flags, FLAG_TEST_FN));
-		const f64 start = get_tick_ms();
-
-		builder.current_executed_assembly = assembly;
-		const enum vm_interp_state state  = vm_execute_fn(vm, assembly, test_fn, NULL, NULL);
-		builder.current_executed_assembly = NULL;
-
-		const f64   runtime_ms = get_tick_ms() - start;
-		const str_t name       = test_fn->id->str;
-		if (state == VM_INTERP_PASSED) {
-			printf("[ ");
-			color_print(stdout, BL_GREEN, "PASS");
-			printf(" |      ] " STR_FMT " (%f ms)\n", STR_ARG(name), runtime_ms);
-		} else {
-			printf("[      | ");
-			color_print(stdout, BL_RED, "FAIL");
-			printf(" ] " STR_FMT " (%f ms)\n", STR_ARG(name), runtime_ms);
-			arrput(failed, ((struct case_meta){.name = name, .runtime_ms = runtime_ms}));
-			builder.errorc = 0;
-			++failed_count;
-		}
+		if (test_cases[i].state != VM_INTERP_PASSED) ++failed_count;
 	}
+	builder.errorc = 0;
 
 	s32 perc = 100;
 	if (failed_count > 0)
@@ -87,24 +248,23 @@ void vm_tests_run(struct assembly *assembly) {
 	if (!minimal_output) {
 		printf("\nResults:\n");
 		printf(TEXT_LINE "\n");
-		for (s64 i = 0; i < arrlen(failed); ++i) {
-			struct case_meta *f = &failed[i];
-			printf("[      | ");
-			color_print(stdout, BL_RED, "FAIL");
-			printf(" ] " STR_FMT " (%f ms)\n", STR_ARG(f->name), f->runtime_ms);
+		for (s64 i = 0; i < test_count; ++i) {
+			if (test_cases[i].state == VM_INTERP_PASSED) continue;
+			print_test_case_result(&test_cases[i]);
 		}
 
-		if (arrlen(failed)) printf(TEXT_LINE "\n");
+		if (failed_count) printf(TEXT_LINE "\n");
 		printf("Executed: %llu, passed %d%%.\n", (unsigned long long)test_count, perc);
 		printf(TEXT_LINE "\n");
 	}
-	arrfree(failed);
+	if (target->tests_report) write_report(assembly, test_cases, failed_count, total_ms);
+	arrfree(test_cases);
 	assembly->vm_run.last_execution_status = failed_count;
 }
 
 BL_OBSOLETE_SINCE(0, 14, "vm_build_entry_run");
 void vm_build_entry_run(struct assembly *assembly) {
-	struct virtual_machine *vm     = &assembly->vm;
+	struct virtual_machine *vm     = assembly_get_vm(assembly);
 	struct mir_fn          *entry  = assembly->vm_run.build_entry;
 	const struct target    *target = assembly->target;
 	if (!entry) {
@@ -124,7 +284,7 @@ void vm_build_entry_run(struct assembly *assembly) {
 }
 
 void vm_entry_run(struct assembly *assembly) {
-	struct virtual_machine *vm     = &assembly->vm;
+	struct virtual_machine *vm     = assembly_get_vm(assembly);
 	struct mir_fn          *entry  = assembly->vm_run.entry;
 	const struct target    *target = assembly->target;
 	if (!entry) {
@@ -5,29 +5,76 @@
 //
 //   - No optimiations at all, this backend is supposed to be fast as possible in compilation. For
 //     high performance release builds use LLVM.
-//   - We use only 32bit relative addressing which limits binary size to ~2GB, do we need more?
-//   - Only single .text section is generated (maximum size is 4GB).
-//   - Relocation table is can have 65535 entries only.
+//   - We use only 32bit relative addressing which limits distance between sections to ~2GB.
+//   - Each function gets its own code and data section (so the linker can drop unused ones), in case there are too
+//     many functions, consecutive functions share one section (see MAX_SECTIONS_PER_KIND).
+//   - Symbols and relocations are internally kept in COFF format, on Linux they are converted to ELF64
+//     relocatable object when the output file is written.
+//   - Floating point values are not supported in any calling convention.
 //
 
 #include "assembly.h"
 #include "builder.h"
 #include "table.h"
 
-#if BL_PLATFORM_WIN
+#if BL_PLATFORM_WIN || BL_PLATFORM_LINUX
 
 #include "common.h"
 #include "stb_ds.h"
 #include "threading.h"
+
+#if BL_PLATFORM_LINUX
+#include <elf.h>
+
+// Subset of COFF definitions from winnt.h used by the backend internally.
+#pragma pack(push, 2)
+typedef struct {
+	union {
+		u8 ShortName[8];
+		struct {
+			u32 Short;
+			u32 Long;
+		} Name;
+		u32 LongName[2];
+	} N;
+	u32 Value;
+	s16 SectionNumber;
+	u16 Type;
+	u8  StorageClass;
+	u8  NumberOfAuxSymbols;
+} IMAGE_SYMBOL;
+
+typedef struct {
+	union {
+		u32 VirtualAddress;
+		u32 RelocCount;
+	};
+	u32 SymbolTableIndex;
+	u16 Type;
+} IMAGE_RELOCATION;
+#pragma pack(pop)
+
+#define IMAGE_SYM_CLASS_EXTERNAL 2
+#define IMAGE_SYM_CLASS_LABEL    6
+#define IMAGE_REL_AMD64_ADDR64   0x0001
+#define IMAGE_REL_AMD64_REL32    0x0004
+#define IMAGE_REL_AMD64_REL32_4  0x0008
+#endif
+
 #include "x86_64_instructions.h"
 
 #define UNUSED_REGISTER_MAP_VALUE   -1
 #define RESERVED_REGISTER_MAP_VALUE -2
 
+// Section numbers used during code generation; converted to output section numbers when units are merged.
 #define SECTION_EXTERN 0
 #define SECTION_TEXT   1
 #define SECTION_DATA   2
 
+// Maximum count of output code or data sections; keeps total section count in limits of COFF and ELF (including ELF
+// relocation sections).
+#define MAX_SECTIONS_PER_KIND 0x3F00
+
 #define DT_FUNCTION 0x20
 
 #define MEMCPY_BUILTIN cstr("__bl_memcpy")
@@ -38,7 +85,19 @@ hash_t MEMSET_BUILTIN_HASH = 0;
 #define data_ptr_s32(data, p) ((s32 *)&(data)[p])
 
 // @Performance: internal functions can support more arguments passed through registers.
+#if BL_PLATFORM_WIN
+// Microsoft x64 calling convention.
 static const enum x64_register CALL_ABI[4] = {RCX, RDX, R8, R9};
+// Stack space reserved by the caller for the callee to store register arguments.
+#define SHADOW_SPACE_SIZE 0x20
+// Registers available for local variables; these must be preserved by the callee.
+static const enum x64_register CALLEE_SAVED[7] = {RBX, RSI, RDI, R12, R13, R14, R15};
+#else
+// System V AMD64 calling convention.
+static const enum x64_register CALL_ABI[6] = {RDI, RSI, RDX, RCX, R8, R9};
+#define SHADOW_SPACE_SIZE 0
+static const enum x64_register CALLEE_SAVED[5] = {RBX, R12, R13, R14, R15};
+#endif
 
 static const u64 NO_VALUE = -1;
 
@@ -58,6 +117,9 @@ enum x64_value_kind {
 	REGISTER_OFFSET = 5,
 	// Absolute address in register + static offset.
 	REGISTER_ADDRESS = 6,
+	// Local variable kept in callee-saved register for its whole live range. The register is not released together
+	// with the value.
+	VARIABLE_REGISTER = 7,
 };
 
 struct x64_value {
@@ -85,6 +147,7 @@ struct x64_value {
 #define peek_register(index)         (tctx->values[(index)].reg)
 #define peek_register_offset(index)  (tctx->values[(index)].reg_off_addr)
 #define peek_register_address(index) (tctx->values[(index)].reg_off_addr)
+#define peek_variable_register(index) (tctx->values[(index)].reg)
 
 struct sym_patch {
 	s32               target_section;
@@ -107,6 +170,45 @@ struct rtti_entry {
 	hash_t hash;
 };
 
+struct index_entry {
+	void *hash;
+	s32   index;
+};
+
+// Output of one generation job (top-level function or global variable) stored in thread-local buffers. Units are
+// merged into the global context once all jobs are done.
+struct x64_unit {
+	str_t name; // Name of the first unit symbol used for deterministic ordering; set before merge.
+	u32   thread_index;
+	s32   text_section_number; // Output section numbers.
+	s32   data_section_number;
+
+	struct {
+		u32 begin; // Thread-local buffer offset.
+		u32 len;
+		u32 dest;  // Global buffer offset.
+	} text, data, syms, strs, patches;
+};
+
+// Live interval of local variable considered for register allocation. Positions are indices of instructions in the
+// function linearized in order of its blocks.
+struct var_interval {
+	struct mir_var   *var;
+	s32               start;
+	s32               end;
+	enum x64_register reg;
+	bool              is_escaping; // Address of the variable is used; it must live in memory.
+};
+
+// Output section containing code or data of one or more consecutive units.
+struct x64_section {
+	s32   kind;   // SECTION_TEXT or SECTION_DATA
+	u32   offset; // Offset in the global code or data buffer.
+	u32   size;
+	str_t name;   // Name of the unit in case the section contains only one unit.
+	array(IMAGE_RELOCATION) relocs;
+};
+
 struct thread_context {
 	array(u8) text;
 	array(u8) data;
@@ -116,6 +218,7 @@ struct thread_context {
 	array(struct mir_instr_block *) emit_block_queue;
 	array(struct sym_patch) local_patches; // local to the function
 	array(struct sym_patch) patches;
+	array(struct x64_unit) units; // All units generated by this thread.
 
 	// Contains mapping of all available register of the target to x64_values.
 	s32 register_table[REGISTER_COUNT];
@@ -130,6 +233,31 @@ struct thread_context {
 	} stack;
 
 	u64 current_fn_composit_return_dest; // Indexed from 1!
+
+	// Last register store into memory used by the peephole optimization in mov_rm.
+	struct {
+		u32   position; // Position right after the store instruction; 0 when not valid.
+		s32   offset;
+		usize size;
+		u8    base;
+		u8    reg;
+	} last_store;
+
+	// Register allocation of local variables (see allocate_variable_registers).
+	struct {
+		hash_table(struct index_entry) var_index;
+		hash_table(struct index_entry) block_index;
+		array(struct mir_instr_block *) blocks;
+		array(struct var_interval) intervals;
+		array(s32) block_bounds; // [start, end] position of each block.
+		array(u64) sets;         // Liveness bitsets of all blocks.
+		array(s32) sorted;
+
+		// Callee-saved registers used by variables in the current function.
+		enum x64_register saved_registers[static_arrlenu(CALLEE_SAVED)];
+		s32               saved_offsets[static_arrlenu(CALLEE_SAVED)];
+		s32               saved_num;
+	} regalloc;
 };
 
 struct context {
@@ -139,14 +267,14 @@ struct context {
 
 	struct {
 		array(u8) bytes;
-		array(IMAGE_RELOCATION) relocs;
 	} code;
 
 	struct {
 		array(u8) bytes;
-		array(IMAGE_RELOCATION) relocs;
 	} data;
 
+	array(struct x64_section) sections;
+
 	array(IMAGE_SYMBOL) syms;
 	array(char) strs;
 
@@ -157,8 +285,8 @@ struct context {
 	spl_t schedule_for_generation_lock;
 
 	array(struct sym_patch) patches;
+	array(struct x64_unit) units;
 
-	mtx_t mutex;
 	spl_t uq_name_lock;
 };
 
@@ -224,6 +352,8 @@ enum op_kind {
 
 	OP_REGISTER_ADDRESS_NUMBER   = (REGISTER_ADDRESS << 4) | X64_NUMBER,
 	OP_REGISTER_ADDRESS_COMPOSIT = (REGISTER_ADDRESS << 4) | X64_COMPOSIT,
+
+	OP_VARIABLE_REGISTER_NUMBER = (VARIABLE_REGISTER << 4) | X64_NUMBER,
 };
 
 static inline u32 get_position(struct thread_context *tctx, s32 section_number) {
@@ -265,10 +395,110 @@ static inline void unique_name(struct context *ctx, str_buf_t *dest, const char
 	str_buf_append_fmt(dest, "{s}{str}{u64}", prefix, name, serial);
 }
 
-static inline bool does_function_return_composit(struct mir_type *fn_type) {
+// Composite values smaller than 16 bytes are returned in RAX and RDX when the register split (System V) is enabled.
+static inline bool is_composit_return_in_registers(struct context *ctx, struct mir_type *fn_type) {
 	bassert(fn_type->kind == MIR_TYPE_FN);
 	struct mir_type *ret_type = fn_type->data.fn.ret_type;
-	return ret_type->kind != MIR_TYPE_VOID && get_type_kind(ret_type) == X64_COMPOSIT;
+	if (ret_type->kind == MIR_TYPE_VOID || get_type_kind(ret_type) != X64_COMPOSIT) return false;
+	return ctx->assembly->target->reg_split && !fn_type->data.fn.has_sret;
+}
+
+// Returns true in case the composite return value is passed through the hidden pointer argument.
+static inline bool does_function_return_composit(struct context *ctx, struct mir_type *fn_type) {
+	bassert(fn_type->kind == MIR_TYPE_FN);
+	struct mir_type *ret_type = fn_type->data.fn.ret_type;
+	if (ret_type->kind == MIR_TYPE_VOID || get_type_kind(ret_type) != X64_COMPOSIT) return false;
+	return !is_composit_return_in_registers(ctx, fn_type);
+}
+
+struct x64_arg_location {
+	enum x64_register regs[2];
+	// Count of registers used to pass the argument, zero for arguments passed on the stack.
+	s32 reg_num;
+	// Offset of the argument in the stack argument area (relative to RSP in the call site).
+	s32 stack_offset;
+	// Whole composite value is copied into the stack argument area.
+	bool is_in_memory;
+};
+
+// Sizes of composite argument parts passed in registers when register split is enabled.
+static inline void get_split_sizes(enum llvm_extern_arg_struct_generation_mode easgm, s32 sizes[2]) {
+	sizes[0] = 8;
+	sizes[1] = 0;
+	switch (easgm) {
+	case LLVM_EASGM_8:
+		sizes[0] = 1;
+		break;
+	case LLVM_EASGM_16:
+		sizes[0] = 2;
+		break;
+	case LLVM_EASGM_32:
+		sizes[0] = 4;
+		break;
+	case LLVM_EASGM_64:
+		break;
+	case LLVM_EASGM_64_8:
+		sizes[1] = 1;
+		break;
+	case LLVM_EASGM_64_16:
+		sizes[1] = 2;
+		break;
+	case LLVM_EASGM_64_32:
+		sizes[1] = 4;
+		break;
+	case LLVM_EASGM_64_64:
+		sizes[1] = 8;
+		break;
+	default:
+		babort("Invalid argument split mode!");
+	}
+}
+
+// Resolve location of the argument at 'arg_index' passed into the function of 'fn_type', the 'loc' is optional. Returns
+// size of the stack argument area required by the call.
+static s32 get_arg_location(struct context *ctx, struct mir_type *fn_type, usize arg_index, struct x64_arg_location *loc) {
+	mir_args_t *args       = fn_type->data.fn.args;
+	s32         reg_index  = does_function_return_composit(ctx, fn_type) ? 1 : 0; // Hidden return value pointer.
+	s32         stack_size = 0;
+
+	for (usize i = 0; i < sarrlenu(args); ++i) {
+		struct mir_arg *arg = sarrpeek(args, i);
+		if (isflag(arg->flags, FLAG_COMPTIME)) continue;
+
+		struct x64_arg_location l = {.regs = {INVALID_REGISTER, INVALID_REGISTER}};
+#if BL_PLATFORM_WIN
+		// Each argument has its own 8 byte slot on the stack, first four are passed in registers.
+		bassert(arg->llvm_easgm == LLVM_EASGM_NONE);
+		if (reg_index < (s32)static_arrlenu(CALL_ABI)) {
+			l.regs[0] = CALL_ABI[reg_index];
+			l.reg_num = 1;
+		}
+		l.stack_offset = reg_index * 8;
+		stack_size     = ++reg_index * 8;
+#else
+		s32 num = 1;
+		if (arg->llvm_easgm == LLVM_EASGM_BYVAL) {
+			num = 0;
+		} else if (arg->llvm_easgm >= LLVM_EASGM_64_8) {
+			num = 2;
+		}
+
+		// Split composites are passed in memory in case there is not enough registers for all parts.
+		if (num && reg_index + num <= (s32)static_arrlenu(CALL_ABI)) {
+			for (s32 j = 0; j < num; ++j) {
+				l.regs[j] = CALL_ABI[reg_index++];
+			}
+			l.reg_num = num;
+		} else {
+			l.is_in_memory = arg->llvm_easgm != LLVM_EASGM_NONE;
+			l.stack_offset = stack_size;
+			stack_size += l.is_in_memory ? (s32)next_aligned2(arg->type->store_size_bytes, 8) : 8;
+		}
+#endif
+		if (loc && i == arg_index) *loc = l;
+	}
+
+	return MAX(stack_size, SHADOW_SPACE_SIZE);
 }
 
 void add_code(struct thread_context *tctx, const void *buf, s32 len) {
@@ -277,6 +507,42 @@ void add_code(struct thread_context *tctx, const void *buf, s32 len) {
 	memcpy(&tctx->text[i], buf, len);
 }
 
+//
+// Peephole optimizations
+//
+// Instructions are encoded directly into the byte stream, so we do only local optimizations based on the last emitted
+// instruction. Any label invalidates the state since there might be multiple ways how to get to the labeled position.
+//
+
+void record_store(struct thread_context *tctx, u8 base, s32 offset, u8 r, usize size) {
+	tctx->last_store.position = get_position(tctx, SECTION_TEXT);
+	tctx->last_store.base     = base;
+	tctx->last_store.offset   = offset;
+	tctx->last_store.reg      = r;
+	tctx->last_store.size     = size;
+}
+
+// Load of the value stored by the previous instruction is replaced by register move or removed completely. Returns
+// true in case the load was handled.
+bool forward_stored_value(struct thread_context *tctx, u8 r, u8 base, s32 offset, usize size) {
+	if (tctx->last_store.position == 0 || tctx->last_store.position != get_position(tctx, SECTION_TEXT)) return false;
+	if (tctx->last_store.base != base || tctx->last_store.offset != offset || tctx->last_store.size != size) return false;
+	// 32bit load clears upper half of the register.
+	if (r != tctx->last_store.reg || size == 4) mov_rr(tctx, r, tctx->last_store.reg, size);
+	return true;
+}
+
+// Jump to the block generated immediately after is removed.
+static void remove_jump_to_next_block(struct thread_context *tctx, struct mir_instr_block *block) {
+	const u32 position = get_position(tctx, SECTION_TEXT);
+	if (!arrlenu(tctx->local_patches) || position < 5) return;
+	struct sym_patch *patch = &arrlast(tctx->local_patches);
+	if (patch->instr != &block->base || patch->position != position - sizeof(s32)) return;
+	if (tctx->text[position - 5] != 0xE9) return; // Not unconditional jump.
+	arrsetlen(tctx->text, position - 5);
+	arrpop(tctx->local_patches);
+}
+
 static inline u64 add_value(struct thread_context *tctx, struct x64_value value) {
 	arrput(tctx->values, value);
 	return arrlenu(tctx->values); // +1
@@ -341,6 +607,7 @@ u32 add_sym(struct thread_context *tctx, s32 section_number, u32 offset, str_t l
 		memcpy(sym.N.ShortName, linkage_name.ptr, linkage_name.len);
 	}
 	arrput(tctx->syms, sym);
+	if (section_number == SECTION_TEXT) tctx->last_store.position = 0;
 	return offset;
 }
 
@@ -392,23 +659,28 @@ static inline usize get_stack_allocation_size(struct thread_context *tctx) {
 	return *(u32 *)(tctx->text + tctx->stack.alloc_value_offset);
 }
 
+// Returns RBP relative offset of the allocated memory.
 static inline s32 allocate_stack_memory(struct thread_context *tctx, usize size) {
 	const usize allocated = get_stack_allocation_size(tctx);
-	if (allocated + size > 0xFFFFFFFF) {
+	if (allocated + size > 0x7FFFFFFF) {
 		babort("Stack allocation is too big!");
 	}
 	(*(u32 *)(tctx->text + tctx->stack.alloc_value_offset)) += (u32)size;
-	return (s32)allocated;
+	return -(s32)(allocated + size);
 }
 
 static void allocate_stack_variables(struct thread_context *tctx, struct mir_fn *fn) {
-	usize top = 0;
+	// Some memory might be already allocated in the prologue.
+	const usize base = get_stack_allocation_size(tctx);
+	usize       top  = base;
 
 	for (usize i = 0; i < arrlenu(fn->variables); ++i) {
 		struct mir_var *var = fn->variables[i];
 		bassert(var);
 		if (isnotflag(var->iflags, MIR_VAR_EMIT_LLVM)) continue;
 
+		if (var->backend_value) continue; // Allocated in register.
+
 		struct mir_type *var_type = var->value.type;
 		bassert(var_type);
 
@@ -425,7 +697,418 @@ static void allocate_stack_variables(struct thread_context *tctx, struct mir_fn
 		top += var_size;
 	}
 
-	allocate_stack_memory(tctx, top);
+	allocate_stack_memory(tctx, top - base);
+}
+
+//
+// Local variable register allocation
+//
+// Scalar local variables which address is never taken are allocated into callee-saved registers using linear scan over
+// live intervals. The intervals are computed from per-block liveness, so they are valid for any order of blocks
+// emission. Each variable keeps its register for the whole interval, variables not fitting into registers stay in the
+// stack memory.
+//
+
+enum operand_use {
+	OPERAND_VALUE,
+	OPERAND_LOAD_SRC,
+	OPERAND_STORE_DEST,
+};
+
+enum liveness_set {
+	LIVENESS_GEN,
+	LIVENESS_KILL,
+	LIVENESS_IN,
+	LIVENESS_OUT,
+	LIVENESS_SET_COUNT,
+};
+
+static struct mir_var *get_referenced_local_var(struct mir_instr *instr) {
+	struct mir_var *var = NULL;
+	if (instr->kind == MIR_INSTR_DECL_REF) {
+		struct scope_entry *entry = ((struct mir_instr_decl_ref *)instr)->scope_entry;
+		if (entry && entry->kind == SCOPE_ENTRY_VAR) var = entry->as.var;
+	} else if (instr->kind == MIR_INSTR_DECL_DIRECT_REF) {
+		struct mir_instr *ref = ((struct mir_instr_decl_direct_ref *)instr)->ref;
+		if (ref && ref->kind == MIR_INSTR_DECL_VAR) var = ((struct mir_instr_decl_var *)ref)->var;
+	}
+	if (var && isflag(var->iflags, MIR_VAR_GLOBAL)) return NULL;
+	return var;
+}
+
+static inline struct var_interval *lookup_var_interval(struct thread_context *tctx, struct mir_var *var) {
+	if (!var) return NULL;
+	const s32 i = tbl_lookup_index(tctx->regalloc.var_index, var);
+	if (i == -1) return NULL;
+	return &tctx->regalloc.intervals[tctx->regalloc.var_index[i].index];
+}
+
+static inline u64 *get_liveness_set(struct thread_context *tctx, enum liveness_set set, s32 block_index) {
+	const usize words = (arrlenu(tctx->regalloc.intervals) + 63) / 64;
+	const usize block = (usize)block_index * LIVENESS_SET_COUNT + set;
+	return &tctx->regalloc.sets[block * words];
+}
+
+static inline void extend_var_interval(struct var_interval *interval, s32 position) {
+	interval->start = MIN(interval->start, position);
+	interval->end   = MAX(interval->end, position);
+}
+
+static inline void escape_var(struct thread_context *tctx, struct mir_var *var) {
+	struct var_interval *interval = lookup_var_interval(tctx, var);
+	if (interval) interval->is_escaping = true;
+}
+
+static void record_var_access(struct thread_context *tctx, struct var_interval *interval, s32 block_index, s32 position, bool is_def) {
+	const usize v = interval - tctx->regalloc.intervals;
+	extend_var_interval(interval, position);
+	u64 *kill = get_liveness_set(tctx, LIVENESS_KILL, block_index);
+	if (is_def) {
+		kill[v / 64] |= 1ull << (v % 64);
+	} else if ((kill[v / 64] & (1ull << (v % 64))) == 0) {
+		get_liveness_set(tctx, LIVENESS_GEN, block_index)[v / 64] |= 1ull << (v % 64);
+	}
+}
+
+static void record_operand(struct thread_context *tctx, struct mir_instr *operand, enum operand_use use, s32 block_index, s32 position) {
+	if (!operand) return;
+	struct var_interval *interval = lookup_var_interval(tctx, get_referenced_local_var(operand));
+	if (interval) {
+		switch (use) {
+		case OPERAND_LOAD_SRC:
+			record_var_access(tctx, interval, block_index, position, false);
+			break;
+		case OPERAND_STORE_DEST:
+			record_var_access(tctx, interval, block_index, position, true);
+			break;
+		default:
+			interval->is_escaping = true;
+		}
+		return;
+	}
+
+	// Loads are emitted lazily by their users, so the variable is read at the position of the user.
+	if (operand->kind == MIR_INSTR_LOAD) {
+		interval = lookup_var_interval(tctx, get_referenced_local_var(((struct mir_instr_load *)operand)->src));
+		if (interval) record_var_access(tctx, interval, block_index, position, false);
+	}
+}
+
+static inline void record_operands(struct thread_context *tctx, mir_instrs_t *operands, s32 block_index, s32 position) {
+	for (usize i = 0; i < sarrlenu(operands); ++i) {
+		record_operand(tctx, sarrpeek(operands, i), OPERAND_VALUE, block_index, position);
+	}
+}
+
+// Returns false in case the instruction is not supported by the analysis.
+static bool record_instr_operands(struct thread_context *tctx, struct mir_instr *instr, s32 block_index, s32 position) {
+	if (!mir_type_has_llvm_representation(instr->value.type)) return true;
+
+	switch (instr->kind) {
+	case MIR_INSTR_LOAD:
+		record_operand(tctx, ((struct mir_instr_load *)instr)->src, OPERAND_LOAD_SRC, block_index, position);
+		break;
+	case MIR_INSTR_STORE: {
+		struct mir_instr_store *store = (struct mir_instr_store *)instr;
+		record_operand(tctx, store->src, OPERAND_VALUE, block_index, position);
+		if (store->src->kind == MIR_INSTR_COMPOUND) escape_var(tctx, get_referenced_local_var(store->dest));
+		record_operand(tctx, store->dest, OPERAND_STORE_DEST, block_index, position);
+		break;
+	}
+	case MIR_INSTR_DECL_VAR: {
+		struct mir_instr_decl_var *decl = (struct mir_instr_decl_var *)instr;
+		if (!decl->init) break;
+		record_operand(tctx, decl->init, OPERAND_VALUE, block_index, position);
+		struct var_interval *interval = lookup_var_interval(tctx, decl->var);
+		if (!interval) break;
+		if (decl->init->kind == MIR_INSTR_COMPOUND) {
+			interval->is_escaping = true;
+		} else {
+			record_var_access(tctx, interval, block_index, position, true);
+		}
+		break;
+	}
+	case MIR_INSTR_BINOP:
+		record_operand(tctx, ((struct mir_instr_binop *)instr)->lhs, OPERAND_VALUE, block_index, position);
+		record_operand(tctx, ((struct mir_instr_binop *)instr)->rhs, OPERAND_VALUE, block_index, position);
+		break;
+	case MIR_INSTR_UNOP:
+		record_operand(tctx, ((struct mir_instr_unop *)instr)->expr, OPERAND_VALUE, block_index, position);
+		break;
+	case MIR_INSTR_CAST:
+		record_operand(tctx, ((struct mir_instr_cast *)instr)->expr, OPERAND_VALUE, block_index, position);
+		break;
+	case MIR_INSTR_ADDROF:
+		record_operand(tctx, ((struct mir_instr_addrof *)instr)->src, OPERAND_VALUE, block_index, position);
+		break;
+	case MIR_INSTR_ELEM_PTR:
+		record_operand(tctx, ((struct mir_instr_elem_ptr *)instr)->arr_ptr, OPERAND_VALUE, block_index, position);
+		record_operand(tctx, ((struct mir_instr_elem_ptr *)instr)->index, OPERAND_VALUE, block_index, position);
+		break;
+	case MIR_INSTR_MEMBER_PTR:
+		record_operand(tctx, ((struct mir_instr_member_ptr *)instr)->target_ptr, OPERAND_VALUE, block_index, position);
+		break;
+	case MIR_INSTR_CALL: {
+		struct mir_instr_call *call = (struct mir_instr_call *)instr;
+		record_operand(tctx, call->callee, OPERAND_VALUE, block_index, position);
+		record_operands(tctx, call->args, block_index, position);
+		if (call->tmp_var) escape_var(tctx, ((struct mir_instr_decl_var *)call->tmp_var)->var);
+		break;
+	}
+	case MIR_INSTR_RET:
+		record_operand(tctx, ((struct mir_instr_ret *)instr)->value, OPERAND_VALUE, block_index, position);
+		break;
+	case MIR_INSTR_COND_BR:
+		record_operand(tctx, ((struct mir_instr_cond_br *)instr)->cond, OPERAND_VALUE, block_index, position);
+		break;
+	case MIR_INSTR_SWITCH:
+		record_operand(tctx, ((struct mir_instr_switch *)instr)->value, OPERAND_VALUE, block_index, position);
+		break;
+	case MIR_INSTR_COMPOUND: {
+		struct mir_instr_compound *cmp = (struct mir_instr_compound *)instr;
+		record_operands(tctx, cmp->values, block_index, position);
+		if (cmp->tmp_var) escape_var(tctx, cmp->tmp_var);
+		break;
+	}
+	case MIR_INSTR_VARGS: {
+		struct mir_instr_vargs *vargs = (struct mir_instr_vargs *)instr;
+		record_operands(tctx, vargs->values, block_index, position);
+		if (vargs->arr_tmp) escape_var(tctx, vargs->arr_tmp);
+		if (vargs->vargs_tmp) escape_var(tctx, vargs->vargs_tmp);
+		break;
+	}
+	case MIR_INSTR_TOANY: {
+		struct mir_instr_to_any *toany = (struct mir_instr_to_any *)instr;
+		record_operand(tctx, toany->expr, OPERAND_VALUE, block_index, position);
+		if (toany->tmp) escape_var(tctx, toany->tmp);
+		if (toany->expr_tmp) escape_var(tctx, toany->expr_tmp);
+		break;
+	}
+	case MIR_INSTR_UNROLL:
+		record_operand(tctx, ((struct mir_instr_unroll *)instr)->src, OPERAND_VALUE, block_index, position);
+		record_operand(tctx, ((struct mir_instr_unroll *)instr)->prev, OPERAND_VALUE, block_index, position);
+		break;
+	case MIR_INSTR_CONST: {
+		struct mir_instr_const *cnst = (struct mir_instr_const *)instr;
+		if (cnst->tmp_var) escape_var(tctx, ((struct mir_instr_decl_var *)cnst->tmp_var)->var);
+		break;
+	}
+	case MIR_INSTR_ARG:
+	case MIR_INSTR_BR:
+	case MIR_INSTR_CALL_LOC:
+	case MIR_INSTR_TYPE_INFO:
+	case MIR_INSTR_DECL_REF:
+	case MIR_INSTR_DECL_DIRECT_REF:
+	case MIR_INSTR_UNREACHABLE:
+		break;
+	default:
+		return instr->value.is_comptime;
+	}
+	return true;
+}
+
+static inline s32 get_block_index(struct thread_context *tctx, struct mir_instr_block *block) {
+	const s32 i = tbl_lookup_index(tctx->regalloc.block_index, block);
+	bassert(i != -1 && "Block is not part of the function!");
+	return tctx->regalloc.block_index[i].index;
+}
+
+// Merge live-in set of the successor into live-out set of the block.
+static inline void merge_successor_liveness(struct thread_context *tctx, u64 *out, struct mir_instr_block *successor, usize words) {
+	const u64 *in = get_liveness_set(tctx, LIVENESS_IN, get_block_index(tctx, successor));
+	for (usize w = 0; w < words; ++w) {
+		out[w] |= in[w];
+	}
+}
+
+static bool compute_var_liveness(struct thread_context *tctx) {
+	const usize words       = (arrlenu(tctx->regalloc.intervals) + 63) / 64;
+	const s32   block_count = (s32)arrlenu(tctx->regalloc.blocks);
+
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (s32 b = block_count - 1; b >= 0; --b) {
+			struct mir_instr_block *block    = tctx->regalloc.blocks[b];
+			struct mir_instr       *terminal = block->terminal;
+			u64                    *out      = get_liveness_set(tctx, LIVENESS_OUT, b);
+
+			switch (terminal->kind) {
+			case MIR_INSTR_BR:
+				merge_successor_liveness(tctx, out, ((struct mir_instr_br *)terminal)->then_block, words);
+				break;
+			case MIR_INSTR_COND_BR:
+				merge_successor_liveness(tctx, out, ((struct mir_instr_cond_br *)terminal)->then_block, words);
+				merge_successor_liveness(tctx, out, ((struct mir_instr_cond_br *)terminal)->else_block, words);
+				break;
+			case MIR_INSTR_SWITCH: {
+				struct mir_instr_switch *sw = (struct mir_instr_switch *)terminal;
+				for (usize i = 0; i < sarrlenu(sw->cases); ++i) {
+					merge_successor_liveness(tctx, out, sarrpeek(sw->cases, i).block, words);
+				}
+				merge_successor_liveness(tctx, out, sw->default_block, words);
+				break;
+			}
+			case MIR_INSTR_RET:
+			case MIR_INSTR_UNREACHABLE:
+				break;
+			default:
+				return false;
+			}
+
+			const u64 *gen  = get_liveness_set(tctx, LIVENESS_GEN, b);
+			const u64 *kill = get_liveness_set(tctx, LIVENESS_KILL, b);
+			u64       *in   = get_liveness_set(tctx, LIVENESS_IN, b);
+			for (usize w = 0; w < words; ++w) {
+				const u64 v = gen[w] | (out[w] & ~kill[w]);
+				if (v != in[w]) {
+					in[w]   = v;
+					changed = true;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// Assign callee-saved registers to local variables of the function. Must be called in the function prologue before
+// stack variables are allocated.
+static void allocate_variable_registers(struct thread_context *tctx, struct mir_fn *fn) {
+	zone();
+	tctx->regalloc.saved_num = 0;
+	tbl_clear(tctx->regalloc.var_index);
+	tbl_clear(tctx->regalloc.block_index);
+	arrsetlen(tctx->regalloc.blocks, 0);
+	arrsetlen(tctx->regalloc.intervals, 0);
+	arrsetlen(tctx->regalloc.block_bounds, 0);
+	arrsetlen(tctx->regalloc.sorted, 0);
+
+	// Collect candidates.
+	for (usize i = 0; i < arrlenu(fn->variables); ++i) {
+		struct mir_var *var = fn->variables[i];
+		if (isnotflag(var->iflags, MIR_VAR_EMIT_LLVM) || isflag(var->iflags, MIR_VAR_GLOBAL)) continue;
+		if (get_type_kind(var->value.type) != X64_NUMBER || var->value.type->store_size_bytes > 8) continue;
+		if (fn->ret_tmp && ((struct mir_instr_decl_var *)fn->ret_tmp)->var == var) continue;
+
+		struct index_entry entry = {.hash = var, .index = (s32)arrlen(tctx->regalloc.intervals)};
+		tbl_insert(tctx->regalloc.var_index, entry);
+		arrput(tctx->regalloc.intervals, ((struct var_interval){.var = var, .start = INT32_MAX, .end = -1, .reg = INVALID_REGISTER}));
+	}
+	if (!arrlenu(tctx->regalloc.intervals)) return_zone();
+
+	for (struct mir_instr *block = &fn->entry_block->base; block; block = block->next) {
+		struct index_entry entry = {.hash = block, .index = (s32)arrlen(tctx->regalloc.blocks)};
+		tbl_insert(tctx->regalloc.block_index, entry);
+		arrput(tctx->regalloc.blocks, (struct mir_instr_block *)block);
+	}
+
+	const usize words = (arrlenu(tctx->regalloc.intervals) + 63) / 64;
+	arrsetlen(tctx->regalloc.sets, words * LIVENESS_SET_COUNT * arrlenu(tctx->regalloc.blocks));
+	bl_zeromem(tctx->regalloc.sets, arrlenu(tctx->regalloc.sets) * sizeof(u64));
+
+	// Linearize instructions and record variable accesses.
+	s32 position = 0;
+	for (s32 b = 0; b < (s32)arrlenu(tctx->regalloc.blocks); ++b) {
+		struct mir_instr_block *block = tctx->regalloc.blocks[b];
+		if (!block->terminal) return_zone();
+
+		arrput(tctx->regalloc.block_bounds, position);
+		for (struct mir_instr *instr = block->entry_instr; instr; instr = instr->next) {
+			if (!record_instr_operands(tctx, instr, b, position++)) return_zone();
+		}
+		arrput(tctx->regalloc.block_bounds, position);
+	}
+
+	if (!compute_var_liveness(tctx)) return_zone();
+
+	// Extend intervals over blocks where the variable is live on the block boundary.
+	for (s32 b = 0; b < (s32)arrlenu(tctx->regalloc.blocks); ++b) {
+		const u64 *in  = get_liveness_set(tctx, LIVENESS_IN, b);
+		const u64 *out = get_liveness_set(tctx, LIVENESS_OUT, b);
+		for (usize v = 0; v < arrlenu(tctx->regalloc.intervals); ++v) {
+			const u64 bit = 1ull << (v % 64);
+			if (in[v / 64] & bit) extend_var_interval(&tctx->regalloc.intervals[v], tctx->regalloc.block_bounds[b * 2]);
+			if (out[v / 64] & bit) extend_var_interval(&tctx->regalloc.intervals[v], tctx->regalloc.block_bounds[b * 2 + 1]);
+		}
+	}
+
+	for (s32 v = 0; v < (s32)arrlen(tctx->regalloc.intervals); ++v) {
+		struct var_interval *interval = &tctx->regalloc.intervals[v];
+		if (interval->is_escaping || interval->end < 0) continue;
+		arrput(tctx->regalloc.sorted, v);
+	}
+	// Sort by interval start; insertion sort is fine, candidates are already mostly ordered by declaration.
+	for (usize i = 1; i < arrlenu(tctx->regalloc.sorted); ++i) {
+		const s32 v = tctx->regalloc.sorted[i];
+		usize     j = i;
+		for (; j > 0 && tctx->regalloc.intervals[tctx->regalloc.sorted[j - 1]].start > tctx->regalloc.intervals[v].start; --j) {
+			tctx->regalloc.sorted[j] = tctx->regalloc.sorted[j - 1];
+		}
+		tctx->regalloc.sorted[j] = v;
+	}
+
+	// Linear scan; when there is no free register, the interval ending last stays in memory.
+	s32 active[static_arrlenu(CALLEE_SAVED)];
+	s32 active_num = 0;
+	s32 free_mask  = (1 << static_arrlenu(CALLEE_SAVED)) - 1;
+	s32 used_mask  = 0;
+
+	for (usize i = 0; i < arrlenu(tctx->regalloc.sorted); ++i) {
+		struct var_interval *current = &tctx->regalloc.intervals[tctx->regalloc.sorted[i]];
+
+		// Expire old intervals.
+		for (s32 j = 0; j < active_num;) {
+			struct var_interval *interval = &tctx->regalloc.intervals[active[j]];
+			if (interval->end >= current->start) {
+				++j;
+				continue;
+			}
+			for (s32 r = 0; r < (s32)static_arrlenu(CALLEE_SAVED); ++r) {
+				if (CALLEE_SAVED[r] == interval->reg) free_mask |= 1 << r;
+			}
+			active[j] = active[--active_num];
+		}
+
+		if (free_mask) {
+			s32 r = 0;
+			while ((free_mask & (1 << r)) == 0)
+				++r;
+			free_mask &= ~(1 << r);
+			used_mask |= 1 << r;
+			current->reg         = CALLEE_SAVED[r];
+			active[active_num++] = tctx->regalloc.sorted[i];
+			continue;
+		}
+
+		s32 furthest = 0;
+		for (s32 j = 1; j < active_num; ++j) {
+			if (tctx->regalloc.intervals[active[j]].end > tctx->regalloc.intervals[active[furthest]].end) furthest = j;
+		}
+		struct var_interval *spilled = &tctx->regalloc.intervals[active[furthest]];
+		if (spilled->end > current->end) {
+			current->reg     = spilled->reg;
+			spilled->reg     = INVALID_REGISTER;
+			active[furthest] = tctx->regalloc.sorted[i];
+		}
+	}
+
+	for (usize v = 0; v < arrlenu(tctx->regalloc.intervals); ++v) {
+		struct var_interval *interval = &tctx->regalloc.intervals[v];
+		if (interval->reg == INVALID_REGISTER) continue;
+		interval->var->backend_value = add_value(tctx, (struct x64_value){.kind = VARIABLE_REGISTER, .reg = interval->reg});
+	}
+
+	// Save used callee-saved registers.
+	for (s32 r = 0; r < (s32)static_arrlenu(CALLEE_SAVED); ++r) {
+		if ((used_mask & (1 << r)) == 0) continue;
+		const s32 offset = allocate_stack_memory(tctx, 8);
+		mov_mr(tctx, RBP, offset, CALLEE_SAVED[r], 8);
+		tctx->regalloc.saved_registers[tctx->regalloc.saved_num] = CALLEE_SAVED[r];
+		tctx->regalloc.saved_offsets[tctx->regalloc.saved_num]   = offset;
+		++tctx->regalloc.saved_num;
+	}
+
+	return_zone();
 }
 
 // Tries to find some free registers.
@@ -494,8 +1177,7 @@ static enum x64_register spill(struct thread_context *tctx, enum x64_register re
 		tctx->register_table[dest_reg] = vi;
 	} else {
 		// Spill to memory.
-		const s32 top    = allocate_stack_memory(tctx, 8);
-		const s32 offset = -top;
+		const s32 offset = allocate_stack_memory(tctx, 8);
 		mov_mr(tctx, RBP, offset, reg, 8);
 		spill_value->kind   = OFFSET;
 		spill_value->offset = offset;
@@ -629,18 +1311,18 @@ static void emit_string_literal(struct context *ctx, struct thread_context *tctx
 }
 
 static void emit_call_memcpy(struct thread_context *tctx, const u64 vi_dest, const u64 vi_src, s64 size) {
-	const enum x64_register excluded[6] = {RAX, RCX, RDX, R8, R9, R10};
+	const enum x64_register excluded[] = {RAX, RCX, RDX, RSI, RDI, R8, R9, R10};
 
 	// dest
 	if (vi_dest != NO_VALUE) {
 		switch (peek(vi_dest).kind) {
 		case OFFSET:
-			lea_rm(tctx, spill(tctx, RCX, excluded, static_arrlenu(excluded)), RBP, peek_offset(vi_dest), 8);
+			lea_rm(tctx, spill(tctx, CALL_ABI[0], excluded, static_arrlenu(excluded)), RBP, peek_offset(vi_dest), 8);
 			break;
 		case REGISTER_ADDRESS: {
 			const enum x64_register reg = peek_register(vi_dest);
-			if (reg != RCX) {
-				mov_rr(tctx, spill(tctx, RCX, excluded, static_arrlenu(excluded)), reg, 8);
+			if (reg != CALL_ABI[0]) {
+				mov_rr(tctx, spill(tctx, CALL_ABI[0], excluded, static_arrlenu(excluded)), reg, 8);
 			}
 			break;
 		}
@@ -653,12 +1335,12 @@ static void emit_call_memcpy(struct thread_context *tctx, const u64 vi_dest, con
 	if (vi_src != NO_VALUE) {
 		switch (peek(vi_src).kind) {
 		case RELOCATION:
-			lea_rm_indirect(tctx, spill(tctx, RDX, excluded, static_arrlenu(excluded)), 0, 8);
+			lea_rm_indirect(tctx, spill(tctx, CALL_ABI[1], excluded, static_arrlenu(excluded)), 0, 8);
 			const u32 reloc_src_position = get_position(tctx, SECTION_TEXT) - sizeof(s32);
 			add_patch(tctx, peek_relocation(vi_src).hash, reloc_src_position, IMAGE_REL_AMD64_REL32, SECTION_TEXT);
 			break;
 		case OFFSET:
-			lea_rm(tctx, spill(tctx, RDX, excluded, static_arrlenu(excluded)), RBP, peek_offset(vi_src), 8);
+			lea_rm(tctx, spill(tctx, CALL_ABI[1], excluded, static_arrlenu(excluded)), RBP, peek_offset(vi_src), 8);
 			break;
 		case REGISTER:
 			// We don't expect memcpy to be used to copy value from gerister, however it might be used for composit
@@ -666,8 +1348,8 @@ static void emit_call_memcpy(struct thread_context *tctx, const u64 vi_dest, con
 			// manipulated using pointers, not actual values.
 		case REGISTER_ADDRESS: {
 			const enum x64_register reg = peek_register(vi_src);
-			if (reg != RDX) {
-				mov_rr(tctx, spill(tctx, RDX, excluded, static_arrlenu(excluded)), reg, 8);
+			if (reg != CALL_ABI[1]) {
+				mov_rr(tctx, spill(tctx, CALL_ABI[1], excluded, static_arrlenu(excluded)), reg, 8);
 			}
 			break;
 		}
@@ -677,29 +1359,29 @@ static void emit_call_memcpy(struct thread_context *tctx, const u64 vi_dest, con
 	}
 
 	// size
-	mov_ri(tctx, spill(tctx, R8, excluded, static_arrlenu(excluded)), size, 8);
+	mov_ri(tctx, spill(tctx, CALL_ABI[2], excluded, static_arrlenu(excluded)), size, 8);
 
-	sub_ri(tctx, RSP, 0x20, 8);
+	if (SHADOW_SPACE_SIZE) sub_ri(tctx, RSP, SHADOW_SPACE_SIZE, 8);
 	call_relative_i32(tctx, 0);
 	const u32 reloc_call_position = get_position(tctx, SECTION_TEXT) - sizeof(s32);
 	add_patch(tctx, MEMCPY_BUILTIN_HASH, reloc_call_position, IMAGE_REL_AMD64_REL32, SECTION_TEXT);
-	add_ri(tctx, RSP, 0x20, 8);
+	if (SHADOW_SPACE_SIZE) add_ri(tctx, RSP, SHADOW_SPACE_SIZE, 8);
 }
 
 static void emit_call_memset(struct thread_context *tctx, const u64 vi_dest, s32 v, s64 size) {
-	const enum x64_register excluded[6] = {RAX, RCX, RDX, R8, R9, R10};
+	const enum x64_register excluded[] = {RAX, RCX, RDX, RSI, RDI, R8, R9, R10};
 
 	bassert(peek(vi_dest).kind == OFFSET);
 	const u32 dest_offset = peek_offset(vi_dest);
-	lea_rm(tctx, spill(tctx, RCX, excluded, static_arrlenu(excluded)), RBP, dest_offset, 8);
-	mov_ri(tctx, spill(tctx, RDX, excluded, static_arrlenu(excluded)), v, 4);
-	mov_ri(tctx, spill(tctx, R8, excluded, static_arrlenu(excluded)), size, 8);
+	lea_rm(tctx, spill(tctx, CALL_ABI[0], excluded, static_arrlenu(excluded)), RBP, dest_offset, 8);
+	mov_ri(tctx, spill(tctx, CALL_ABI[1], excluded, static_arrlenu(excluded)), v, 4);
+	mov_ri(tctx, spill(tctx, CALL_ABI[2], excluded, static_arrlenu(excluded)), size, 8);
 
-	sub_ri(tctx, RSP, 0x20, 8);
+	if (SHADOW_SPACE_SIZE) sub_ri(tctx, RSP, SHADOW_SPACE_SIZE, 8);
 	call_relative_i32(tctx, 0);
 	const u32 reloc_call_position = get_position(tctx, SECTION_TEXT) - sizeof(s32);
 	add_patch(tctx, MEMSET_BUILTIN_HASH, reloc_call_position, IMAGE_REL_AMD64_REL32, SECTION_TEXT);
-	add_ri(tctx, RSP, 0x20, 8);
+	if (SHADOW_SPACE_SIZE) add_ri(tctx, RSP, SHADOW_SPACE_SIZE, 8);
 }
 
 // General move of any values.
@@ -751,6 +1433,27 @@ static void emit_mov_values(struct thread_context *tctx, struct mir_type *type,
 	case op_combined(OP_REGISTER_ADDRESS_NUMBER, OP_IMMEDIATE_NUMBER):
 		mov_mi(tctx, peek_register_address(vi_dest).reg, peek_register_address(vi_dest).offset, peek_immediate(vi_src), value_size);
 		break;
+	case op_combined(OP_VARIABLE_REGISTER_NUMBER, OP_IMMEDIATE_NUMBER):
+		mov_ri(tctx, peek_variable_register(vi_dest), peek_immediate(vi_src), value_size);
+		break;
+	case op_combined(OP_VARIABLE_REGISTER_NUMBER, OP_REGISTER_NUMBER):
+		mov_rr(tctx, peek_variable_register(vi_dest), peek_register(vi_src), value_size);
+		break;
+	case op_combined(OP_VARIABLE_REGISTER_NUMBER, OP_VARIABLE_REGISTER_NUMBER):
+		mov_rr(tctx, peek_variable_register(vi_dest), peek_variable_register(vi_src), value_size);
+		break;
+	case op_combined(OP_VARIABLE_REGISTER_NUMBER, OP_OFFSET_NUMBER):
+		mov_rm(tctx, peek_variable_register(vi_dest), RBP, peek_offset(vi_src), value_size);
+		break;
+	case op_combined(OP_VARIABLE_REGISTER_NUMBER, OP_RELOCATION_NUMBER): {
+		mov_rm_indirect(tctx, peek_variable_register(vi_dest), peek_relocation(vi_src).offset, value_size);
+		const u32 reloc_position = get_position(tctx, SECTION_TEXT) - sizeof(s32);
+		add_patch(tctx, peek_relocation(vi_src).hash, reloc_position, IMAGE_REL_AMD64_REL32, SECTION_TEXT);
+		break;
+	}
+	case op_combined(OP_OFFSET_NUMBER, OP_VARIABLE_REGISTER_NUMBER):
+		mov_mr(tctx, RBP, peek_offset(vi_dest), peek_variable_register(vi_src), value_size);
+		break;
 
 	default:
 		babort("Unhandled operation kind.");
@@ -786,6 +1489,9 @@ static void emit_load_to_register(struct thread_context *tctx, struct mir_instr
 		mov_rm(tctx, reg, peek_register_address(vi_src).reg, peek_register_address(vi_src).offset, value_size);
 		break;
 	}
+	case OP_VARIABLE_REGISTER_NUMBER:
+		mov_rr(tctx, reg, peek_variable_register(vi_src), value_size);
+		break;
 	case OP_RELOCATION_NUMBER: {
 		mov_rm_indirect(tctx, reg, peek_relocation(vi_src).offset, value_size);
 		const u32 reloc_position = get_position(tctx, SECTION_TEXT) - sizeof(s32);
@@ -941,9 +1647,9 @@ static void emit_local_compound(struct context *ctx, struct thread_context *tctx
 			mov_mr(tctx, RBP, dest_value_offset, peek_register(vi), value_size);
 			break;
 		case OP_RELOCATION_COMPOSIT: {
-			// Destination goes to RCX.
-			const enum x64_register excluded[6] = {RAX, RCX, RDX, R8, R9, R10};
-			lea_rm(tctx, spill(tctx, RCX, excluded, static_arrlenu(excluded)), RBP, dest_value_offset, 8);
+			// Destination goes to the first argument register.
+			const enum x64_register excluded[] = {RAX, RCX, RDX, RSI, RDI, R8, R9, R10};
+			lea_rm(tctx, spill(tctx, CALL_ABI[0], excluded, static_arrlenu(excluded)), RBP, dest_value_offset, 8);
 			emit_call_memcpy(tctx, NO_VALUE, vi, value_size);
 			break;
 		}
@@ -972,6 +1678,38 @@ static inline void emit_naked_local_compound(struct context *ctx, struct thread_
 	set_value(tctx, instr, (struct x64_value){.kind = OFFSET, .offset = peek_offset(vi_tmp)});
 }
 
+// Returns register containing address of the composite call argument value. The register is not reserved in case the
+// value is not register based, so it must be used immediately.
+static enum x64_register emit_composit_arg_address(struct context *ctx, struct thread_context *tctx, struct mir_instr *instr, const enum x64_register exclude[], s32 exclude_num) {
+	if (instr->kind == MIR_INSTR_LOAD) {
+		emit_load_to_register(tctx, instr, get_temporary_register(tctx, exclude, exclude_num));
+	} else if (instr->kind == MIR_INSTR_COMPOUND) {
+		emit_naked_local_compound(ctx, tctx, instr);
+	}
+
+	const u64 vi = get_value(tctx, instr);
+	switch (peek(vi).kind) {
+	case REGISTER:
+	case REGISTER_ADDRESS:
+		return peek_register(vi);
+	case OFFSET: {
+		const enum x64_register reg = get_temporary_register(tctx, exclude, exclude_num);
+		lea_rm(tctx, reg, RBP, peek_offset(vi), 8);
+		return reg;
+	}
+	case RELOCATION: {
+		const enum x64_register reg = get_temporary_register(tctx, exclude, exclude_num);
+		lea_rm_indirect(tctx, reg, peek_relocation(vi).offset, 8);
+		const u32 reloc_position = get_position(tctx, SECTION_TEXT) - sizeof(s32);
+		add_patch(tctx, peek_relocation(vi).hash, reloc_position, IMAGE_REL_AMD64_REL32, SECTION_TEXT);
+		return reg;
+	}
+	default:
+		BL_UNIMPLEMENTED;
+	}
+	return INVALID_REGISTER;
+}
+
 static hash_t emit_type_info(struct context *ctx, struct thread_context *tctx, struct mir_type *target_type) {
 	struct assembly *assembly = ctx->assembly;
 	// We need to generate symbol name so the type hash cannot be used directly :(
@@ -1059,29 +1797,36 @@ static inline bool is_relational_binop(enum binop_kind op) {
 	}
 }
 
-static u64 emit_relational_binop_jmp(struct thread_context *tctx, enum binop_kind op) {
+// Emits conditional jump taken when the relation does not hold and returns position right after the jump instruction.
+static u64 emit_relational_binop_jmp(struct thread_context *tctx, enum binop_kind op, bool is_short) {
+	enum x64_condition cc;
 	switch (op) {
 	case BINOP_EQ:
-		jne_relative_i32(tctx, 0x0);
+		cc = CC_NE;
 		break;
 	case BINOP_NEQ:
-		je_relative_i32(tctx, 0x0);
+		cc = CC_E;
 		break;
 	case BINOP_LESS:
-		jge_relative_i32(tctx, 0x0);
+		cc = CC_GE;
 		break;
 	case BINOP_GREATER:
-		jle_relative_i32(tctx, 0x0);
+		cc = CC_LE;
 		break;
 	case BINOP_LESS_EQ:
-		jg_relative_i32(tctx, 0x0);
+		cc = CC_G;
 		break;
 	case BINOP_GREATER_EQ:
-		jl_relative_i32(tctx, 0x0);
+		cc = CC_L;
 		break;
 	default:
 		babort("Binary operation is not relational.");
 	}
+	if (is_short) {
+		jcc_relative_i8(tctx, cc, 0x0);
+	} else {
+		jcc_relative_i32(tctx, cc, 0x0);
+	}
 	return get_position(tctx, SECTION_TEXT);
 }
 
@@ -1167,38 +1912,47 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 		sub_ri(tctx, RSP, 0, 8);
 		tctx->stack.alloc_value_offset = get_position(tctx, SECTION_TEXT) - sizeof(s32);
 
-		s32                      available_register_count = static_arrlenu(CALL_ABI);
-		const enum x64_register *available_registers      = &CALL_ABI[0];
-
 		// Here we reserve registers for all arguments passed into the function. The argument value duplication into the
 		// stack memory might introduce call to memcpy intrinsic; in such a case we need to spill original arguments.
-		s32 reg_index = 0;
-		if (does_function_return_composit(fn->type)) {
-			const enum x64_register reg = available_registers[0];
+		if (does_function_return_composit(ctx, fn->type)) {
+			const enum x64_register reg = CALL_ABI[0];
 			bassert(tctx->register_table[reg] == UNUSED_REGISTER_MAP_VALUE && "Register already used?");
 			struct x64_value value    = {.kind = REGISTER_ADDRESS, .reg_off_addr.reg = reg};
 			tctx->register_table[reg] = (s32)arrlen(tctx->values);
 			arrput(tctx->values, value);
 
 			tctx->current_fn_composit_return_dest = arrlenu(tctx->values);
-			available_registers                   = &CALL_ABI[1]; // Skip RCX
-			available_register_count -= 1;
 		}
 
-		for (usize i = 0; i < sarrlenu(fn->type->data.fn.args) && reg_index < available_register_count; ++i) {
+		for (usize i = 0; i < sarrlenu(fn->type->data.fn.args); ++i) {
 			struct mir_arg *arg = sarrpeek(fn->type->data.fn.args, i);
 			if (isflag(arg->flags, FLAG_COMPTIME)) continue;
 
-			const enum x64_register reg = available_registers[reg_index];
+			struct x64_arg_location loc;
+			get_arg_location(ctx, fn->type, i, &loc);
+			if (!loc.reg_num) continue;
+
+			if (arg->llvm_easgm != LLVM_EASGM_NONE) {
+				// Composite split into registers is stored into the stack memory immediately.
+				const s32 offset = allocate_stack_memory(tctx, loc.reg_num * 8);
+				for (s32 j = 0; j < loc.reg_num; ++j) {
+					mov_mr(tctx, RBP, offset + j * 8, loc.regs[j], 8);
+				}
+				arg->backend_value = add_value(tctx, (struct x64_value){.kind = OFFSET, .offset = offset});
+				continue;
+			}
+
+			const enum x64_register reg = loc.regs[0];
 			bassert(tctx->register_table[reg] == UNUSED_REGISTER_MAP_VALUE && "Register already used?");
 			struct x64_value value    = {.kind = REGISTER, .reg = reg};
 			tctx->register_table[reg] = (s32)arrlen(tctx->values);
 			arrput(tctx->values, value);
 
 			arg->backend_value = arrlenu(tctx->values);
-			++reg_index;
 		}
 
+		allocate_variable_registers(tctx, fn);
+
 		// Generate all blocks in the function body.
 		arrput(tctx->emit_block_queue, fn->entry_block);
 		while (arrlenu(tctx->emit_block_queue)) {
@@ -1248,6 +2002,7 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 			unique_name(ctx, &name, ".", cstr("B"));
 #endif
 
+			remove_jump_to_next_block(tctx, block);
 			block->base.backend_value = add_block(tctx, str_buf_view(name));
 			put_tmp_str(name);
 
@@ -1278,27 +2033,25 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 		struct mir_type *fn_type = fn->type;
 		struct mir_arg  *arg     = sarrpeek(fn_type->data.fn.args, arg_instr->i);
 		bassert(isnotflag(arg->flags, FLAG_COMPTIME) && "Comptime arguments should be evaluated and replaced by constants!");
-		bassert(arg->llvm_easgm == LLVM_EASGM_NONE);
 
 		const enum x64_type_kind type_kind = get_type_kind(arg->type);
-		const s32                index     = arg->llvm_index;
-
-		s32                      available_register_count = static_arrlenu(CALL_ABI);
-		const enum x64_register *available_registers      = &CALL_ABI[0];
 
-		if (does_function_return_composit(fn_type)) {
-			available_registers = &CALL_ABI[1]; // Skip RCX
-			available_register_count -= 1;
-		}
+		struct x64_arg_location loc;
+		get_arg_location(ctx, fn_type, arg_instr->i, &loc);
 
-		if (index < available_register_count) {
+		if (loc.reg_num && arg->llvm_easgm != LLVM_EASGM_NONE) {
+			// Split composite was already stored into the stack memory in the prologue.
+			const u64 vi = get_value(tctx, arg);
+			bassert(peek(vi).kind == OFFSET);
+			set_value(tctx, instr, (struct x64_value){.kind = OFFSET, .offset = peek_offset(vi)});
+		} else if (loc.reg_num) {
 			enum x64_register reg = -1;
 
 			// The argument value might be previously spilled (caused by call to memcpy intrinsic).
 			const u64 vi = get_value(tctx, arg);
 			if (peek(vi).kind != REGISTER) {
 				bassert(peek(vi).kind == OFFSET);
-				reg = spill(tctx, available_registers[index], NULL, 0);
+				reg = spill(tctx, loc.regs[0], NULL, 0);
 				mov_rm(tctx, reg, RBP, peek_offset(vi), 8);
 			} else {
 				reg = peek_register(vi);
@@ -1313,8 +2066,11 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 				set_value(tctx, instr, (struct x64_value){.kind = REGISTER, .reg = reg});
 			}
 		} else {
-			const s32 arg_stack_offset = (index + 2) * 8; // +1 return address pushed by call
-			if (type_kind == X64_COMPOSIT) {
+			const s32 arg_stack_offset = loc.stack_offset + 16; // return address pushed by call + RBP
+			if (loc.is_in_memory) {
+				// Composite value copied by the caller.
+				set_value(tctx, instr, (struct x64_value){.kind = OFFSET, .offset = arg_stack_offset});
+			} else if (type_kind == X64_COMPOSIT) {
 				const enum x64_register reg = get_temporary_register(tctx, CALL_ABI, static_arrlenu(CALL_ABI));
 				mov_rm(tctx, reg, RBP, arg_stack_offset, 8);
 				set_value(tctx, instr, (struct x64_value){.kind = REGISTER_ADDRESS, .reg_off_addr.reg = reg});
@@ -1739,21 +2495,24 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 			bassert(binop->base.value.type->kind == MIR_TYPE_BOOL);
 			str_buf_t name = get_tmp_str();
 
-			const u64 p0 = emit_relational_binop_jmp(tctx, binop->op);
+			// Both branches are short, so we can use short jumps.
+			const u64 p0 = emit_relational_binop_jmp(tctx, binop->op, true);
 
 			mov_ri(tctx, regs[LHS], 1, 8); // Lets set whole register.
-			jmp_relative_i32(tctx, 0);
+			jmp_relative_i8(tctx, 0);
 			const u64 p1 = get_position(tctx, SECTION_TEXT);
 
 			unique_name(ctx, &name, ".", cstr("B"));
 			add_block(tctx, str_buf_view(name));
-			*data_ptr_s32(tctx->text, p0 - sizeof(s32)) = (s32)(get_position(tctx, SECTION_TEXT) - p0);
+			bassert(is_byte_disp((s64)(get_position(tctx, SECTION_TEXT) - p0)));
+			tctx->text[p0 - 1] = (u8)(get_position(tctx, SECTION_TEXT) - p0);
 
 			zero_reg(tctx, regs[LHS], 8);
 
 			unique_name(ctx, &name, ".", cstr("B"));
 			add_block(tctx, str_buf_view(name));
-			*data_ptr_s32(tctx->text, p1 - sizeof(s32)) = (s32)(get_position(tctx, SECTION_TEXT) - p1);
+			bassert(is_byte_disp((s64)(get_position(tctx, SECTION_TEXT) - p1)));
+			tctx->text[p1 - 1] = (u8)(get_position(tctx, SECTION_TEXT) - p1);
 
 			put_tmp_str(name);
 		}
@@ -1784,16 +2543,42 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 				break;
 			}
 			case X64_COMPOSIT:
+				if (is_composit_return_in_registers(ctx, fn->type)) {
+					bassert(value_size < 16);
+					mov_rm(tctx, RAX, RBP, peek_offset(vi_tmp), next_pow_2((u32)MIN(value_size, 8)));
+					if (value_size > 8) {
+						mov_rm(tctx, RDX, RBP, peek_offset(vi_tmp) + 8, next_pow_2((u32)(value_size - 8)));
+					}
+					break;
+				}
 				bassert(tctx->current_fn_composit_return_dest);
 				const u64 vi_dest = tctx->current_fn_composit_return_dest - 1;
+
+				// The hidden return value pointer is expected in RAX after return; we keep a copy in memory since the
+				// value copy might call memcpy.
+				s32 dest_ptr_offset;
+				if (peek(vi_dest).kind == OFFSET) {
+					dest_ptr_offset = peek_offset(vi_dest);
+				} else {
+					bassert(peek(vi_dest).kind == REGISTER_ADDRESS);
+					dest_ptr_offset = allocate_stack_memory(tctx, 8);
+					mov_mr(tctx, RBP, dest_ptr_offset, peek_register_address(vi_dest).reg, 8);
+				}
+
 				emit_mov_values(tctx, ret_type, vi_dest, vi_tmp);
 				release_value(tctx, vi_dest);
+				mov_rm(tctx, RAX, RBP, dest_ptr_offset, 8);
 				break;
 			default:
 				BL_UNIMPLEMENTED;
 			}
 		}
 
+		// Restore callee-saved registers used by variables.
+		for (s32 i = 0; i < tctx->regalloc.saved_num; ++i) {
+			mov_rm(tctx, tctx->regalloc.saved_registers[i], RBP, tctx->regalloc.saved_offsets[i], 8);
+		}
+
 		add_ri(tctx, RSP, 0, 8);
 		tctx->stack.free_value_offset = get_position(tctx, SECTION_TEXT) - sizeof(s32);
 		pop64_r(tctx, RBP);
@@ -1807,6 +2592,14 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 		bassert(then_block);
 
 		if (then_block->base.backend_value) {
+			// Backward jump; use short encoding when possible.
+			const s32 target = (s32)peek(then_block->base.backend_value - 1).address;
+			const s32 offset = target - (s32)(get_position(tctx, SECTION_TEXT) + 2);
+			if (is_byte_disp(offset)) {
+				jmp_relative_i8(tctx, (s8)offset);
+				break;
+			}
+
 			jmp_relative_i32(tctx, 0x0);
 			const u64 position = get_position(tctx, SECTION_TEXT) - sizeof(s32);
 
@@ -1847,13 +2640,13 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 			// Last generated instruction must be cmp.
 			struct mir_instr_binop *cond_binop = (struct mir_instr_binop *)br->cond;
 			bassert(cond_binop->is_condition);
-			patch_position = emit_relational_binop_jmp(tctx, cond_binop->op) - sizeof(s32);
+			patch_position = emit_relational_binop_jmp(tctx, cond_binop->op, false) - sizeof(s32);
 		} else if (br->cond->kind == MIR_INSTR_UNOP) {
 			// Last generated instruction must be cmp.
 			struct mir_instr_unop *cond_unop = (struct mir_instr_unop *)br->cond;
 			switch (cond_unop->op) {
 			case UNOP_NOT:
-				jne_relative_i32(tctx, 0x0);
+				jcc_relative_i32(tctx, CC_NE, 0x0);
 				patch_position = get_position(tctx, SECTION_TEXT) - sizeof(s32);
 				break;
 			default:
@@ -1862,7 +2655,7 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 		} else {
 			// Compare register value with 0 and jump.
 			cmp_ri(tctx, reg, 0, value_size);
-			je_relative_i32(tctx, 0x0);
+			jcc_relative_i32(tctx, CC_E, 0x0);
 			patch_position = get_position(tctx, SECTION_TEXT) - sizeof(s32);
 		}
 
@@ -1886,8 +2679,8 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 	}
 
 	case MIR_INSTR_CALL: {
-		// x64 calling convention:
-		// numbers - RCX, RDX, R8, R9, stack in reverse order
+		// Numbers and pointers to composites are passed in CALL_ABI registers and on the stack, composites might be
+		// split into registers or copied into the stack in case register split is enabled (System V).
 
 		struct mir_instr_call *call = (struct mir_instr_call *)instr;
 		bassert(!mir_is_comptime(&call->base) && "Compile time calls should not be generated into the final binary!");
@@ -1912,40 +2705,30 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 		const u64 vi_callee = get_value(tctx, callee);
 		const s32 arg_num   = (s32)sarrlen(call->args);
 
-		s32                      available_register_count = static_arrlenu(CALL_ABI);
-		const enum x64_register *available_registers      = &CALL_ABI[0];
-
-		usize stack_space = MAX(available_register_count, arg_num) * 8;
+		usize stack_space = (usize)get_arg_location(ctx, callee_type, 0, NULL);
 		if (!is_aligned2(stack_space, 16)) {
 			stack_space = next_aligned2(stack_space, 16);
 		}
 
-		// Allocate shadow space.
+		// Allocate stack argument area.
 		if (stack_space) sub_ri(tctx, RSP, stack_space, 8);
 
-		s32 args_in_register = MIN(available_register_count, arg_num); // Used increase available registers for spill.
-		s32 arg_stack_offset = 0;
-
 		struct mir_type *ret_type    = callee_type->data.fn.ret_type;
 		const bool       does_return = ret_type->kind != MIR_TYPE_VOID;
 
 		s32 ret_value_tmp_offset = 0;
 
-		if (does_return && does_function_return_composit(callee_type)) { // @Performance [travis]: Generate only if result is used?
+		if (does_return && does_function_return_composit(ctx, callee_type)) { // @Performance [travis]: Generate only if result is used?
 			// We have to allocate stack memory for the return value not fitting into RAX.
 
 			const usize value_size = ret_type->store_size_bytes;
 			const usize padding    = next_aligned2(value_size, 16) - value_size; // @Performance [travis]: Do we need this?
 
 			// @Performance [travis]: New allocation for every such call???
-			ret_value_tmp_offset = -allocate_stack_memory(tctx, value_size + padding);
+			ret_value_tmp_offset = allocate_stack_memory(tctx, value_size + padding);
 
-			const enum x64_register reg = spill(tctx, available_registers[0], CALL_ABI, args_in_register);
-			bassert(reg == RCX);
+			const enum x64_register reg = spill(tctx, CALL_ABI[0], CALL_ABI, static_arrlenu(CALL_ABI));
 			lea_rm(tctx, reg, RBP, ret_value_tmp_offset, 8);
-			available_registers = &CALL_ABI[1]; // Skip RCX
-			available_register_count -= 1;
-			args_in_register += 1;
 		}
 
 		for (s32 index = 0; index < arg_num; ++index) {
@@ -1955,15 +2738,44 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 
 			bassert(!isflag(arg->flags, FLAG_COMPTIME));
 			// if (isflag(arg->flags, FLAG_COMPTIME)) continue;
-			bassert(arg->llvm_easgm == LLVM_EASGM_NONE);
 
 			const usize              arg_size  = arg_type->store_size_bytes;
 			const enum x64_type_kind type_kind = get_type_kind(arg_type); // @Cleanup
 
-			if (index < available_register_count) {
+			struct x64_arg_location loc;
+			get_arg_location(ctx, callee_type, index, &loc);
+
+			if (loc.is_in_memory) {
+				// Copy the whole composite into the stack argument area.
+				const enum x64_register data_reg = spill(tctx, RAX, CALL_ABI, static_arrlenu(CALL_ABI));
+				enum x64_register       exclude[static_arrlenu(CALL_ABI) + 1];
+				memcpy(exclude, CALL_ABI, sizeof(CALL_ABI));
+				exclude[static_arrlenu(CALL_ABI)] = data_reg;
+
+				const enum x64_register addr_reg = emit_composit_arg_address(ctx, tctx, arg_instr, exclude, static_arrlenu(exclude));
+				bassert(addr_reg != data_reg);
+				// @Performance: Use memcpy for large values?
+				for (s32 offset = 0; offset < (s32)arg_size; offset += 8) {
+					mov_rm(tctx, data_reg, addr_reg, offset, 8);
+					mov_mr(tctx, RSP, loc.stack_offset + offset, data_reg, 8);
+				}
+			} else if (loc.reg_num && arg->llvm_easgm != LLVM_EASGM_NONE) {
+				// Composite split into registers.
+				for (s32 j = 0; j < loc.reg_num; ++j) {
+					spill(tctx, loc.regs[j], CALL_ABI, static_arrlenu(CALL_ABI));
+				}
+				const enum x64_register addr_reg = emit_composit_arg_address(ctx, tctx, arg_instr, CALL_ABI, static_arrlenu(CALL_ABI));
+
+				s32 sizes[2];
+				get_split_sizes(arg->llvm_easgm, sizes);
+				for (s32 j = 0; j < loc.reg_num; ++j) {
+					mov_rm(tctx, loc.regs[j], addr_reg, j * 8, sizes[j]);
+				}
+			} else if (loc.reg_num) {
+				const enum x64_register arg_reg = loc.regs[0];
 				// To register
 				if (arg_instr->kind == MIR_INSTR_LOAD) {
-					const enum x64_register reg = spill(tctx, available_registers[index], CALL_ABI, args_in_register);
+					const enum x64_register reg = spill(tctx, arg_reg, CALL_ABI, static_arrlenu(CALL_ABI));
 					emit_load_to_register(tctx, arg_instr, reg);
 				} else {
 					if (arg_instr->kind == MIR_INSTR_COMPOUND) {
@@ -1975,30 +2787,30 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 
 					switch (kind) {
 					case OP_IMMEDIATE_NUMBER: {
-						const enum x64_register reg = spill(tctx, available_registers[index], CALL_ABI, args_in_register);
+						const enum x64_register reg = spill(tctx, arg_reg, CALL_ABI, static_arrlenu(CALL_ABI));
 						mov_ri(tctx, reg, peek_immediate(vi), arg_size);
 						break;
 					}
 					case OP_REGISTER_COMPOSIT:
 					case OP_REGISTER_NUMBER: {
-						if (peek_register(vi) != CALL_ABI[index]) {
-							const enum x64_register reg = spill(tctx, available_registers[index], CALL_ABI, args_in_register);
+						if (peek_register(vi) != arg_reg) {
+							const enum x64_register reg = spill(tctx, arg_reg, CALL_ABI, static_arrlenu(CALL_ABI));
 							mov_rr(tctx, reg, peek_register(vi), arg_size);
 						}
 						break;
 					}
 					case OP_OFFSET_NUMBER: {
-						const enum x64_register reg = spill(tctx, available_registers[index], CALL_ABI, args_in_register);
+						const enum x64_register reg = spill(tctx, arg_reg, CALL_ABI, static_arrlenu(CALL_ABI));
 						mov_rm(tctx, reg, RBP, peek_offset(vi), arg_size);
 						break;
 					}
 					case OP_OFFSET_COMPOSIT: {
-						const enum x64_register reg = spill(tctx, available_registers[index], CALL_ABI, args_in_register);
+						const enum x64_register reg = spill(tctx, arg_reg, CALL_ABI, static_arrlenu(CALL_ABI));
 						lea_rm(tctx, reg, RBP, peek_offset(vi), 8);
 						break;
 					}
 					case OP_RELOCATION_NUMBER: {
-						const enum x64_register reg    = spill(tctx, available_registers[index], CALL_ABI, args_in_register);
+						const enum x64_register reg    = spill(tctx, arg_reg, CALL_ABI, static_arrlenu(CALL_ABI));
 						const s32               offset = peek_relocation(vi).offset;
 						mov_rm_indirect(tctx, reg, offset, arg_size);
 						const u32 reloc_position = get_position(tctx, SECTION_TEXT) - sizeof(s32);
@@ -2006,7 +2818,7 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 						break;
 					}
 					case OP_RELOCATION_COMPOSIT: {
-						const enum x64_register reg    = spill(tctx, available_registers[index], CALL_ABI, args_in_register);
+						const enum x64_register reg    = spill(tctx, arg_reg, CALL_ABI, static_arrlenu(CALL_ABI));
 						const s32               offset = peek_relocation(vi).offset;
 						lea_rm_indirect(tctx, reg, offset, 8);
 						const u32 reloc_position = get_position(tctx, SECTION_TEXT) - sizeof(s32);
@@ -2018,6 +2830,7 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 					}
 				}
 			} else {
+				const s32 arg_stack_offset = loc.stack_offset;
 				// Other args needs go to the stack.
 				if (arg_instr->kind == MIR_INSTR_LOAD) {
 					const enum x64_register reg = spill(tctx, RAX, NULL, 0);
@@ -2070,10 +2883,14 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 				}
 			}
 
-			arg_stack_offset += 8;
 			release_value(tctx, arg_instr);
 		}
 
+#if !BL_PLATFORM_WIN
+		// Variadic functions expect upper bound of vector registers used for arguments in AL.
+		mov_ri(tctx, spill(tctx, RAX, CALL_ABI, static_arrlenu(CALL_ABI)), 0, 4);
+#endif
+
 		const enum x64_value_kind callee_kind = peek(vi_callee).kind;
 		if (callee_kind == RELOCATION) {
 			call_relative_i32(tctx, 0);
@@ -2090,8 +2907,13 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 
 		// Store RAX register in case the function returns and the result is used.
 		if (does_return && call->base.ref_count > 1) {
-			if (does_function_return_composit(callee_type)) {
+			if (does_function_return_composit(ctx, callee_type)) {
 				set_value(tctx, instr, (struct x64_value){.kind = OFFSET, .offset = ret_value_tmp_offset});
+			} else if (is_composit_return_in_registers(ctx, callee_type)) {
+				const s32 offset = allocate_stack_memory(tctx, 16);
+				mov_mr(tctx, RBP, offset, RAX, 8);
+				if (ret_type->store_size_bytes > 8) mov_mr(tctx, RBP, offset + 8, RDX, 8);
+				set_value(tctx, instr, (struct x64_value){.kind = OFFSET, .offset = offset});
 			} else {
 				enum x64_register reg = spill(tctx, RAX, NULL, 0);
 				set_value(tctx, instr, (struct x64_value){.kind = REGISTER, .reg = reg});
@@ -2220,7 +3042,7 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 			}
 
 			const u64 vi_init = get_value(tctx, decl->init);
-			bassert(peek(vi_var).kind == OFFSET);
+			bassert(peek(vi_var).kind == OFFSET || peek(vi_var).kind == VARIABLE_REGISTER);
 			emit_mov_values(tctx, type, vi_var, vi_init);
 			release_value(tctx, vi_init);
 		}
@@ -2329,7 +3151,7 @@ static void emit_instr(struct context *ctx, struct thread_context *tctx, struct
 			default:
 				BL_UNIMPLEMENTED;
 			}
-			je_relative_i32(tctx, 0x0);
+			jcc_relative_i32(tctx, CC_E, 0x0);
 			const u64 patch_position = get_position(tctx, SECTION_TEXT) - sizeof(s32);
 
 			struct sym_patch patch = {
@@ -2536,22 +3358,31 @@ void job(struct job_context *job_ctx) {
 	arrsetcap(tctx->local_patches, 128);
 	arrsetcap(tctx->patches, 128);
 
-	// Reset buffers
-	arrsetlen(tctx->text, 0);
-	arrsetlen(tctx->data, 0);
-	arrsetlen(tctx->syms, 0);
-	arrsetlen(tctx->strs, 0);
+	// Reset buffers; generated output is accumulated over all jobs executed on this thread.
 	arrsetlen(tctx->values, 0);
 	arrsetlen(tctx->emit_block_queue, 0);
 	arrsetlen(tctx->local_patches, 0);
-	arrsetlen(tctx->patches, 0);
-	tctx->stack.alloc_value_offset = 0;
-	tctx->stack.free_value_offset  = 0;
 	bl_zeromem(&tctx->stack, sizeof(tctx->stack));
+	bl_zeromem(&tctx->last_store, sizeof(tctx->last_store));
 	tctx->current_fn_composit_return_dest = 0;
 
+	struct x64_unit unit = {
+	    .thread_index   = thread_index,
+	    .text.begin     = (u32)arrlenu(tctx->text),
+	    .data.begin     = (u32)arrlenu(tctx->data),
+	    .syms.begin     = (u32)arrlenu(tctx->syms),
+	    .strs.begin     = (u32)arrlenu(tctx->strs),
+	    .patches.begin  = (u32)arrlenu(tctx->patches),
+	};
+
 	for (s32 i = 0; i < REGISTER_COUNT; ++i) {
-		if ((i >= RAX && i <= RDX) || (i >= R8 && i <= R15)) {
+		// Callee-saved registers are used only for local variables and saved in the function prologue.
+		bool is_usable = (i >= RAX && i <= RDX) || (i >= R8 && i <= R11);
+#if !BL_PLATFORM_WIN
+		// RSI and RDI are volatile argument registers in System V ABI.
+		is_usable |= i == RSI || i == RDI;
+#endif
+		if (is_usable) {
 			// We'll use just volatile registers...
 			tctx->register_table[i] = UNUSED_REGISTER_MAP_VALUE;
 		} else {
@@ -2564,142 +3395,281 @@ void job(struct job_context *job_ctx) {
 
 	patch_jump_offsets(tctx);
 
-	const usize text_len = arrlenu(tctx->text);
-	const usize data_len = arrlenu(tctx->data);
-	const usize syms_len = arrlenu(tctx->syms);
-	const usize strs_len = arrlenu(tctx->strs);
-
-	{
-		mtx_lock(&ctx->mutex);
+	unit.text.len    = (u32)arrlenu(tctx->text) - unit.text.begin;
+	unit.data.len    = (u32)arrlenu(tctx->data) - unit.data.begin;
+	unit.syms.len    = (u32)arrlenu(tctx->syms) - unit.syms.begin;
+	unit.strs.len    = (u32)arrlenu(tctx->strs) - unit.strs.begin;
+	unit.patches.len = (u32)arrlenu(tctx->patches) - unit.patches.begin;
+	arrput(tctx->units, unit);
+	return_zone();
+}
 
-		// Write top-level function generated code into the code section if there is any generated code
-		// present.
+// Short names are not zero terminated when they take all 8 bytes.
+static inline str_t get_symbol_name(IMAGE_SYMBOL *sym, char *strs) {
+	if (sym->N.Name.Short == 0) return make_str_from_c(&strs[sym->N.Name.Long - sizeof(u32)]);
+	return make_str(&sym->N.ShortName[0], strnlen((char *)&sym->N.ShortName[0], sizeof(sym->N.ShortName)));
+}
 
-		const usize gtext_len = arrlenu(ctx->code.bytes);
-		const usize gdata_len = arrlenu(ctx->data.bytes);
-		const usize gsyms_len = arrlenu(ctx->syms);
-		const usize gstrs_len = arrlenu(ctx->strs);
+static int compare_units(const void *a, const void *b) {
+	const str_t name_a = ((const struct x64_unit *)a)->name;
+	const str_t name_b = ((const struct x64_unit *)b)->name;
+	const int   c      = memcmp(name_a.ptr, name_b.ptr, MIN(name_a.len, name_b.len));
+	if (c) return c;
+	return (int)(name_a.len - name_b.len);
+}
 
-		// Insert code.
-		arrsetlen(ctx->code.bytes, gtext_len + text_len);
-		memcpy(&ctx->code.bytes[gtext_len], tctx->text, text_len);
+// Copy a range of sorted units from thread-local buffers into the global buffers; destination offsets and output
+// sections are already resolved, so there is no need for any synchronization.
+static void merge_job(struct job_context *job_ctx) {
+	zone();
+	struct context *ctx = job_ctx->x64_merge.ctx;
 
-		// Insert data.
-		arrsetlen(ctx->data.bytes, gdata_len + data_len);
-		memcpy(&ctx->data.bytes[gdata_len], tctx->data, data_len);
+	for (usize i = job_ctx->x64_merge.first_unit; i < job_ctx->x64_merge.first_unit + job_ctx->x64_merge.unit_num; ++i) {
+		const struct x64_unit *unit = &ctx->units[i];
+		struct thread_context *tctx = &ctx->tctx[unit->thread_index];
 
-		// patch positions.
-		for (usize i = 0; i < arrlenu(tctx->patches); ++i) {
-			struct sym_patch *patch = &tctx->patches[i];
-			bassert(patch->hash);
-			if (patch->target_section == SECTION_TEXT) {
-				patch->position += gtext_len;
-			} else if (patch->target_section == SECTION_DATA) {
-				patch->position += gdata_len;
-			}
-		}
+		// Symbol values and patch positions are relative to the output section.
+		const u32 text_section_offset = unit->text_section_number ? ctx->sections[unit->text_section_number - 1].offset : 0;
+		const u32 data_section_offset = unit->data_section_number ? ctx->sections[unit->data_section_number - 1].offset : 0;
 
-		// Duplicate to global context.
-		const usize gpatches_len = arrlenu(ctx->patches);
-		const usize patches_len  = arrlenu(tctx->patches);
-		arrsetlen(ctx->patches, gpatches_len + patches_len);
-		memcpy(&ctx->patches[gpatches_len], tctx->patches, patches_len * sizeof(struct sym_patch));
+		memcpy(&ctx->code.bytes[unit->text.dest], &tctx->text[unit->text.begin], unit->text.len);
+		memcpy(&ctx->data.bytes[unit->data.dest], &tctx->data[unit->data.begin], unit->data.len);
+		memcpy(&ctx->strs[unit->strs.dest], &tctx->strs[unit->strs.begin], unit->strs.len);
 
 		// Adjust symbol positions.
-		for (usize i = 0; i < arrlenu(tctx->syms); ++i) {
-			IMAGE_SYMBOL *sym = &tctx->syms[i];
+		for (u32 j = 0; j < unit->syms.len; ++j) {
+			IMAGE_SYMBOL *sym = &ctx->syms[unit->syms.dest + j];
+			*sym              = tctx->syms[unit->syms.begin + j];
 			// 0 section number means the symbol is externally linked. There is no location in our
 			// binary.
 			switch (sym->SectionNumber) {
 			case SECTION_EXTERN:
 				break;
 			case SECTION_TEXT:
-				sym->Value += (DWORD)gtext_len;
+				sym->Value         = sym->Value - unit->text.begin + unit->text.dest - text_section_offset;
+				sym->SectionNumber = (s16)unit->text_section_number;
 				break;
 			case SECTION_DATA:
-				sym->Value += (DWORD)gdata_len;
+				sym->Value         = sym->Value - unit->data.begin + unit->data.dest - data_section_offset;
+				sym->SectionNumber = (s16)unit->data_section_number;
 				break;
 			default:
 				babort("Invalid section number!");
 			}
-			char *sym_name = NULL;
-			if (sym->N.Name.Short == 0) {
-				sym_name = &tctx->strs[sym->N.Name.Long - sizeof(u32)];
-				sym->N.Name.Long += (DWORD)gstrs_len;
-			} else {
-				sym_name = (char *)&sym->N.ShortName[0];
+			if (sym->N.Name.Short == 0) sym->N.Name.Long = sym->N.Name.Long - unit->strs.begin + unit->strs.dest;
+		}
+
+		// Patch positions.
+		for (u32 j = 0; j < unit->patches.len; ++j) {
+			struct sym_patch *patch = &ctx->patches[unit->patches.dest + j];
+			*patch                  = tctx->patches[unit->patches.begin + j];
+			bassert(patch->hash);
+			if (patch->target_section == SECTION_TEXT) {
+				patch->position       = patch->position - unit->text.begin + unit->text.dest - text_section_offset;
+				patch->target_section = unit->text_section_number;
+			} else if (patch->target_section == SECTION_DATA) {
+				patch->position       = patch->position - unit->data.begin + unit->data.dest - data_section_offset;
+				patch->target_section = unit->data_section_number;
 			}
-			if (sym->StorageClass == IMAGE_SYM_CLASS_LABEL) continue;
+		}
+	}
+	return_zone();
+}
+
+// Assign output sections of the 'kind' to all units. Each unit gets its own section; in case there are too many units,
+// consecutive units are grouped into one section.
+static void assign_sections(struct context *ctx, s32 kind) {
+	const usize unit_num          = arrlenu(ctx->units);
+	const usize units_per_section = MAX((unit_num + MAX_SECTIONS_PER_KIND - 1) / MAX_SECTIONS_PER_KIND, 1);
+	for (usize i = 0; i < unit_num; i += units_per_section) {
+		const usize group_end = MIN(i + units_per_section, unit_num);
+		u32         size      = 0;
+		for (usize j = i; j < group_end; ++j) {
+			size += kind == SECTION_TEXT ? ctx->units[j].text.len : ctx->units[j].data.len;
+		}
 
-			const hash_t hash = strhash(make_str_from_c(sym_name));
-			bassert(tbl_lookup_index(ctx->symbol_table, hash) == -1);
-			struct symbol_table_entry entry = {
-			    .hash               = hash,
-			    .symbol_table_index = (s32)(i + gsyms_len),
+		s32 section_number = 0;
+		if (size) {
+			struct x64_section section = {
+			    .kind   = kind,
+			    .offset = kind == SECTION_TEXT ? ctx->units[i].text.dest : ctx->units[i].data.dest,
+			    .size   = size,
+			    .name   = units_per_section == 1 ? ctx->units[i].name : str_empty,
 			};
-			tbl_insert(ctx->symbol_table, entry);
+			arrput(ctx->sections, section);
+			section_number = (s32)arrlen(ctx->sections);
 		}
 
-		// Copy symbol table to global one.
-		arrsetlen(ctx->syms, gsyms_len + syms_len);
-		memcpy(&ctx->syms[gsyms_len], tctx->syms, syms_len * sizeof(IMAGE_SYMBOL));
+		for (usize j = i; j < group_end; ++j) {
+			if (kind == SECTION_TEXT) {
+				ctx->units[j].text_section_number = section_number;
+			} else {
+				ctx->units[j].data_section_number = section_number;
+			}
+		}
+	}
+}
 
-		// Copy string table to global one.
-		arrsetlen(ctx->strs, gstrs_len + strs_len);
-		memcpy(&ctx->strs[gstrs_len], tctx->strs, strs_len);
+static inline u8 *get_section_bytes(struct context *ctx, struct x64_section *section) {
+	if (section->kind == SECTION_TEXT) return &ctx->code.bytes[section->offset];
+	return &ctx->data.bytes[section->offset];
+}
 
-		mtx_unlock(&ctx->mutex);
+// Merge output of all threads into the global context. Units are sorted by name, so the produced binary does not
+// depend on the order in which the jobs were executed.
+static void merge_units(struct context *ctx) {
+	zone();
+	arrsetlen(ctx->units, 0);
+	for (usize i = 0; i < arrlenu(ctx->tctx); ++i) {
+		struct thread_context *tctx = &ctx->tctx[i];
+		for (usize j = 0; j < arrlenu(tctx->units); ++j) {
+			struct x64_unit *unit = &tctx->units[j];
+			if (unit->syms.len) unit->name = get_symbol_name(&tctx->syms[unit->syms.begin], tctx->strs);
+			arrput(ctx->units, *unit);
+		}
+	}
+	qsort(ctx->units, arrlenu(ctx->units), sizeof(struct x64_unit), &compare_units);
+
+	// Resolve destination of each unit.
+	const usize gsyms_len = arrlenu(ctx->syms);
+	usize       text_len  = arrlenu(ctx->code.bytes);
+	usize       data_len  = arrlenu(ctx->data.bytes);
+	usize       syms_len  = gsyms_len;
+	usize       strs_len  = arrlenu(ctx->strs);
+	usize       patch_len = arrlenu(ctx->patches);
+	for (usize i = 0; i < arrlenu(ctx->units); ++i) {
+		struct x64_unit *unit = &ctx->units[i];
+		unit->text.dest       = (u32)text_len;
+		unit->data.dest       = (u32)data_len;
+		unit->syms.dest       = (u32)syms_len;
+		unit->strs.dest       = (u32)strs_len;
+		unit->patches.dest    = (u32)patch_len;
+		text_len += unit->text.len;
+		data_len += unit->data.len;
+		syms_len += unit->syms.len;
+		strs_len += unit->strs.len;
+		patch_len += unit->patches.len;
+	}
+	if (text_len > 0xFFFFFFFF || data_len > 0xFFFFFFFF) babort("Generated binary is too big!");
+
+	assign_sections(ctx, SECTION_TEXT);
+	assign_sections(ctx, SECTION_DATA);
+
+	arrsetlen(ctx->code.bytes, text_len);
+	arrsetlen(ctx->data.bytes, data_len);
+	arrsetlen(ctx->syms, syms_len);
+	arrsetlen(ctx->strs, strs_len);
+	arrsetlen(ctx->patches, patch_len);
+
+	const usize unit_num   = arrlenu(ctx->units);
+	const usize batch_size = MAX(unit_num / (get_thread_count() * 4), 1);
+	for (usize i = 0; i < unit_num; i += batch_size) {
+		struct job_context job_ctx = {.x64_merge = {.ctx = ctx, .first_unit = i, .unit_num = MIN(batch_size, unit_num - i)}};
+		submit_job(&merge_job, &job_ctx);
+	}
+	wait_threads();
+
+	// Register symbols in the global symbol table.
+	for (usize i = gsyms_len; i < arrlenu(ctx->syms); ++i) {
+		IMAGE_SYMBOL *sym = &ctx->syms[i];
+		if (sym->StorageClass == IMAGE_SYM_CLASS_LABEL) continue;
+
+		const hash_t hash = strhash(get_symbol_name(sym, ctx->strs));
+		bassert(tbl_lookup_index(ctx->symbol_table, hash) == -1);
+		struct symbol_table_entry entry = {
+		    .hash               = hash,
+		    .symbol_table_index = (s32)i,
+		};
+		tbl_insert(ctx->symbol_table, entry);
 	}
 	return_zone();
 }
 
+#if BL_PLATFORM_WIN
 static void create_object_file(struct context *ctx) {
-	usize text_section_pointer = IMAGE_SIZEOF_FILE_HEADER + IMAGE_SIZEOF_SECTION_HEADER * 2;
-
-	// Code block is aligned to 16 bytes, do we need this???
-	const usize section_data_padding = next_aligned2(text_section_pointer, 16) - text_section_pointer;
-	text_section_pointer += section_data_padding;
+	const usize section_num = arrlenu(ctx->sections);
+
+	// Code sections containing single function are emitted as COMDAT, so the linker can drop unreferenced ones. COMDAT
+	// section requires a section symbol with the auxiliary section definition record preceding the function symbol.
+	array(IMAGE_SYMBOL) section_syms = NULL;
+	array(bool) is_comdat            = NULL;
+	arrsetlen(is_comdat, section_num);
+	bl_zeromem(is_comdat, section_num * sizeof(bool));
+	for (usize i = 0; i < arrlenu(ctx->units); ++i) {
+		struct x64_unit *unit = &ctx->units[i];
+		if (!unit->text_section_number || !unit->syms.len) continue;
+		struct x64_section *section = &ctx->sections[unit->text_section_number - 1];
+		IMAGE_SYMBOL       *sym     = &ctx->syms[unit->syms.dest];
+		if (!section->name.len || sym->SectionNumber != unit->text_section_number) continue;
+		if (sym->StorageClass != IMAGE_SYM_CLASS_EXTERNAL) continue;
+		is_comdat[unit->text_section_number - 1] = true;
+	}
 
-	const usize text_reloc_pointer = text_section_pointer + arrlenu(ctx->code.bytes);
+	// Section header table is followed by section data and relocations.
+	usize position = IMAGE_SIZEOF_FILE_HEADER + IMAGE_SIZEOF_SECTION_HEADER * section_num;
 
-	const usize text_reloc_num = arrlenu(ctx->code.relocs);
-	if (text_reloc_num > 0xFFFF) {
-		babort("Text relocation table is too large to be stored for a single section in the COFF file!");
-	}
+	array(IMAGE_SECTION_HEADER) headers = NULL;
+	arrsetlen(headers, section_num);
+	for (usize i = 0; i < section_num; ++i) {
+		struct x64_section *section   = &ctx->sections[i];
+		const usize         reloc_num = arrlenu(section->relocs);
+		const bool          is_text   = section->kind == SECTION_TEXT;
 
-	const usize data_reloc_num = arrlenu(ctx->data.relocs);
-	if (data_reloc_num > 0xFFFF) {
-		babort("Data relocation table is too large to be stored for a single section in the COFF file!");
+		IMAGE_SECTION_HEADER header = {
+		    .Name            = ".data",
+		    .Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ | IMAGE_SCN_MEM_WRITE | IMAGE_SCN_ALIGN_16BYTES,
+		    .SizeOfRawData   = section->size,
+		};
+		if (is_text) {
+			memcpy(header.Name, ".text", sizeof(".text"));
+			header.Characteristics = IMAGE_SCN_CNT_CODE | IMAGE_SCN_MEM_READ | IMAGE_SCN_ALIGN_16BYTES | IMAGE_SCN_MEM_EXECUTE;
+		}
+		if (is_comdat[i]) header.Characteristics |= IMAGE_SCN_LNK_COMDAT;
+
+		position                = next_aligned2(position, 16);
+		header.PointerToRawData = (u32)position;
+		position += section->size;
+
+		if (reloc_num) {
+			header.PointerToRelocations = (u32)position;
+			if (reloc_num >= 0xFFFF) {
+				// Real count of relocations is stored in the first relocation entry.
+				header.NumberOfRelocations = 0xFFFF;
+				header.Characteristics |= IMAGE_SCN_LNK_NRELOC_OVFL;
+				position += sizeof(IMAGE_RELOCATION);
+			} else {
+				header.NumberOfRelocations = (u16)reloc_num;
+			}
+			position += sizeof(IMAGE_RELOCATION) * reloc_num;
+		}
+		headers[i] = header;
+
+		if (!is_comdat[i]) continue;
+		IMAGE_SYMBOL section_sym = {
+		    .N.ShortName        = ".text",
+		    .SectionNumber      = (s16)(i + 1),
+		    .StorageClass       = IMAGE_SYM_CLASS_STATIC,
+		    .NumberOfAuxSymbols = 1,
+		};
+		IMAGE_AUX_SYMBOL aux = {
+		    .Section.Length              = section->size,
+		    .Section.NumberOfRelocations = header.NumberOfRelocations,
+		    .Section.Selection           = IMAGE_COMDAT_SELECT_NODUPLICATES,
+		};
+		arrput(section_syms, section_sym);
+		arrsetlen(section_syms, arrlenu(section_syms) + 1);
+		memcpy(&arrlast(section_syms), &aux, IMAGE_SIZEOF_SYMBOL);
 	}
 
-	const usize data_section_pointer   = text_reloc_pointer + sizeof(IMAGE_RELOCATION) * text_reloc_num;
-	const usize data_reloc_pointer     = data_section_pointer + arrlenu(ctx->data.bytes);
-	const usize symbol_section_pointer = data_reloc_pointer + sizeof(IMAGE_RELOCATION) * data_reloc_num;
+	// Section symbols are placed before all other symbols.
+	const u32 symbol_index_offset = (u32)arrlenu(section_syms);
 
 	IMAGE_FILE_HEADER header = {
 	    .Machine              = IMAGE_FILE_MACHINE_AMD64,
-	    .NumberOfSections     = 2,
-	    .PointerToSymbolTable = (DWORD)symbol_section_pointer,
-	    .NumberOfSymbols      = (DWORD)arrlenu(ctx->syms),
-	    .TimeDateStamp        = (DWORD)time(0),
-	};
-
-	IMAGE_SECTION_HEADER section_text = {
-	    .Name                 = ".text",
-	    .Characteristics      = IMAGE_SCN_CNT_CODE | IMAGE_SCN_MEM_READ | IMAGE_SCN_ALIGN_16BYTES | IMAGE_SCN_MEM_EXECUTE,
-	    .SizeOfRawData        = (DWORD)arrlenu(ctx->code.bytes),
-	    .PointerToRawData     = (DWORD)text_section_pointer,
-	    .PointerToRelocations = (DWORD)text_reloc_pointer,
-	    .NumberOfRelocations  = (u16)text_reloc_num,
-	};
-
-	IMAGE_SECTION_HEADER section_data = {
-	    .Name                 = ".data",
-	    .Characteristics      = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ | IMAGE_SCN_MEM_WRITE | IMAGE_SCN_ALIGN_16BYTES,
-	    .SizeOfRawData        = (DWORD)arrlenu(ctx->data.bytes),
-	    .PointerToRawData     = (DWORD)data_section_pointer,
-	    .PointerToRelocations = (DWORD)data_reloc_pointer,
-	    .NumberOfRelocations  = (u16)data_reloc_num,
+	    .NumberOfSections     = (u16)section_num,
+	    .PointerToSymbolTable = (u32)position,
+	    .NumberOfSymbols      = (u32)(arrlenu(ctx->syms) + symbol_index_offset),
+	    .TimeDateStamp        = (u32)time(0),
 	};
 
 	str_buf_t            buf    = get_tmp_str();
@@ -2711,52 +3681,319 @@ static void create_object_file(struct context *ctx) {
 		// @Incomplete: Handle properly!
 		babort("Cannot create the output file.");
 	}
+	put_tmp_str(buf);
 
 	//
 	// Headers
 	//
-	// Write COFF header
 	fwrite(&header, 1, IMAGE_SIZEOF_FILE_HEADER, file);
-	// Text section header
-	fwrite(&section_text, 1, IMAGE_SIZEOF_SECTION_HEADER, file);
-	fwrite(&section_data, 1, IMAGE_SIZEOF_SECTION_HEADER, file);
+	fwrite(headers, IMAGE_SIZEOF_SECTION_HEADER, section_num, file);
+	position = IMAGE_SIZEOF_FILE_HEADER + IMAGE_SIZEOF_SECTION_HEADER * section_num;
 
-	// .text
-	// Gap to align the code section.
+	//
+	// Sections
+	//
 	u8 padding[16] = {0};
-	bassert(section_data_padding <= static_arrlenu(padding));
-	fwrite(padding, 1, section_data_padding, file);
-	fwrite(ctx->code.bytes, 1, arrlenu(ctx->code.bytes), file);
-	fwrite(ctx->code.relocs, text_reloc_num, sizeof(IMAGE_RELOCATION), file);
-
-	// .data
-	fwrite(ctx->data.bytes, 1, arrlenu(ctx->data.bytes), file);
-	fwrite(ctx->data.relocs, data_reloc_num, sizeof(IMAGE_RELOCATION), file);
+	for (usize i = 0; i < section_num; ++i) {
+		struct x64_section *section = &ctx->sections[i];
+		bassert(next_aligned2(position, 16) == headers[i].PointerToRawData);
+		fwrite(padding, 1, headers[i].PointerToRawData - position, file);
+		fwrite(get_section_bytes(ctx, section), 1, section->size, file);
+		position = headers[i].PointerToRawData + section->size;
+
+		const usize reloc_num = arrlenu(section->relocs);
+		if (!reloc_num) continue;
+		if (reloc_num >= 0xFFFF) {
+			const IMAGE_RELOCATION count = {.RelocCount = (u32)(reloc_num + 1)};
+			fwrite(&count, 1, sizeof(IMAGE_RELOCATION), file);
+			position += sizeof(IMAGE_RELOCATION);
+		}
+		for (usize j = 0; j < reloc_num; ++j) {
+			section->relocs[j].SymbolTableIndex += symbol_index_offset;
+		}
+		fwrite(section->relocs, sizeof(IMAGE_RELOCATION), reloc_num, file);
+		position += sizeof(IMAGE_RELOCATION) * reloc_num;
+	}
 
 	// Symbol table
+	fwrite(section_syms, IMAGE_SIZEOF_SYMBOL, arrlenu(section_syms), file);
 	fwrite(ctx->syms, IMAGE_SIZEOF_SYMBOL, arrlenu(ctx->syms), file);
 
 	// String table
 	u32 strs_len = (u32)arrlenu(ctx->strs) + sizeof(u32); // See the COFF specifiction sec 5.6.
 	fwrite(&strs_len, 1, sizeof(u32), file);
-	fwrite(ctx->strs, 1, strs_len, file);
+	fwrite(ctx->strs, 1, arrlenu(ctx->strs), file);
+
+	fclose(file);
+
+	arrfree(section_syms);
+	arrfree(is_comdat);
+	arrfree(headers);
+}
+#else
+
+// Converts COFF relocations into ELF ones; the implicit addends stored in the section data are moved into relocation
+// entries.
+static void convert_relocations(struct context *ctx, IMAGE_RELOCATION *relocs, u8 *bytes, const s32 *symbol_map, array(Elf64_Rela) *dest) {
+	for (usize i = 0; i < arrlenu(relocs); ++i) {
+		IMAGE_RELOCATION *reloc    = &relocs[i];
+		IMAGE_SYMBOL     *sym      = &ctx->syms[reloc->SymbolTableIndex];
+		const u32         position = reloc->VirtualAddress;
+
+		u32 type;
+		s64 addend;
+		switch (reloc->Type) {
+		case IMAGE_REL_AMD64_REL32:
+			type   = sym->Type == DT_FUNCTION ? R_X86_64_PLT32 : R_X86_64_PC32;
+			addend = (s64)*data_ptr_s32(bytes, position) - 4;
+			*data_ptr_s32(bytes, position) = 0;
+			break;
+		case IMAGE_REL_AMD64_REL32_4:
+			// Relative to the end of the instruction with 4 byte immediate operand.
+			type   = R_X86_64_PC32;
+			addend = (s64)*data_ptr_s32(bytes, position) - 8;
+			*data_ptr_s32(bytes, position) = 0;
+			break;
+		case IMAGE_REL_AMD64_ADDR64:
+			type = R_X86_64_64;
+			memcpy(&addend, &bytes[position], sizeof(s64));
+			bl_zeromem(&bytes[position], sizeof(s64));
+			break;
+		default:
+			babort("Unsupported relocation type!");
+		}
+
+		const Elf64_Rela rela = {
+		    .r_offset = position,
+		    .r_info   = ELF64_R_INFO((u64)symbol_map[reloc->SymbolTableIndex], type),
+		    .r_addend = addend,
+		};
+		arrput(*dest, rela);
+	}
+}
+
+// Writes the buffer aligned to the 'alignment' and returns its position in the file.
+static u64 write_aligned(FILE *file, u64 *position, const void *buf, u64 size, u64 alignment) {
+	static const u8 padding[16] = {0};
+	bassert(alignment <= static_arrlenu(padding));
+	const u64 aligned = next_aligned2(*position, alignment);
+	fwrite(padding, 1, aligned - *position, file);
+	if (size) fwrite(buf, 1, size, file);
+	*position = aligned + size;
+	return aligned;
+}
+
+static inline u32 add_section_name(array(char) *shstrs, const char *prefix, str_t name) {
+	const u32   offset     = (u32)arrlenu(*shstrs);
+	const usize prefix_len = strlen(prefix);
+	arrsetlen(*shstrs, offset + prefix_len + (name.len ? name.len + 1 : 0) + 1);
+	memcpy(&(*shstrs)[offset], prefix, prefix_len);
+	if (name.len) {
+		(*shstrs)[offset + prefix_len] = '.';
+		memcpy(&(*shstrs)[offset + prefix_len + 1], name.ptr, name.len);
+	}
+	(*shstrs)[arrlenu(*shstrs) - 1] = '\0';
+	return offset;
+}
+
+static void create_object_file(struct context *ctx) {
+	// Code and data sections follow the null section, so their header indices are the same as COFF section numbers
+	// used in the symbol table. Relocation sections are generated only for sections with relocations.
+	const u32 section_num = (u32)arrlenu(ctx->sections);
+	u32       rela_num    = 0;
+	for (u32 i = 0; i < section_num; ++i) {
+		if (arrlenu(ctx->sections[i].relocs)) ++rela_num;
+	}
+
+	const u32 shdr_rela_first     = 1 + section_num;
+	const u32 shdr_symtab         = shdr_rela_first + rela_num;
+	const u32 shdr_strtab         = shdr_symtab + 1;
+	const u32 shdr_shstrtab       = shdr_strtab + 1;
+	const u32 shdr_note_gnu_stack = shdr_shstrtab + 1;
+	const u32 shdr_count          = shdr_note_gnu_stack + 1;
+	bassert(shdr_count < SHN_LORESERVE);
+
+	array(char) shstrs = NULL;
+	arrput(shstrs, '\0');
+
+	// Symbol table; local symbols must precede the global ones.
+	const usize syms_len = arrlenu(ctx->syms);
+	array(Elf64_Sym) syms = NULL;
+	array(char) strs      = NULL;
+	array(s32) symbol_map = NULL;
+	arrsetlen(symbol_map, syms_len);
+	arrsetcap(syms, syms_len + 1);
+	arrput(syms, (Elf64_Sym){0});
+	arrput(strs, '\0');
+
+	u32 first_global_index = 0;
+	for (s32 pass = 0; pass < 2; ++pass) {
+		const bool is_local_pass = pass == 0;
+		if (!is_local_pass) first_global_index = (u32)arrlenu(syms);
+
+		for (usize i = 0; i < syms_len; ++i) {
+			IMAGE_SYMBOL *sym      = &ctx->syms[i];
+			const bool    is_local = sym->StorageClass == IMAGE_SYM_CLASS_LABEL;
+			if (is_local != is_local_pass) continue;
+
+			const str_t name        = get_symbol_name(sym, ctx->strs);
+			const u32   name_offset = (u32)arrlenu(strs);
+			arrsetlen(strs, name_offset + name.len + 1);
+			memcpy(&strs[name_offset], name.ptr, name.len);
+			strs[name_offset + name.len] = '\0';
+
+			const bool is_extern = sym->SectionNumber == SECTION_EXTERN;
+
+			u8 type = STT_NOTYPE;
+			if (sym->Type == DT_FUNCTION) {
+				type = STT_FUNC;
+			} else if (!is_extern && ctx->sections[sym->SectionNumber - 1].kind == SECTION_DATA) {
+				type = STT_OBJECT;
+			}
 
+			Elf64_Sym elf_sym = {
+			    .st_name  = name_offset,
+			    .st_info  = ELF64_ST_INFO(is_local ? STB_LOCAL : STB_GLOBAL, type),
+			    .st_shndx = is_extern ? SHN_UNDEF : (u16)sym->SectionNumber,
+			    .st_value = is_extern ? 0 : sym->Value,
+			};
+			symbol_map[i] = (s32)arrlenu(syms);
+			arrput(syms, elf_sym);
+		}
+	}
+
+	str_buf_t            buf    = get_tmp_str();
+	const struct target *target = ctx->assembly->target;
+	const char          *name   = target->name;
+	str_buf_append_fmt(&buf, "{str}/{s}.{s}", target->out_dir, name, OBJ_EXT);
+	FILE *file = fopen(str_buf_to_c(buf), "wb");
+	if (!file) {
+		// @Incomplete: Handle properly!
+		babort("Cannot create the output file.");
+	}
+	put_tmp_str(buf);
+
+	Elf64_Ehdr header = {
+	    .e_ident     = {ELFMAG0, ELFMAG1, ELFMAG2, ELFMAG3, ELFCLASS64, ELFDATA2LSB, EV_CURRENT, ELFOSABI_SYSV},
+	    .e_type      = ET_REL,
+	    .e_machine   = EM_X86_64,
+	    .e_version   = EV_CURRENT,
+	    .e_ehsize    = sizeof(Elf64_Ehdr),
+	    .e_shentsize = sizeof(Elf64_Shdr),
+	    .e_shnum     = (u16)shdr_count,
+	    .e_shstrndx  = (u16)shdr_shstrtab,
+	};
+
+	// Header is written again at the end when the section header table position is known.
+	u64 position = 0;
+	write_aligned(file, &position, &header, sizeof(Elf64_Ehdr), 1);
+
+	array(Elf64_Shdr) sections = NULL;
+	arrsetlen(sections, shdr_count);
+	bl_zeromem(sections, shdr_count * sizeof(Elf64_Shdr));
+
+	// Code and data; relocations are converted first, since implicit addends are moved out of the section data.
+	array(Elf64_Rela) relocs = NULL;
+	u32 shdr_rela            = shdr_rela_first;
+	for (u32 i = 0; i < section_num; ++i) {
+		struct x64_section *section = &ctx->sections[i];
+		const bool          is_text = section->kind == SECTION_TEXT;
+		u8                 *bytes   = get_section_bytes(ctx, section);
+
+		arrsetlen(relocs, 0);
+		convert_relocations(ctx, section->relocs, bytes, symbol_map, &relocs);
+
+		sections[i + 1] = (Elf64_Shdr){
+		    .sh_name      = add_section_name(&shstrs, is_text ? ".text" : ".data", section->name),
+		    .sh_type      = SHT_PROGBITS,
+		    .sh_flags     = is_text ? SHF_ALLOC | SHF_EXECINSTR : SHF_ALLOC | SHF_WRITE,
+		    .sh_offset    = write_aligned(file, &position, bytes, section->size, 16),
+		    .sh_size      = section->size,
+		    .sh_addralign = 16,
+		};
+
+		if (!arrlenu(relocs)) continue;
+		const u64 relocs_size = arrlenu(relocs) * sizeof(Elf64_Rela);
+		sections[shdr_rela++] = (Elf64_Shdr){
+		    .sh_name      = add_section_name(&shstrs, is_text ? ".rela.text" : ".rela.data", section->name),
+		    .sh_type      = SHT_RELA,
+		    .sh_flags     = SHF_INFO_LINK,
+		    .sh_offset    = write_aligned(file, &position, relocs, relocs_size, 8),
+		    .sh_size      = relocs_size,
+		    .sh_link      = shdr_symtab,
+		    .sh_info      = i + 1,
+		    .sh_addralign = 8,
+		    .sh_entsize   = sizeof(Elf64_Rela),
+		};
+	}
+	bassert(shdr_rela == shdr_symtab);
+
+	const u64 syms_size   = arrlenu(syms) * sizeof(Elf64_Sym);
+	sections[shdr_symtab] = (Elf64_Shdr){
+	    .sh_name      = add_section_name(&shstrs, ".symtab", str_empty),
+	    .sh_type      = SHT_SYMTAB,
+	    .sh_offset    = write_aligned(file, &position, syms, syms_size, 8),
+	    .sh_size      = syms_size,
+	    .sh_link      = shdr_strtab,
+	    .sh_info      = first_global_index,
+	    .sh_addralign = 8,
+	    .sh_entsize   = sizeof(Elf64_Sym),
+	};
+
+	sections[shdr_strtab] = (Elf64_Shdr){
+	    .sh_name      = add_section_name(&shstrs, ".strtab", str_empty),
+	    .sh_type      = SHT_STRTAB,
+	    .sh_offset    = write_aligned(file, &position, strs, arrlenu(strs), 1),
+	    .sh_size      = arrlenu(strs),
+	    .sh_addralign = 1,
+	};
+
+	// Mark the stack as non-executable.
+	sections[shdr_note_gnu_stack] = (Elf64_Shdr){
+	    .sh_name      = add_section_name(&shstrs, ".note.GNU-stack", str_empty),
+	    .sh_type      = SHT_PROGBITS,
+	    .sh_addralign = 1,
+	};
+
+	// Section name table must be the last one, all names are already added.
+	const u32 shstrtab_name = add_section_name(&shstrs, ".shstrtab", str_empty);
+	sections[shdr_shstrtab] = (Elf64_Shdr){
+	    .sh_name      = shstrtab_name,
+	    .sh_type      = SHT_STRTAB,
+	    .sh_offset    = write_aligned(file, &position, shstrs, arrlenu(shstrs), 1),
+	    .sh_size      = arrlenu(shstrs),
+	    .sh_addralign = 1,
+	};
+	sections[shdr_note_gnu_stack].sh_offset = position;
+
+	header.e_shoff = write_aligned(file, &position, sections, shdr_count * sizeof(Elf64_Shdr), 8);
+	fseek(file, 0, SEEK_SET);
+	fwrite(&header, 1, sizeof(Elf64_Ehdr), file);
 	fclose(file);
+
+	arrfree(shstrs);
+	arrfree(syms);
+	arrfree(strs);
+	arrfree(symbol_map);
+	arrfree(relocs);
+	arrfree(sections);
 }
+#endif
 
 void x86_64run(struct assembly *assembly) {
 	builder_warning("Using experimental x64 backend.");
+#if BL_PLATFORM_WIN
 	if (assembly->target->reg_split) {
 		builder_error("Register split feature is not available when x64 backend is used. This feature is part of System V calling convetions.");
 		return;
 	}
+#endif
 
 	struct context ctx = {
 	    .assembly      = assembly,
 	    .builtin_types = &assembly->builtin_types,
 	};
 
-	mtx_init(&ctx.mutex, mtx_plain);
 	spl_init(&ctx.uq_name_lock);
 	spl_init(&ctx.schedule_for_generation_lock);
 	spl_init(&ctx.rtti_lock);
@@ -2768,8 +4005,6 @@ void x86_64run(struct assembly *assembly) {
 	arrsetcap(ctx.strs, 64 * 1024);
 	arrsetcap(ctx.code.bytes, 1024 * 1024);
 	arrsetcap(ctx.data.bytes, 1024 * 1024);
-	arrsetcap(ctx.code.relocs, 4096);
-	arrsetcap(ctx.data.relocs, 4096);
 	arrsetcap(ctx.syms, 64 * 1024);
 	arrsetcap(ctx.patches, 64 * 1024);
 
@@ -2782,6 +4017,7 @@ void x86_64run(struct assembly *assembly) {
 		submit_job(&job, &job_ctx);
 	}
 	wait_threads();
+	merge_units(&ctx);
 
 	for (usize i = 0; i < arrlenu(ctx.patches); ++i) {
 		struct sym_patch *patch = &ctx.patches[i];
@@ -2794,28 +4030,25 @@ void x86_64run(struct assembly *assembly) {
 			babort("Internally linked symbol reference is not found in the binary!");
 		}
 
-		const s32     symbol_table_index = ctx.symbol_table[i].symbol_table_index;
-		IMAGE_SYMBOL *sym                = &ctx.syms[symbol_table_index];
-		if (sym->SectionNumber != SECTION_TEXT || patch->target_section != sym->SectionNumber) {
+		const s32           symbol_table_index = ctx.symbol_table[i].symbol_table_index;
+		IMAGE_SYMBOL       *sym                = &ctx.syms[symbol_table_index];
+		struct x64_section *section            = &ctx.sections[patch->target_section - 1];
+		if (section->kind != SECTION_TEXT || patch->target_section != sym->SectionNumber) {
 			// @Performance: In case the symbol is from other section we probably have to rely on linker
 			// doing relocations, in case of external symbol it's correct way to do it.
 
 			IMAGE_RELOCATION reloc = {
 			    .Type             = patch->type,
 			    .SymbolTableIndex = symbol_table_index,
-			    .VirtualAddress   = (DWORD)patch->position,
+			    .VirtualAddress   = (u32)patch->position,
 			};
-
-			if (patch->target_section == SECTION_TEXT) {
-				arrput(ctx.code.relocs, reloc);
-			} else if (patch->target_section == SECTION_DATA) {
-				arrput(ctx.data.relocs, reloc);
-			}
+			arrput(section->relocs, reloc);
 		} else {
 			// Fix the location.
-			const s32 sym_position                  = (s32)sym->Value;
-			const s32 position                      = (s32)patch->position;
-			*data_ptr_s32(ctx.code.bytes, position) = sym_position - (position + sizeof(s32));
+			const s32 sym_position = (s32)sym->Value;
+			const s32 position     = (s32)patch->position;
+			u8       *bytes        = get_section_bytes(&ctx, section);
+			*data_ptr_s32(bytes, position) = sym_position - (position + sizeof(s32));
 		}
 	}
 
@@ -2834,16 +4067,27 @@ void x86_64run(struct assembly *assembly) {
 			arrfree(tctx->emit_block_queue);
 			arrfree(tctx->local_patches);
 			arrfree(tctx->patches);
+			arrfree(tctx->units);
+			tbl_free(tctx->regalloc.var_index);
+			tbl_free(tctx->regalloc.block_index);
+			arrfree(tctx->regalloc.blocks);
+			arrfree(tctx->regalloc.intervals);
+			arrfree(tctx->regalloc.block_bounds);
+			arrfree(tctx->regalloc.sets);
+			arrfree(tctx->regalloc.sorted);
 		}
 
 		arrfree(ctx.tctx);
 		arrfree(ctx.strs);
 		arrfree(ctx.code.bytes);
-		arrfree(ctx.code.relocs);
 		arrfree(ctx.data.bytes);
-		arrfree(ctx.data.relocs);
+		for (usize i = 0; i < arrlenu(ctx.sections); ++i) {
+			arrfree(ctx.sections[i].relocs);
+		}
+		arrfree(ctx.sections);
 		arrfree(ctx.syms);
 		arrfree(ctx.patches);
+		arrfree(ctx.units);
 
 		tbl_free(ctx.symbol_table);
 		tbl_free(ctx.scheduled_for_generation);
@@ -2853,7 +4097,6 @@ void x86_64run(struct assembly *assembly) {
 	spl_destroy(&ctx.schedule_for_generation_lock);
 	spl_destroy(&ctx.rtti_lock);
 	spl_destroy(&ctx.uq_name_lock);
-	mtx_destroy(&ctx.mutex);
 }
 #else
 void x86_64run(struct assembly *assembly) {
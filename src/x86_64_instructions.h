@@ -87,6 +87,8 @@ static const char *register_name[] = {
 #define is_byte_disp(off)               ((off) >= -128 && (off) < 128)
 
 static void              add_code(struct thread_context *tctx, const void *buf, s32 len);
+static void              record_store(struct thread_context *tctx, u8 base, s32 offset, u8 r, usize size);
+static bool              forward_stored_value(struct thread_context *tctx, u8 r, u8 base, s32 offset, usize size);
 static enum x64_register get_temporary_register(struct thread_context *tctx, const enum x64_register exclude[], s32 exclude_num);
 
 // Encode the instruction extension byte for 64bit mode.
@@ -103,6 +105,11 @@ static inline u8 encode_rex(bool W, u8 reg, u8 index, u8 rm) {
 static inline void encode_base(struct thread_context *tctx, u8 rex, u8 op_base, u8 mrr, usize size) {
 	u8  buf[4];
 	s32 i = 0;
+	if (size == 1 && !rex && mrr) {
+		// Byte access to SPL, BPL, SIL and DIL requires empty REX prefix, otherwise AH, CH, DH or BH is used.
+		const bool is_rm_register = (mrr >> 6) == MOD_REG_ADDR;
+		if (((mrr >> 3) & 0b111) >= 4 || (is_rm_register && (mrr & 0b111) >= 4)) rex = 0b01000000;
+	}
 	if (size == 2) buf[i++] = 0x66;
 	if (rex) buf[i++] = rex;
 	buf[i++] = size == 1 ? op_base : (op_base + 1);
@@ -186,12 +193,13 @@ static inline void mov_mr(struct thread_context *tctx, u8 r1, s32 offset, u8 r2,
 	const u8 mrr  = encode_mod_reg_rm(disp, r2, r1);
 	const u8 rex  = encode_rex(size == 8, r2, 0, r1);
 	encode_base(tctx, rex, 0x88, mrr, size);
-	if (r1 == RSP) {
-		// @Incomplete: Might be broken???
-		const u8 sib = encode_sib(0, r1, r1);
+	if ((r1 & 0b111) == RSP) {
+		// RSP and R12 base requires SIB byte.
+		const u8 sib = encode_sib(0, RSP, r1);
 		add_code(tctx, &sib, 1);
 	}
 	add_code(tctx, &offset, disp == MOD_BYTE_DISP ? 1 : 4);
+	record_store(tctx, r1, offset, r2, size);
 }
 
 static inline void mov_mi(struct thread_context *tctx, u8 r, s32 offset, u64 imm, usize size) {
@@ -207,9 +215,9 @@ static inline void mov_mi(struct thread_context *tctx, u8 r, s32 offset, u64 imm
 	const u8 mrr  = encode_mod_reg_rm(disp, 0, r);
 	const u8 rex  = encode_rex(size == 8, 0, 0, r);
 	encode_base(tctx, rex, 0xC6, mrr, size);
-	if (r == RSP) {
-		// @Incomplete: Might be broken???
-		const u8 sib = encode_sib(0x0, r, r);
+	if ((r & 0b111) == RSP) {
+		// RSP and R12 base requires SIB byte.
+		const u8 sib = encode_sib(0x0, RSP, r);
 		add_code(tctx, &sib, 1);
 	}
 	add_code(tctx, &offset, disp == MOD_BYTE_DISP ? 1 : 4);
@@ -280,16 +288,21 @@ static inline void mov_mi_indirect(struct thread_context *tctx, s32 offset, u64
 
 // Immediate value to register.
 static inline void mov_ri(struct thread_context *tctx, u8 r, u64 imm, usize size) {
-	// @Performance: xor for zero values???
-	// @Performance: xor for zero values???
-	// @Performance: xor for zero values???
-
-	if (size == 8 && imm > 0x7FFFFFFF) {
+	// @Performance: xor for zero values??? We cannot do it easily, since it changes flags and we might emit immediates
+	// between cmp and conditional jump.
+
+	if (size == 8 && imm <= 0xFFFFFFFF) {
+		// 32bit operation clears upper half of the register, so we can use shorter encoding.
+		size = 4;
+	} else if (size == 8 && ((s64)imm < INT32_MIN || (s64)imm > INT32_MAX)) {
+		// Not representable as sign-extended 32bit immediate.
 		movabs64_ri(tctx, r, imm);
 		return;
 	}
 
-	const u8 rex = encode_rex(size == 8, 0, 0, r);
+	u8 rex = encode_rex(size == 8, 0, 0, r);
+	// Byte access to SPL, BPL, SIL and DIL requires empty REX prefix.
+	if (size == 1 && !rex && r >= 4) rex = 0b01000000;
 
 	u8  buf[4];
 	s32 i = 0;
@@ -317,10 +330,16 @@ static inline void mov_ri(struct thread_context *tctx, u8 r, u64 imm, usize size
 // Stack to register
 static inline void mov_rm(struct thread_context *tctx, u8 r1, u8 r2, s32 offset, usize size) {
 	bassert(offset <= 0x7FFFFFFF);
+	if (forward_stored_value(tctx, r1, r2, offset, size)) return;
 	const u8 disp = is_byte_disp(offset) ? MOD_BYTE_DISP : MOD_FOUR_BYTE_DISP;
 	const u8 rex  = encode_rex(size == 8, r1, 0, r2);
 	const u8 mrr  = encode_mod_reg_rm(disp, r1, r2);
 	encode_base(tctx, rex, 0x8A, mrr, size);
+	if ((r2 & 0b111) == RSP) {
+		// RSP and R12 base requires SIB byte.
+		const u8 sib = encode_sib(0, RSP, r2);
+		add_code(tctx, &sib, 1);
+	}
 	add_code(tctx, &offset, disp == MOD_BYTE_DISP ? 1 : 4);
 }
 
@@ -610,47 +629,35 @@ static inline void ret(struct thread_context *tctx) {
 	add_code(tctx, buf, 1);
 }
 
-static inline void jmp_relative_i32(struct thread_context *tctx, s32 offset) {
-	const u8 buf[] = {0xE9};
-	add_code(tctx, buf, 1);
-	add_code(tctx, &offset, sizeof(offset));
-}
-
-// Returns position of 32bit offset value in the current code section. This might be used
-// for postponed fixup in case target block is not generated yet.
-static inline void jne_relative_i32(struct thread_context *tctx, s32 offset) {
-	const u8 buf[] = {0x0F, 0x85};
-	add_code(tctx, buf, 2);
-	add_code(tctx, &offset, sizeof(offset));
-}
-
-static inline void je_relative_i32(struct thread_context *tctx, s32 offset) {
-	const u8 buf[] = {0x0F, 0x84};
-	add_code(tctx, buf, 2);
-	add_code(tctx, &offset, sizeof(offset));
-}
+// Condition codes used in conditional jump encoding.
+enum x64_condition {
+	CC_E  = 0x4,
+	CC_NE = 0x5,
+	CC_L  = 0xC,
+	CC_GE = 0xD,
+	CC_LE = 0xE,
+	CC_G  = 0xF,
+};
 
-static inline void jg_relative_i32(struct thread_context *tctx, s32 offset) {
-	const u8 buf[] = {0x0F, 0x8F};
+static inline void jmp_relative_i8(struct thread_context *tctx, s8 offset) {
+	const u8 buf[] = {0xEB, (u8)offset};
 	add_code(tctx, buf, 2);
-	add_code(tctx, &offset, sizeof(offset));
 }
 
-static inline void jl_relative_i32(struct thread_context *tctx, s32 offset) {
-	const u8 buf[] = {0x0F, 0x8C};
+static inline void jcc_relative_i8(struct thread_context *tctx, enum x64_condition cc, s8 offset) {
+	const u8 buf[] = {0x70 | cc, (u8)offset};
 	add_code(tctx, buf, 2);
-	add_code(tctx, &offset, sizeof(offset));
 }
 
-static inline void jge_relative_i32(struct thread_context *tctx, s32 offset) {
-	const u8 buf[] = {0x0F, 0x8D};
+static inline void jcc_relative_i32(struct thread_context *tctx, enum x64_condition cc, s32 offset) {
+	const u8 buf[] = {0x0F, 0x80 | cc};
 	add_code(tctx, buf, 2);
 	add_code(tctx, &offset, sizeof(offset));
 }
 
-static inline void jle_relative_i32(struct thread_context *tctx, s32 offset) {
-	const u8 buf[] = {0x0F, 0x8E};
-	add_code(tctx, buf, 2);
+static inline void jmp_relative_i32(struct thread_context *tctx, s32 offset) {
+	const u8 buf[] = {0xE9};
+	add_code(tctx, buf, 1);
 	add_code(tctx, &offset, sizeof(offset));
 }
 
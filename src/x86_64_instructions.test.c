@@ -23,6 +23,13 @@ enum x64_register get_temporary_register(struct thread_context *tctx, const enum
 	return RAX;
 }
 
+void record_store(struct thread_context *tctx, u8 base, s32 offset, u8 r, usize size) {
+}
+
+bool forward_stored_value(struct thread_context *tctx, u8 r, u8 base, s32 offset, usize size) {
+	return false;
+}
+
 static void test(struct thread_context *tctx, const char *instr, u8 expected[], u32 expected_num) {
 	u32  l              = (u32)arrlenu(tctx->code);
 	bool print_encoding = false;
@@ -135,9 +142,14 @@ int main(s32 argc, char *argv[]) {
 	TEST(mov_mi_indirect(&t, 0, 0xFF, 8), 0x48, 0xC7, 0x05, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00);
 	// TEST(mov_mi_indirect(&t, 0, 0xFFFFFFFF, 8), 0x48, 0xC7, 0x05, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00);
 
-	TEST(mov_ri(&t, RAX, 0xFF, 8), 0x48, 0xC7, 0xC0, 0xFF, 0x00, 0x00, 0x00);
-	TEST(mov_ri(&t, R8, 0xFF, 8), 0x49, 0xC7, 0xC0, 0xFF, 0x00, 0x00, 0x00);
-	TEST(mov_ri(&t, RAX, 0xFFFFFFFF, 8), 0x48, 0xB8, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00);
+	TEST(mov_ri(&t, RAX, 0xFF, 8), 0xB8, 0xFF, 0x00, 0x00, 0x00);
+	TEST(mov_ri(&t, R8, 0xFF, 8), 0x41, 0xB8, 0xFF, 0x00, 0x00, 0x00);
+	TEST(mov_ri(&t, RAX, 0xFFFFFFFF, 8), 0xB8, 0xFF, 0xFF, 0xFF, 0xFF);
+	TEST(mov_ri(&t, RAX, 0x100000000, 8), 0x48, 0xB8, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00);
+	TEST(mov_ri(&t, RAX, 0x7FFFFFFFFFFFFFFF, 8), 0x48, 0xB8, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x7F);
+	TEST(mov_ri(&t, RAX, (u64)-1, 8), 0x48, 0xC7, 0xC0, 0xFF, 0xFF, 0xFF, 0xFF);
+	TEST(mov_ri(&t, R8, (u64)INT32_MIN, 8), 0x49, 0xC7, 0xC0, 0x00, 0x00, 0x00, 0x80);
+	TEST(mov_ri(&t, RAX, (u64)INT32_MIN - 1, 8), 0x48, 0xB8, 0xFF, 0xFF, 0xFF, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF);
 	TEST(mov_ri(&t, RAX, 0xFF, 4), 0xB8, 0xFF, 0x00, 0x00, 0x00);
 	TEST(mov_ri(&t, RAX, 0xFF, 2), 0x66, 0xB8, 0xFF, 0x00);
 	TEST(mov_ri(&t, RDX, 0xFF, 4), 0xBA, 0xFF, 0x00, 0x00, 0x00);
@@ -232,7 +244,7 @@ int main(s32 argc, char *argv[]) {
 	TEST(movsx_rr(&t, R8, R9, 8, 4), 0x4D, 0x63, 0xC1);
 	TEST(movsx_rr(&t, RAX, RAX, 4, 1), 0x0F, 0xBE, 0xC0);
 	TEST(movsx_rr(&t, R8, RAX, 4, 1), 0x44, 0x0F, 0xBE, 0xC0);
-	TEST(movsx_rr(&t, RAX, R8, 4, 1), 0x0F, 0xBE, 0xC0); // ambiguous operand size!
+	TEST(movsx_rr(&t, RAX, R8, 4, 1), 0x41, 0x0F, 0xBE, 0xC0);
 
 	TEST(movsx_rm(&t, RAX, RBP, 0xFF, 8, 4), 0x48, 0x63, 0x85, 0xFF, 0x00, 0x00, 0x00);
 	TEST(movsx_rm(&t, R8, RBP, 0xFF, 8, 4), 0x4C, 0x63, 0x85, 0xFF, 0x00, 0x00, 0x00);
@@ -257,5 +269,11 @@ int main(s32 argc, char *argv[]) {
 	TEST(call_r(&t, RAX), 0xFF, 0xD0);
 	TEST(call_r(&t, R8), 0x41, 0xFF, 0xD0);
 
+	TEST(jcc_relative_i8(&t, CC_E, -2), 0x74, 0xFE);
+	TEST(jcc_relative_i8(&t, CC_L, 0x10), 0x7C, 0x10);
+	TEST(jcc_relative_i32(&t, CC_E, 0), 0x0F, 0x84, 0x00, 0x00, 0x00, 0x00);
+	TEST(jcc_relative_i32(&t, CC_NE, 0x100), 0x0F, 0x85, 0x00, 0x01, 0x00, 0x00);
+	TEST(jcc_relative_i32(&t, CC_G, -1), 0x0F, 0x8F, 0xFF, 0xFF, 0xFF, 0xFF);
+
 	return 0;
 }
\ No newline at end of file
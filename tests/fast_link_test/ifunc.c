@@ -0,0 +1,10 @@
+// Indirect function (STT_GNU_IFUNC) rejected by the built-in linker.
+static int get_answer_impl(void) {
+	return 42;
+}
+
+static int (*resolve_get_answer(void))(void) {
+	return get_answer_impl;
+}
+
+int get_answer(void) __attribute__((ifunc("resolve_get_answer")));
@@ -0,0 +1,6 @@
+// Shared library imported by the test executable.
+#define EXPORT __attribute__((visibility("default")))
+
+EXPORT int lib_apply(int (*fn)(int), int v) {
+	return fn(v);
+}